@@ -0,0 +1,306 @@
+#include "Benchmark.h"
+
+#include "JobSystem.h"
+#include "Kinematics.h"
+#include "Log.h"
+#include "Simulation.h"
+#include "SpatialHash.h"
+#include "Transform2D.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+
+
+namespace {
+
+	using Clock = std::chrono::steady_clock;
+
+	double millisecondsSince(Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// Uniformly scattered entities in the [-1, 1] play area
+	std::vector<glm::vec2> randomPositions(size_t count, unsigned int seed) {
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+
+		std::vector<glm::vec2> positions(count);
+		for (glm::vec2& p : positions) {
+			p = glm::vec2(coord(rng), coord(rng));
+		}
+		return positions;
+	}
+
+	// Bodies like the diamonds: inside the play area, unit length directions
+	BouncingBodies randomBodies(size_t count, unsigned int seed) {
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> angle(-glm::pi<float>(), glm::pi<float>());
+
+		BouncingBodies bodies;
+		bodies.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			float a = angle(rng);
+			bodies.positionX[i] = coord(rng);
+			bodies.positionY[i] = coord(rng);
+			bodies.directionX[i] = std::cos(a);
+			bodies.directionY[i] = std::sin(a);
+		}
+		return bodies;
+	}
+
+	float maxDifference(const std::vector<float>& a, const std::vector<float>& b) {
+		float difference = 0.0f;
+		for (size_t i = 0; i < a.size(); i++) {
+			difference = std::max(difference, std::abs(a[i] - b[i]));
+		}
+		return difference;
+	}
+
+}
+
+
+bool Benchmark::run(const std::string& name) {
+	if (name == "spatial") {
+		spatialHash();
+	}
+	else if (name == "transforms") {
+		transforms();
+	}
+	else if (name == "kinematics") {
+		kinematics();
+	}
+	else if (name == "jobs") {
+		jobs();
+	}
+	else {
+		Log::error("BENCHMARK unknown benchmark '{}'", name);
+		return false;
+	}
+	return true;
+}
+
+
+void Benchmark::spatialHash() {
+	Log::info("BENCHMARK spatial hash vs brute force");
+
+	for (size_t count : { 1000u, 10000u, 100000u }) {
+		std::vector<glm::vec2> positions = randomPositions(count, 453);
+
+		// Shrink the collision radius as the crowd grows so every entity has
+		// about four neighbours on average, like a busy game would
+		const float radius = std::sqrt(4.0f * 4.0f / (glm::pi<float>() * count));
+
+		// Spatial hash: rebuild and find all pairs, as a game tick would
+		SpatialHash grid(radius);
+		std::vector<std::pair<int, int>> pairs;
+		pairs.reserve(count * 4);
+
+		Clock::time_point start = Clock::now();
+		grid.build(positions);
+		double buildMs = millisecondsSince(start);
+		grid.overlappingPairs(radius, pairs);
+		double hashMs = millisecondsSince(start);
+
+		// Brute force: every pair, every tick
+		const float radiusSquared = radius * radius;
+		size_t bruteForcePairs = 0;
+
+		start = Clock::now();
+		for (size_t i = 0; i < count; i++) {
+			for (size_t j = i + 1; j < count; j++) {
+				glm::vec2 d = positions[j] - positions[i];
+				if (glm::dot(d, d) <= radiusSquared) {
+					bruteForcePairs++;
+				}
+			}
+		}
+		double bruteForceMs = millisecondsSince(start);
+
+		Log::info(
+			"{:>7} entities: hash {:9.3f} ms (build {:7.3f} ms), brute force {:10.3f} ms, speedup {:8.1f}x, pairs {} / {}{}",
+			count, hashMs, buildMs, bruteForceMs, bruteForceMs / hashMs,
+			pairs.size(), bruteForcePairs,
+			pairs.size() == bruteForcePairs ? "" : "  MISMATCH"
+		);
+	}
+}
+
+
+void Benchmark::transforms() {
+	Log::info("BENCHMARK Transform2D instance packing vs glm::mat4 composition");
+
+	const size_t count = 100000;
+	const int repeats = 20;
+
+	std::mt19937 rng(453);
+	std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> angle(-glm::pi<float>(), glm::pi<float>());
+	std::uniform_real_distribution<float> size(0.05f, 0.3f);
+
+	std::vector<Transform2D> transforms(count);
+	for (Transform2D& t : transforms) {
+		t = Transform2D::fromAngle(glm::vec2(coord(rng), coord(rng)), angle(rng), glm::vec2(size(rng), size(rng)));
+	}
+
+	// The old path: rotation angle from atan2, then translate * rotate * scale
+	std::vector<glm::mat4> matrices(count);
+	Clock::time_point start = Clock::now();
+	for (int r = 0; r < repeats; r++) {
+		for (size_t i = 0; i < count; i++) {
+			matrices[i] = transforms[i].toMat4();
+		}
+	}
+	double matrixMs = millisecondsSince(start) / repeats;
+
+	std::vector<AffineInstance> instances(count);
+	start = Clock::now();
+	for (int r = 0; r < repeats; r++) {
+		packInstances(transforms.data(), count, instances.data());
+	}
+	double packMs = millisecondsSince(start) / repeats;
+
+	// Both should put a corner of the quad in the same place
+	float maxError = 0.0f;
+	for (size_t i = 0; i < count; i++) {
+		glm::vec2 corner(1.0f, -1.0f);
+		glm::vec2 expected = glm::vec2(matrices[i] * glm::vec4(corner, 0.0f, 1.0f));
+		glm::mat2 linear(instances[i].linear.x, instances[i].linear.y, instances[i].linear.z, instances[i].linear.w);
+		glm::vec2 actual = linear * corner + instances[i].translation;
+		maxError = std::max(maxError, glm::length(actual - expected));
+	}
+
+	Log::info(
+		"{} transforms: mat4 {:.3f} ms ({} bytes each), packed {:.3f} ms ({} bytes each), speedup {:.1f}x, max error {:.2e}",
+		count, matrixMs, sizeof(glm::mat4), packMs, sizeof(AffineInstance), matrixMs / packMs, maxError
+	);
+}
+
+
+void Benchmark::kinematics() {
+	Log::info("BENCHMARK bouncing body kinematics, best path in this build is {}", Kinematics::pathName(Kinematics::bestPath()));
+
+	// Correctness first: long enough for every body to bounce many times.
+	// An odd count makes sure the scalar tail after the SIMD loop is covered.
+	const size_t checkCount = 10007;
+	const int checkSteps = 5000;
+	const float speed = 0.01f;
+
+	BouncingBodies reference = randomBodies(checkCount, 453);
+	for (int step = 0; step < checkSteps; step++) {
+		Kinematics::stepBouncing(reference, speed, 0, checkCount, Kinematics::Path::Scalar);
+	}
+
+	for (Kinematics::Path path : Kinematics::availablePaths()) {
+		BouncingBodies bodies = randomBodies(checkCount, 453);
+		for (int step = 0; step < checkSteps; step++) {
+			Kinematics::stepBouncing(bodies, speed, 0, checkCount, path);
+		}
+		float positionError = std::max(maxDifference(bodies.positionX, reference.positionX), maxDifference(bodies.positionY, reference.positionY));
+		float directionError = std::max(maxDifference(bodies.directionX, reference.directionX), maxDifference(bodies.directionY, reference.directionY));
+		Log::info(
+			"{:>8} after {} steps: max position difference {:.2e}, max direction difference {:.2e}",
+			Kinematics::pathName(path), checkSteps, positionError, directionError
+		);
+	}
+
+	// Then throughput, from cache resident up to main memory bound
+	for (size_t count : { 1000u, 100000u, 10000000u }) {
+		const size_t totalUpdates = 200000000;
+		const int steps = static_cast<int>(std::max<size_t>(1, totalUpdates / count));
+
+		for (Kinematics::Path path : Kinematics::availablePaths()) {
+			BouncingBodies bodies = randomBodies(count, 453);
+
+			Clock::time_point start = Clock::now();
+			for (int step = 0; step < steps; step++) {
+				Kinematics::stepBouncing(bodies, speed, 0, count, path);
+			}
+			double seconds = millisecondsSince(start) / 1000.0;
+
+			Log::info(
+				"{:>9} bodies {:>8}: {:8.1f} M entities/s",
+				count, Kinematics::pathName(path), count * steps / seconds / 1.0e6
+			);
+		}
+	}
+}
+
+
+void Benchmark::jobs() {
+	const unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	Log::info("BENCHMARK job system, {} hardware threads", hardwareThreads);
+
+	std::vector<unsigned> threadCounts;
+	for (unsigned threads = 1; threads < hardwareThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(hardwareThreads);
+
+	// Flying through the crowd so there are catches to agree on
+	PlayerInput input;
+	input.startGame = true;
+	input.isMovingForward = true;
+	input.cursorPosition = glm::vec2(0.6f, -0.4f);
+
+	for (size_t count : { 10000u, 100000u, 1000000u }) {
+		const size_t totalUpdates = 20000000;
+		const int ticks = static_cast<int>(std::max<size_t>(20, totalUpdates / count));
+		const int fills = ticks;
+
+		// Without jobs, as the reference every thread count has to match
+		Simulation reference(static_cast<int>(count), 453);
+		Clock::time_point start = Clock::now();
+		for (int tick = 0; tick < ticks; tick++) {
+			reference.step(input);
+		}
+		const double serialMs = millisecondsSince(start) / ticks;
+		const uint64_t expectedHash = hashGameState(reference.getState());
+		Log::info("{:>8} entities without jobs: tick {:8.3f} ms", count, serialMs);
+
+		double oneThreadTickMs = 0.0;
+		double oneThreadFillMs = 0.0;
+		for (unsigned threads : threadCounts) {
+			JobSystem jobs(threads - 1);
+			Simulation simulation(static_cast<int>(count), 453, &jobs);
+
+			start = Clock::now();
+			for (int tick = 0; tick < ticks; tick++) {
+				simulation.step(input);
+			}
+			const double tickMs = millisecondsSince(start) / ticks;
+
+			// Instance buffer fill, as the render loop does it
+			const GameState& previous = simulation.getPreviousState();
+			const GameState& current = simulation.getState();
+			std::vector<AffineInstance> instances(count);
+			const size_t grainSize = std::max<size_t>(jobs.grainSizeFor(count), 1024);
+
+			start = Clock::now();
+			for (int fill = 0; fill < fills; fill++) {
+				jobs.wait(jobs.parallelFor(0, count, grainSize, [&](size_t begin, size_t end) {
+					packDiamondInstances(previous, current, 0.5f, begin, end, instances.data());
+				}));
+			}
+			const double fillMs = millisecondsSince(start) / fills;
+
+			if (threads == 1) {
+				oneThreadTickMs = tickMs;
+				oneThreadFillMs = fillMs;
+			}
+
+			Log::info(
+				"{:>8} entities {:>3} threads: tick {:8.3f} ms, speedup {:5.2f}x, instance fill {:8.3f} ms, speedup {:5.2f}x, score {}{}",
+				count, threads, tickMs, oneThreadTickMs / tickMs, fillMs, oneThreadFillMs / fillMs, current.score,
+				hashGameState(current) == expectedHash ? "" : "  MISMATCH"
+			);
+		}
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Headless micro-benchmarks for the game logic.
+//
+// These never open a window, so they can be run on machines without a GPU:
+//
+// Example: 453-skeleton --bench=spatial
+//------------------------------------------------------------------------------
+
+#include <string>
+
+
+namespace Benchmark {
+
+	// Runs the benchmark with the given name. Returns false if there is no such benchmark
+	bool run(const std::string& name);
+
+	// Spatial hash broad phase against brute force all-pairs checks
+	void spatialHash();
+
+	// Packing Transform2Ds into instance data against composing glm::mat4s
+	void transforms();
+
+	// Bouncing body kinematics on every SIMD path against the scalar path
+	void kinematics();
+
+	// Simulation ticks and instance packing on the job system, across thread counts
+	void jobs();
+
+}
@@ -0,0 +1,124 @@
+#include "GameObject.h"
+
+#include <cmath>
+
+
+void PlayerInput::merge(const PlayerInput& newer) {
+	cursorPosition = newer.cursorPosition;
+	startGame = newer.startGame;
+	resetFlag = resetFlag || newer.resetFlag;
+
+	// The most recent key press wins, just like in the key callback
+	if (newer.isMovingForward || newer.isMovingBackward) {
+		isMovingForward = newer.isMovingForward;
+		isMovingBackward = newer.isMovingBackward;
+	}
+}
+
+
+void PlayerInput::clearEvents() {
+	isMovingForward = false;
+	isMovingBackward = false;
+	resetFlag = false;
+}
+
+
+GameObject::GameObject(float objectWidth, float objectHeight) :
+	appear(true),
+	position(glm::vec2(0.0f, 0.0f)),
+	direction(glm::vec2(0.0f, 0.0f)),
+	rotation(glm::vec2(1.0f, 0.0f)),
+	scale(glm::vec2(objectWidth, objectHeight))
+{}
+
+
+void GameObject::resizeShip(int score) {
+	scale = glm::vec2(DEFAULT_SHIP_WIDTH + (0.05f * score), DEFAULT_SHIP_HEIGHT + (0.05f * score));
+}
+
+
+void GameObject::updateShip(PlayerInput input) {
+	// Check for reset flag
+	if (input.resetFlag == true) {
+		position = glm::vec2(0.0f, 0.0f);
+		direction = glm::vec2(0.0f, 1.0f);
+		scale = glm::vec2(DEFAULT_SHIP_WIDTH, DEFAULT_SHIP_HEIGHT);
+		rotation = glm::vec2(1.0f, 0.0f);
+		return;
+	}
+
+	// Calculate direction vector and normalize
+	glm::vec2 directionToCursor = input.cursorPosition - position;
+	float distanceToCursor = glm::length(directionToCursor);
+
+	// Face the cursor. The ship texture points up, so rotate the direction to
+	// the cursor back a quarter turn: (cos(a - 90), sin(a - 90)) = (sin a, -cos a)
+	if (distanceToCursor > 0.0f) {
+		rotation = glm::vec2(directionToCursor.y, -directionToCursor.x) / distanceToCursor;
+	}
+
+	// Check if the ship is far enough from the cursor
+	const float proximityThreshold = 0.15f;
+	if (distanceToCursor < proximityThreshold) {
+		input.isMovingForward = false;
+	}
+
+	// Calculate new direction vector
+	glm::vec2 newDirection = glm::normalize(directionToCursor);
+
+	// Translate if moving forward or backward
+	glm::vec2 translation(0.0f);
+	if (input.isMovingForward && !input.isMovingBackward) {
+		translation = newDirection * 0.02f;
+	}
+	else if (!input.isMovingForward && input.isMovingBackward) {
+		translation = -newDirection * 0.02f;
+	}
+
+	// Calculate new position
+	glm::vec2 newPosition = position + translation;
+
+	// Check if new position is within bounds
+	if (newPosition.x >= -1.0f + (DEFAULT_SHIP_WIDTH / 2) && newPosition.x <= 1.0f - (DEFAULT_SHIP_WIDTH / 2) &&
+		newPosition.y >= -1.0f + (DEFAULT_SHIP_HEIGHT / 2) && newPosition.y <= 1.0f - (DEFAULT_SHIP_HEIGHT / 2)) {
+		// If new position is within bounds, apply the translation
+		position = newPosition;
+	}
+}
+
+
+Transform2D interpolateTransform(const GameObject& previous, const GameObject& current, float alpha) {
+	Transform2D transform = current.getTransform();
+	transform.position = glm::mix(previous.position, current.position, alpha);
+	return transform;
+}
+
+
+void initializeDiamond(BouncingBodies& diamonds, size_t i, Random& rng) {
+	// Generate a random position within the window bounds
+	diamonds.positionX[i] = rng.nextFloat() - 0.5f;  // Random X position
+	diamonds.positionY[i] = rng.nextFloat() - 0.5f;  // Random Y position
+
+	// Generate a random direction vector in the range of [-1, 1]
+	glm::vec2 direction = glm::vec2(
+		(rng.nextFloat() * 2.0f) - 1.0f, // Random X direction between -1 and 1
+		(rng.nextFloat() * 2.0f) - 1.0f  // Random Y direction between -1 and 1
+	);
+
+	// Normalize the direction vector to maintain consistent speed
+	direction = glm::normalize(direction);
+	diamonds.directionX[i] = direction.x;
+	diamonds.directionY[i] = direction.y;
+}
+
+
+Transform2D interpolateDiamond(const BouncingBodies& previous, const BouncingBodies& current, size_t i, float alpha) {
+	Transform2D transform;
+	transform.position = glm::mix(
+		glm::vec2(previous.positionX[i], previous.positionY[i]),
+		glm::vec2(current.positionX[i], current.positionY[i]),
+		alpha
+	);
+	transform.scale = glm::vec2(DEFAULT_DIAMOND_WIDTH, DEFAULT_DIAMOND_HEIGHT);
+	return transform;
+}
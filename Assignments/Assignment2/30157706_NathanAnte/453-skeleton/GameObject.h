@@ -0,0 +1,75 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Game logic for the ship and diamonds.
+//
+// Nothing in here touches OpenGL, so game objects can be copied around freely
+// and updated off the render thread. Textures and geometry live in Sprite.
+//
+// There can be a lot of diamonds, so rather than a GameObject each they are
+// kept as BouncingBodies and moved in SIMD batches, see Kinematics.h
+//------------------------------------------------------------------------------
+
+#include "Kinematics.h"
+#include "Random.h"
+#include "Transform2D.h"
+
+#include <glm/glm.hpp>
+
+#define DEFAULT_SHIP_WIDTH 0.12f
+#define DEFAULT_SHIP_HEIGHT 0.08f
+
+#define DEFAULT_DIAMOND_WIDTH 0.10f
+#define DEFAULT_DIAMOND_HEIGHT 0.10f
+#define DIAMOND_SPEED 0.003f
+
+
+// Player Input Struct
+struct PlayerInput {
+	glm::vec2 cursorPosition = glm::vec2(0.0f, 1.0f);
+	bool startGame = false;
+	bool resetFlag = false;
+	bool isMovingForward = false;
+	bool isMovingBackward = false;
+
+	// Folds newer input into this one without losing one-shot events,
+	// for when several frames of input arrive before the next tick
+	void merge(const PlayerInput& newer);
+
+	// Clears the one-shot events once a tick has consumed them
+	void clearEvents();
+};
+
+
+// An example struct for Game Objects.
+// You are encouraged to customize this as you see fit.
+struct GameObject {
+	// Sets default position, rotation and scale
+	GameObject(float objectWidth, float objectHeight);
+
+	Transform2D getTransform() const { return Transform2D{ position, rotation, scale }; }
+
+	void resizeShip(int score);
+	void updateShip(PlayerInput input);
+
+	bool appear;
+
+	glm::vec2 position;
+	glm::vec2 direction;
+
+	glm::vec2 rotation;   // (cos theta, sin theta), see Transform2D
+	glm::vec2 scale;
+};
+
+
+// Transform at a fraction alpha of the way from previous to current,
+// used to render between two fixed simulation ticks. Only the position is
+// blended; rotation and scale are taken from the current state.
+Transform2D interpolateTransform(const GameObject& previous, const GameObject& current, float alpha);
+
+
+// Places diamond i at a random position, heading in a random direction
+void initializeDiamond(BouncingBodies& diamonds, size_t i, Random& rng);
+
+// Transform to draw diamond i with, blended between two ticks like interpolateTransform
+Transform2D interpolateDiamond(const BouncingBodies& previous, const BouncingBodies& current, size_t i, float alpha);
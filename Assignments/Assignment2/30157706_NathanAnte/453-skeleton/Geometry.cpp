@@ -1,5 +1,8 @@
 #include "Geometry.h"
 
+#include "RenderStats.h"
+
+#include <cstddef>
 #include <utility>
 
 
@@ -7,7 +10,18 @@ GPU_Geometry::GPU_Geometry()
 	: vao()
 	, vertBuffer(0, 3, GL_FLOAT)
 	, texCoordBuffer(1, 2, GL_FLOAT)
-{}
+	, instanceBuffer()
+{
+	// Attribute 2 is the linear part and 3 the translation of each instance's
+	// 2D affine transform. A divisor of 1 advances them once per instance.
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(AffineInstance), (void*)offsetof(AffineInstance, linear));
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(AffineInstance), (void*)offsetof(AffineInstance, translation));
+	glEnableVertexAttribArray(2);
+	glEnableVertexAttribArray(3);
+	glVertexAttribDivisor(2, 1);
+	glVertexAttribDivisor(3, 1);
+}
 
 
 void GPU_Geometry::setVerts(const std::vector<glm::vec3>& verts) {
@@ -18,3 +32,11 @@ void GPU_Geometry::setVerts(const std::vector<glm::vec3>& verts) {
 void GPU_Geometry::setTexCoords(const std::vector<glm::vec2>& texCoords) {
 	texCoordBuffer.uploadData(sizeof(glm::vec2) * texCoords.size(), texCoords.data(), GL_STATIC_DRAW);
 }
+
+
+void GPU_Geometry::setInstances(const std::vector<AffineInstance>& instances) {
+	// Rewritten every frame, so orphan the old storage rather than waiting on the GPU
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(AffineInstance) * instances.size(), instances.data(), GL_STREAM_DRAW);
+	RenderStats::countUpload(sizeof(AffineInstance) * instances.size());
+}
@@ -6,6 +6,7 @@
 // similar classes with the needed functionality
 //------------------------------------------------------------------------------
 
+#include "Transform2D.h"
 #include "VertexArray.h"
 #include "VertexBuffer.h"
 
@@ -22,7 +23,8 @@ struct CPU_Geometry {
 };
 
 
-// VAO and two VBOs for storing vertices and texture coordinates, respectively
+// VAO and two VBOs for storing vertices and texture coordinates, respectively,
+// plus a per-instance VBO of AffineInstances for instanced drawing
 class GPU_Geometry {
 
 public:
@@ -33,6 +35,7 @@ public:
 
 	void setVerts(const std::vector<glm::vec3>& verts);
 	void setTexCoords(const std::vector<glm::vec2>& texCoords);
+	void setInstances(const std::vector<AffineInstance>& instances);
 
 private:
 	// note: due to how OpenGL works, vao needs to be 
@@ -41,4 +44,7 @@ private:
 
 	VertexBuffer vertBuffer;
 	VertexBuffer texCoordBuffer;
+
+	// Two interleaved attributes, so it doesn't fit the one attribute VertexBuffer
+	VertexBufferHandle instanceBuffer;
 };
@@ -0,0 +1,167 @@
+#include "GpuKinematics.h"
+
+#include "GameObject.h"
+#include "Log.h"
+#include "Random.h"
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+
+GpuKinematics::GpuKinematics()
+	: program("shaders/kinematics.vert", "shaders/kinematics.frag", { "nextState" })
+	, speedLocation(glGetUniformLocation(program.getProgram(), "speed"))
+	, current(0)
+	, count(0)
+{
+	for (int i = 0; i < 2; i++) {
+		arrays[i].bind();
+		glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(0);
+	}
+	glBindVertexArray(0);
+}
+
+
+void GpuKinematics::upload(const BouncingBodies& bodies) {
+	count = bodies.size();
+
+	std::vector<float> state(4 * count);
+	for (size_t i = 0; i < count; i++) {
+		state[4 * i + 0] = bodies.positionX[i];
+		state[4 * i + 1] = bodies.positionY[i];
+		state[4 * i + 2] = bodies.directionX[i];
+		state[4 * i + 3] = bodies.directionY[i];
+	}
+
+	// Both halves of the pair start out the same, so the previous tick is
+	// sensible too. GL_DYNAMIC_COPY: written and read by the GPU every tick.
+	for (int i = 0; i < 2; i++) {
+		glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+		glBufferData(GL_ARRAY_BUFFER, state.size() * sizeof(float), state.data(), GL_DYNAMIC_COPY);
+		RenderStats::countUpload(state.size() * sizeof(float));
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+void GpuKinematics::step(float speed) {
+	if (count == 0) {
+		return;
+	}
+	const size_t next = 1 - current;
+
+	// Only the captured vertex outputs matter, nothing is drawn
+	glEnable(GL_RASTERIZER_DISCARD);
+	program.use();
+	glUniform1f(speedLocation, speed);
+
+	arrays[current].bind();
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[next]);
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(count));
+	RenderStats::countDrawCall();
+	glEndTransformFeedback();
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glBindVertexArray(0);
+
+	glDisable(GL_RASTERIZER_DISCARD);
+	current = next;
+}
+
+
+void GpuKinematics::download(BouncingBodies& bodies) const {
+	std::vector<float> state(4 * count);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[current]);
+	glGetBufferSubData(GL_ARRAY_BUFFER, 0, state.size() * sizeof(float), state.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	bodies.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		bodies.positionX[i] = state[4 * i + 0];
+		bodies.positionY[i] = state[4 * i + 1];
+		bodies.directionX[i] = state[4 * i + 2];
+		bodies.directionY[i] = state[4 * i + 3];
+	}
+}
+
+
+bool GpuKinematics::compare(size_t count, int ticks, uint64_t seed) {
+	using Clock = std::chrono::steady_clock;
+
+	Log::info(
+		"GPU_KINEMATICS comparing {} bodies over {} ticks, {} path on the CPU against {}",
+		count, ticks, Kinematics::pathName(Kinematics::bestPath()), reinterpret_cast<const char*>(glGetString(GL_RENDERER))
+	);
+
+	Random rng(seed);
+	BouncingBodies cpu;
+	cpu.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		initializeDiamond(cpu, i, rng);
+	}
+
+	GpuKinematics gpu;
+	gpu.upload(cpu);
+	BouncingBodies fromGpu;
+
+	// Rounding differences stay around 1e-7. A body that bounced on a
+	// different tick is off by about twice its speed from then on.
+	const float divergedThreshold = 1e-4f;
+	const int checkInterval = std::max(1, ticks / 10);
+
+	double cpuSeconds = 0.0;
+	double gpuSeconds = 0.0;
+	bool matched = true;
+
+	for (int tick = 1; tick <= ticks; tick++) {
+		Clock::time_point start = Clock::now();
+		Kinematics::stepBouncing(cpu, DIAMOND_SPEED, 0, count);
+		cpuSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+		start = Clock::now();
+		gpu.step(DIAMOND_SPEED);
+		glFinish();
+		gpuSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+		if (tick % checkInterval != 0 && tick != ticks) {
+			continue;
+		}
+
+		gpu.download(fromGpu);
+		size_t identical = 0;
+		size_t diverged = 0;
+		float maxDifference = 0.0f;
+		for (size_t i = 0; i < count; i++) {
+			float difference = std::max(std::abs(cpu.positionX[i] - fromGpu.positionX[i]), std::abs(cpu.positionY[i] - fromGpu.positionY[i]));
+			bool sameDirection = cpu.directionX[i] == fromGpu.directionX[i] && cpu.directionY[i] == fromGpu.directionY[i];
+
+			maxDifference = std::max(maxDifference, difference);
+			if (difference == 0.0f && sameDirection) {
+				identical++;
+			}
+			if (difference > divergedThreshold || !sameDirection) {
+				diverged++;
+			}
+		}
+
+		Log::info(
+			"GPU_KINEMATICS tick {:>6}: {} of {} bodies bit-identical, max position difference {:.2e}, {} diverged",
+			tick, identical, count, maxDifference, diverged
+		);
+		matched = matched && diverged == 0;
+	}
+
+	Log::info(
+		"GPU_KINEMATICS CPU {:.3f} ms per tick, GPU {:.3f} ms per tick",
+		cpuSeconds * 1000.0 / ticks, gpuSeconds * 1000.0 / ticks
+	);
+	if (!matched) {
+		Log::error("GPU_KINEMATICS GPU results diverged from the CPU");
+	}
+	return matched;
+}
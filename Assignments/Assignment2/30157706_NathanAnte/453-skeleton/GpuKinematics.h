@@ -0,0 +1,67 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Bouncing body kinematics on the GPU, using transform feedback.
+//
+// The state of every body (position and direction) lives in a GPU buffer as
+// one vec4 per body. Each tick, shaders/kinematics.vert reads one buffer as
+// points and writes the advanced state into the other, then the two swap.
+// Once uploaded, the CPU never touches per-body state again unless it asks
+// for it with download().
+//
+// The maths is the same as Kinematics::stepBouncing, so the two can be run
+// side by side and checked against each other, see compare().
+//
+// Example: GpuKinematics gpu;
+//          gpu.upload(bodies);
+//          gpu.step(DIAMOND_SPEED);
+//          gpu.download(bodies);
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "Kinematics.h"
+#include "ShaderProgram.h"
+#include "VertexArray.h"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+
+
+class GpuKinematics {
+
+public:
+	// Needs a current OpenGL context
+	GpuKinematics();
+
+	// Replaces the state on the GPU with bodies
+	void upload(const BouncingBodies& bodies);
+
+	// Advances every body by one tick
+	void step(float speed);
+
+	// Copies the current state back into bodies. Slow, mostly for checking
+	void download(BouncingBodies& bodies) const;
+
+	size_t size() const { return count; }
+
+	// The buffers holding this tick and the last, one vec4 (position.xy,
+	// direction.xy) per body, e.g. for drawing the bodies without a round trip
+	GLuint getCurrentBuffer() const { return buffers[current]; }
+	GLuint getPreviousBuffer() const { return buffers[1 - current]; }
+
+	// Runs count bodies for ticks ticks on the CPU and the GPU from the same
+	// start, checking that they agree along the way. Needs a current context.
+	static bool compare(size_t count, int ticks, uint64_t seed);
+
+private:
+	ShaderProgram program;
+	GLint speedLocation;
+
+	// Ping-pong pair: arrays[i] reads its state from buffers[i]
+	VertexArray arrays[2];
+	VertexBufferHandle buffers[2];
+	size_t current;
+	size_t count;
+};
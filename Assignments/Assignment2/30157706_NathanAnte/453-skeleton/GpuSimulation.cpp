@@ -0,0 +1,250 @@
+#include "GpuSimulation.h"
+
+#include "Log.h"
+#include "RenderStats.h"
+#include "Replay.h"
+#include "Simulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+GpuSimulation::GpuSimulation(int diamondCount, uint64_t seed, const CPU_Geometry& quad)
+	: diamondCount(diamondCount)
+	, rng(seed)
+	, recorder(nullptr)
+	, score(0)
+	, tick(0)
+	, kinematics()
+	, appearBuffer()
+	, catchProgram("shaders/catch.vert", "shaders/catch.geom", "shaders/kinematics.frag", { "caughtIndex" })
+	, shipPositionLocation(glGetUniformLocation(catchProgram.getProgram(), "shipPosition"))
+	, radiusSquaredLocation(glGetUniformLocation(catchProgram.getProgram(), "radiusSquared"))
+	, catchArray()
+	, caughtBuffer()
+	, caughtQuery()
+	, drawProgram("shaders/diamond.vert", "shaders/test.frag")
+	, alphaLocation(glGetUniformLocation(drawProgram.getProgram(), "alpha"))
+	, sizeLocation(glGetUniformLocation(drawProgram.getProgram(), "size"))
+	, drawArray()
+	, quadVerts(0, 3, GL_FLOAT)
+	, quadTexCoords(1, 2, GL_FLOAT)
+	, quadVertexCount(static_cast<GLsizei>(quad.verts.size()))
+{
+	// drawArray is still bound from constructing the quad buffers. Attributes
+	// 2 and 3 are pointed at this tick's and the last tick's state buffers
+	// when drawing, since those swap every tick.
+	quadVerts.uploadData(sizeof(glm::vec3) * quad.verts.size(), quad.verts.data(), GL_STATIC_DRAW);
+	quadTexCoords.uploadData(sizeof(glm::vec2) * quad.texCoords.size(), quad.texCoords.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, appearBuffer);
+	glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, 0, (void*)0);
+	glEnableVertexAttribArray(2);
+	glEnableVertexAttribArray(3);
+	glEnableVertexAttribArray(4);
+	glVertexAttribDivisor(2, 1);
+	glVertexAttribDivisor(3, 1);
+	glVertexAttribDivisor(4, 1);
+
+	catchArray.bind();
+	glBindBuffer(GL_ARRAY_BUFFER, appearBuffer);
+	glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 0, (void*)0);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glBindVertexArray(0);
+
+	// Room for every diamond to be caught at once, read back by the CPU
+	glBindBuffer(GL_ARRAY_BUFFER, caughtBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLint) * this->diamondCount, nullptr, GL_STREAM_READ);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	spawnDiamonds();
+}
+
+
+void GpuSimulation::step(const PlayerInput& input) {
+	if (recorder != nullptr) {
+		recorder->record(input);
+	}
+
+	previousShip = ship;
+	tick++;
+
+	// Reset Score and diamonds. Both state buffers get the new diamonds, so
+	// they jump to their new spots instead of streaking across the screen.
+	if (input.resetFlag) {
+		score = 0;
+		spawnDiamonds();
+	}
+
+	// Catches use the ship and diamonds from before they move, like Simulation.
+	// Only the caught diamonds' flags are written, a few floats at most.
+	if (input.startGame) {
+		findCaught();
+
+		const float gone = 0.0f;
+		glBindBuffer(GL_ARRAY_BUFFER, appearBuffer);
+		for (GLint i : caught) {
+			score++;
+			ship.resizeShip(score);
+			glBufferSubData(GL_ARRAY_BUFFER, sizeof(float) * i, sizeof(float), &gone);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		RenderStats::countUpload(sizeof(float) * caught.size());
+	}
+
+	kinematics.step(DIAMOND_SPEED);
+	ship.updateShip(input);
+}
+
+
+void GpuSimulation::drawDiamonds(float alpha) {
+	if (diamondCount == 0) {
+		return;
+	}
+
+	drawProgram.use();
+	glUniform1f(alphaLocation, alpha);
+	glUniform2f(sizeLocation, DEFAULT_DIAMOND_WIDTH, DEFAULT_DIAMOND_HEIGHT);
+
+	drawArray.bind();
+	glBindBuffer(GL_ARRAY_BUFFER, kinematics.getPreviousBuffer());
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+	glBindBuffer(GL_ARRAY_BUFFER, kinematics.getCurrentBuffer());
+	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glDrawArraysInstanced(GL_TRIANGLES, 0, quadVertexCount, static_cast<GLsizei>(diamondCount));
+	RenderStats::countDrawCall();
+	glBindVertexArray(0);
+}
+
+
+void GpuSimulation::download(BouncingBodies& diamonds, std::vector<uint8_t>& diamondAppear) const {
+	kinematics.download(diamonds);
+
+	std::vector<float> appear(diamondCount);
+	glBindBuffer(GL_ARRAY_BUFFER, appearBuffer);
+	glGetBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * appear.size(), appear.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	diamondAppear.resize(diamondCount);
+	for (size_t i = 0; i < diamondCount; i++) {
+		diamondAppear[i] = appear[i] != 0.0f ? 1 : 0;
+	}
+}
+
+
+void GpuSimulation::spawnDiamonds() {
+	// Same random numbers in the same order as Simulation, so the same seed
+	// gives the same diamonds
+	spawned.resize(diamondCount);
+	for (size_t i = 0; i < diamondCount; i++) {
+		initializeDiamond(spawned, i, rng);
+	}
+	kinematics.upload(spawned);
+
+	const std::vector<float> appear(diamondCount, 1.0f);
+	glBindBuffer(GL_ARRAY_BUFFER, appearBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * appear.size(), appear.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	RenderStats::countUpload(sizeof(float) * appear.size());
+}
+
+
+void GpuSimulation::findCaught() {
+	caught.clear();
+	if (diamondCount == 0) {
+		return;
+	}
+
+	// Only the captured indices matter, nothing is drawn
+	glEnable(GL_RASTERIZER_DISCARD);
+	catchProgram.use();
+	glUniform2f(shipPositionLocation, ship.position.x, ship.position.y);
+	glUniform1f(radiusSquaredLocation, CATCH_RADIUS * CATCH_RADIUS);
+
+	catchArray.bind();
+	glBindBuffer(GL_ARRAY_BUFFER, kinematics.getCurrentBuffer());
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, caughtBuffer);
+	glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, caughtQuery);
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(diamondCount));
+	RenderStats::countDrawCall();
+	glEndTransformFeedback();
+	glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glBindVertexArray(0);
+	glDisable(GL_RASTERIZER_DISCARD);
+
+	// Waits for the pass, but the score has to be known before the next tick
+	GLuint caughtCount = 0;
+	glGetQueryObjectuiv(caughtQuery, GL_QUERY_RESULT, &caughtCount);
+	if (caughtCount == 0) {
+		return;
+	}
+	caught.resize(caughtCount);
+	glBindBuffer(GL_ARRAY_BUFFER, caughtBuffer);
+	glGetBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(GLint) * caught.size(), caught.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+bool GpuSimulation::compare(int diamondCount, int ticks, uint64_t seed) {
+	Log::info("GPU_SIMULATION playing {} diamonds for {} ticks with Simulation and GpuSimulation", diamondCount, ticks);
+
+	Simulation cpu(diamondCount, seed);
+	GpuSimulation gpu(diamondCount, seed, CPU_Geometry());
+
+	BouncingBodies fromGpu;
+	std::vector<uint8_t> appearFromGpu;
+	const int checkInterval = std::max(1, ticks / 10);
+	bool matched = true;
+
+	for (int tick = 1; tick <= ticks; tick++) {
+		// The ship chases a cursor going round in a circle, so it sweeps
+		// through plenty of diamonds, and the game resets half way
+		PlayerInput input;
+		const float angle = 0.01f * tick;
+		input.startGame = true;
+		input.isMovingForward = true;
+		input.cursorPosition = 0.6f * glm::vec2(std::cos(angle), std::sin(angle));
+		input.resetFlag = tick == ticks / 2;
+
+		cpu.step(input);
+		gpu.step(input);
+
+		const GameState& state = cpu.getState();
+		if (state.score != gpu.getScore() || state.ship.position != gpu.getShip().position) {
+			Log::error(
+				"GPU_SIMULATION tick {}: score {} on the CPU and {} on the GPU, ship {} the same",
+				tick, state.score, gpu.getScore(), state.ship.position == gpu.getShip().position ? "still" : "not"
+			);
+			matched = false;
+			break;
+		}
+
+		if (tick % checkInterval != 0 && tick != ticks) {
+			continue;
+		}
+
+		gpu.download(fromGpu, appearFromGpu);
+		const bool sameDiamonds =
+			state.diamonds.positionX == fromGpu.positionX && state.diamonds.positionY == fromGpu.positionY &&
+			state.diamonds.directionX == fromGpu.directionX && state.diamonds.directionY == fromGpu.directionY &&
+			state.diamondAppear == appearFromGpu;
+
+		Log::info(
+			"GPU_SIMULATION tick {:>6}: score {}, diamonds {}",
+			tick, state.score, sameDiamonds ? "bit-identical" : "differ"
+		);
+		matched = matched && sameDiamonds;
+	}
+
+	if (!matched) {
+		Log::error("GPU_SIMULATION the GPU game diverged from the CPU");
+	}
+	return matched;
+}
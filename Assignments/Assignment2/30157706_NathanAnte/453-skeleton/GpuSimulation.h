@@ -0,0 +1,109 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// The game from Simulation, with the diamonds kept on the GPU.
+//
+// Diamond state lives in GpuKinematics' ping-pong buffers plus one appear
+// flag per diamond, and is advanced there every tick. The CPU only writes it
+// at the start and on reset. Each tick:
+//
+//   catch pass: shaders/catch.vert + catch.geom test every diamond against
+//               the ship and capture the indices of the caught ones only
+//   read back:  the number caught (a query) and those indices, nothing else
+//   step:       GpuKinematics::step moves every diamond
+//
+// drawDiamonds() draws straight from the state buffers, so positions never
+// make the round trip to the CPU. The ship is one object and stays on the CPU.
+//
+// Plays the same game as Simulation for the same seed and input, which
+// compare() checks. Needs a current OpenGL context, so it can't run on
+// SimulationThread.
+//
+// Example: GpuSimulation simulation(diamondCount, seed, diamondSprite.cgeom);
+//          simulation.step(input);
+//          simulation.drawDiamonds(timestep.alpha());
+//------------------------------------------------------------------------------
+
+#include "GameObject.h"
+#include "Geometry.h"
+#include "GLHandles.h"
+#include "GpuKinematics.h"
+#include "Random.h"
+#include "ShaderProgram.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+
+class InputRecorder;
+
+
+class GpuSimulation {
+
+public:
+	// quad is the sprite geometry every diamond is drawn with
+	GpuSimulation(int diamondCount, uint64_t seed, const CPU_Geometry& quad);
+
+	// Advance the game by exactly one tick
+	void step(const PlayerInput& input);
+
+	// Optionally capture the input of every tick from now on, for replaying later
+	void setRecorder(InputRecorder* recorder_) { recorder = recorder_; }
+
+	// Draws every diamond still in play, blended between the last two ticks.
+	// Binds its own program; the caller binds the diamond texture.
+	void drawDiamonds(float alpha);
+
+	const GameObject& getShip() const { return ship; }
+	const GameObject& getPreviousShip() const { return previousShip; }
+	int getScore() const { return score; }
+	uint64_t getTick() const { return tick; }
+
+	// Copies the diamonds back to the CPU. Slow, for checking only
+	void download(BouncingBodies& diamonds, std::vector<uint8_t>& diamondAppear) const;
+
+	// Plays the same scripted game for ticks ticks with Simulation and with
+	// this, and checks the scores and diamonds agree. Needs a current context.
+	static bool compare(int diamondCount, int ticks, uint64_t seed);
+
+private:
+	size_t diamondCount;
+	Random rng;
+	InputRecorder* recorder;
+
+	GameObject previousShip{ DEFAULT_SHIP_WIDTH, DEFAULT_SHIP_HEIGHT };
+	GameObject ship{ DEFAULT_SHIP_WIDTH, DEFAULT_SHIP_HEIGHT };
+	int score;
+	uint64_t tick;
+
+	GpuKinematics kinematics;
+	VertexBufferHandle appearBuffer;		// one float per diamond, 1 in play and 0 caught
+
+	// Catch pass: state and appear in, caught indices out
+	ShaderProgram catchProgram;
+	GLint shipPositionLocation;
+	GLint radiusSquaredLocation;
+	VertexArray catchArray;
+	VertexBufferHandle caughtBuffer;
+	QueryHandle caughtQuery;
+	std::vector<GLint> caught;
+
+	// Drawing: the quad per vertex, the two ticks and appear per instance
+	ShaderProgram drawProgram;
+	GLint alphaLocation;
+	GLint sizeLocation;
+	VertexArray drawArray;
+	VertexBuffer quadVerts;
+	VertexBuffer quadTexCoords;
+	GLsizei quadVertexCount;
+
+	// Scratch for new diamonds, only used at the start and on reset
+	BouncingBodies spawned;
+
+	void spawnDiamonds();
+	void findCaught();
+};
@@ -0,0 +1,211 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+
+struct JobSystem::Job {
+	Task task;
+
+	// Unfinished prerequisites, plus one until the job is submitted
+	std::atomic<int> remainingDependencies{ 1 };
+	std::atomic<bool> finished{ false };
+
+	// Jobs waiting on this one, released when it finishes
+	std::mutex mutex;
+	std::vector<JobHandle> dependents;
+};
+
+
+namespace {
+	// Which pool the current thread works for, and which queue is its own
+	thread_local const JobSystem* currentSystem = nullptr;
+	thread_local size_t currentQueue = 0;
+}
+
+
+JobSystem::JobSystem(unsigned workerCount)
+	: running(true)
+	, queuedJobs(0)
+{
+	for (unsigned i = 0; i < workerCount + 1; i++) {
+		queues.push_back(std::make_unique<WorkQueue>());
+	}
+	for (unsigned i = 0; i < workerCount; i++) {
+		workers.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+}
+
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		running = false;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+
+JobHandle JobSystem::create(Task task) {
+	JobHandle job = std::make_shared<Job>();
+	job->task = std::move(task);
+	return job;
+}
+
+
+void JobSystem::addDependency(const JobHandle& job, const JobHandle& prerequisite) {
+	if (prerequisite == nullptr) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(prerequisite->mutex);
+	if (!prerequisite->finished) {
+		job->remainingDependencies++;
+		prerequisite->dependents.push_back(job);
+	}
+}
+
+
+void JobSystem::submit(const JobHandle& job) {
+	if (--job->remainingDependencies == 0) {
+		enqueue(job);
+	}
+}
+
+
+JobHandle JobSystem::run(Task task, std::initializer_list<JobHandle> dependsOn) {
+	JobHandle job = create(std::move(task));
+	for (const JobHandle& prerequisite : dependsOn) {
+		addDependency(job, prerequisite);
+	}
+	submit(job);
+	return job;
+}
+
+
+JobHandle JobSystem::parallelFor(size_t begin, size_t end, size_t grainSize, RangeTask task, std::initializer_list<JobHandle> dependsOn) {
+	// Every chunk shares the one copy of task
+	std::shared_ptr<RangeTask> shared = std::make_shared<RangeTask>(std::move(task));
+	grainSize = std::max<size_t>(grainSize, 1);
+
+	JobHandle done = create([] {});
+	for (const JobHandle& prerequisite : dependsOn) {
+		addDependency(done, prerequisite);
+	}
+
+	for (size_t chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize) {
+		size_t chunkEnd = std::min(end, chunkBegin + grainSize);
+		JobHandle chunk = create([shared, chunkBegin, chunkEnd] { (*shared)(chunkBegin, chunkEnd); });
+		for (const JobHandle& prerequisite : dependsOn) {
+			addDependency(chunk, prerequisite);
+		}
+		addDependency(done, chunk);
+		submit(chunk);
+	}
+
+	submit(done);
+	return done;
+}
+
+
+size_t JobSystem::grainSizeFor(size_t count) const {
+	const size_t chunksPerThread = 4;
+	return std::max<size_t>(1, count / (getThreadCount() * chunksPerThread));
+}
+
+
+void JobSystem::wait(const JobHandle& job) {
+	const size_t queue = ownQueue();
+	while (!job->finished.load(std::memory_order_acquire)) {
+		JobHandle next = dequeue(queue);
+		if (next != nullptr) {
+			execute(next);
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+
+size_t JobSystem::ownQueue() const {
+	// Threads outside the pool all share the last queue
+	return currentSystem == this ? currentQueue : queues.size() - 1;
+}
+
+
+void JobSystem::enqueue(const JobHandle& job) {
+	WorkQueue& queue = *queues[ownQueue()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		queuedJobs++;
+	}
+	wake.notify_one();
+}
+
+
+JobHandle JobSystem::dequeue(size_t preferredQueue) {
+	JobHandle job;
+
+	// Newest job from our own queue first
+	{
+		WorkQueue& own = *queues[preferredQueue];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty()) {
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+		}
+	}
+
+	// Otherwise steal the oldest job from someone else
+	for (size_t i = 1; job == nullptr && i < queues.size(); i++) {
+		WorkQueue& victim = *queues[(preferredQueue + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty()) {
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+		}
+	}
+
+	if (job != nullptr) {
+		queuedJobs--;
+	}
+	return job;
+}
+
+
+void JobSystem::execute(const JobHandle& job) {
+	job->task();
+
+	std::vector<JobHandle> released;
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		job->finished.store(true, std::memory_order_release);
+		released.swap(job->dependents);
+	}
+	for (const JobHandle& dependent : released) {
+		submit(dependent);
+	}
+}
+
+
+void JobSystem::workerLoop(size_t index) {
+	currentSystem = this;
+	currentQueue = index;
+
+	while (running) {
+		JobHandle job = dequeue(index);
+		if (job != nullptr) {
+			execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wake.wait(lock, [this] { return queuedJobs > 0 || !running; });
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A small work-stealing job system.
+//
+// A fixed pool of worker threads each own a queue of jobs. Workers take new
+// work from the back of their own queue (most recently pushed, so likely still
+// in cache) and, when that runs dry, steal from the front of someone else's.
+// A thread waiting on a job doesn't sit idle either: it runs jobs until the
+// one it is waiting on has finished.
+//
+// Jobs can depend on other jobs. A job is only queued once it has been
+// submitted and everything it depends on has finished, so a frame can be
+// described as a graph up front and then left to run.
+//
+// Example: JobHandle update = jobs.parallelFor(0, count, 1024, updateRange);
+//          JobHandle fill = jobs.parallelFor(0, count, 1024, fillRange, { update });
+//          jobs.wait(fill);
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class JobSystem {
+
+public:
+	struct Job;
+	using JobHandle = std::shared_ptr<Job>;
+	using Task = std::function<void()>;
+	using RangeTask = std::function<void(size_t begin, size_t end)>;
+
+	// workerCount background threads. The thread calling wait() works too,
+	// so up to workerCount + 1 jobs run at once. Zero workers runs every job
+	// on the waiting thread, which is handy for comparing against.
+	explicit JobSystem(unsigned workerCount);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+	// Creates a job that runs task once it is submitted and all its
+	// dependencies have finished. Add dependencies before submitting.
+	JobHandle create(Task task);
+	void addDependency(const JobHandle& job, const JobHandle& prerequisite);
+	void submit(const JobHandle& job);
+
+	// create, addDependency and submit in one go
+	JobHandle run(Task task, std::initializer_list<JobHandle> dependsOn = {});
+
+	// Splits [begin, end) into chunks of at most grainSize and runs task on
+	// each chunk in parallel. The returned job finishes when all chunks have.
+	JobHandle parallelFor(size_t begin, size_t end, size_t grainSize, RangeTask task, std::initializer_list<JobHandle> dependsOn = {});
+
+	// A grain size that gives every thread a few chunks to balance with
+	size_t grainSizeFor(size_t count) const;
+
+	// Runs jobs on this thread until job has finished
+	void wait(const JobHandle& job);
+
+private:
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<JobHandle> jobs;
+	};
+
+	// One queue per worker, plus one shared by every thread outside the pool
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	std::vector<std::thread> workers;
+
+	std::atomic<bool> running;
+	std::atomic<int> queuedJobs;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+
+	size_t ownQueue() const;
+	void enqueue(const JobHandle& job);
+	JobHandle dequeue(size_t preferredQueue);
+	void execute(const JobHandle& job);
+	void workerLoop(size_t index);
+};
+
+using JobHandle = JobSystem::JobHandle;
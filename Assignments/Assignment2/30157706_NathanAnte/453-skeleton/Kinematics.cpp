@@ -0,0 +1,209 @@
+#include "Kinematics.h"
+
+#include <cmath>
+
+#if defined(KINEMATICS_HAS_AVX) || defined(KINEMATICS_HAS_AVX512) || defined(KINEMATICS_USE_FMA)
+#include <immintrin.h>
+#elif defined(KINEMATICS_HAS_SSE)
+#include <emmintrin.h>
+#endif
+
+
+void BouncingBodies::resize(size_t count) {
+	positionX.resize(count);
+	positionY.resize(count);
+	directionX.resize(count);
+	directionY.resize(count);
+}
+
+
+namespace {
+
+	// position + direction * speed, fused or not the same way in every path
+	inline float advance(float position, float direction, float speed) {
+#ifdef KINEMATICS_USE_FMA
+		return std::fma(direction, speed, position);
+#else
+		return position + direction * speed;
+#endif
+	}
+
+	// The reference implementation. Also finishes off whatever is left over
+	// after the SIMD loops run out of full registers.
+	void stepScalar(float* px, float* py, float* dx, float* dy, float speed, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			px[i] = advance(px[i], dx[i], speed);
+			py[i] = advance(py[i], dy[i], speed);
+
+			if (px[i] <= -1.0f || px[i] >= 1.0f) {
+				dx[i] = -dx[i];
+			}
+			if (py[i] <= -1.0f || py[i] >= 1.0f) {
+				dy[i] = -dy[i];
+			}
+		}
+	}
+
+#ifdef KINEMATICS_HAS_SSE
+	// One axis of 4 bodies: integrate, then flip the sign bit of the
+	// direction in every lane that is out of bounds
+	inline void stepAxisSSE(float* p, float* d, __m128 speed, size_t i) {
+		const __m128 lower = _mm_set1_ps(-1.0f);
+		const __m128 upper = _mm_set1_ps(1.0f);
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+
+#ifdef KINEMATICS_USE_FMA
+		__m128 position = _mm_fmadd_ps(_mm_loadu_ps(d + i), speed, _mm_loadu_ps(p + i));
+#else
+		__m128 position = _mm_add_ps(_mm_loadu_ps(p + i), _mm_mul_ps(_mm_loadu_ps(d + i), speed));
+#endif
+		__m128 outside = _mm_or_ps(_mm_cmple_ps(position, lower), _mm_cmpge_ps(position, upper));
+		__m128 direction = _mm_xor_ps(_mm_loadu_ps(d + i), _mm_and_ps(outside, signBit));
+
+		_mm_storeu_ps(p + i, position);
+		_mm_storeu_ps(d + i, direction);
+	}
+
+	size_t stepSSE(float* px, float* py, float* dx, float* dy, float speed, size_t begin, size_t end) {
+		const __m128 s = _mm_set1_ps(speed);
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4) {
+			stepAxisSSE(px, dx, s, i);
+			stepAxisSSE(py, dy, s, i);
+		}
+		return i;
+	}
+#endif
+
+#ifdef KINEMATICS_HAS_AVX
+	inline void stepAxisAVX(float* p, float* d, __m256 speed, size_t i) {
+		const __m256 lower = _mm256_set1_ps(-1.0f);
+		const __m256 upper = _mm256_set1_ps(1.0f);
+		const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+#ifdef KINEMATICS_USE_FMA
+		__m256 position = _mm256_fmadd_ps(_mm256_loadu_ps(d + i), speed, _mm256_loadu_ps(p + i));
+#else
+		__m256 position = _mm256_add_ps(_mm256_loadu_ps(p + i), _mm256_mul_ps(_mm256_loadu_ps(d + i), speed));
+#endif
+		__m256 outside = _mm256_or_ps(_mm256_cmp_ps(position, lower, _CMP_LE_OQ), _mm256_cmp_ps(position, upper, _CMP_GE_OQ));
+		__m256 direction = _mm256_xor_ps(_mm256_loadu_ps(d + i), _mm256_and_ps(outside, signBit));
+
+		_mm256_storeu_ps(p + i, position);
+		_mm256_storeu_ps(d + i, direction);
+	}
+
+	size_t stepAVX(float* px, float* py, float* dx, float* dy, float speed, size_t begin, size_t end) {
+		const __m256 s = _mm256_set1_ps(speed);
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8) {
+			stepAxisAVX(px, dx, s, i);
+			stepAxisAVX(py, dy, s, i);
+		}
+		return i;
+	}
+#endif
+
+#ifdef KINEMATICS_HAS_AVX512
+	inline void stepAxisAVX512(float* p, float* d, __m512 speed, size_t i) {
+		const __m512 lower = _mm512_set1_ps(-1.0f);
+		const __m512 upper = _mm512_set1_ps(1.0f);
+		const __m512i signBit = _mm512_set1_epi32(static_cast<int>(0x80000000));
+
+#ifdef KINEMATICS_USE_FMA
+		__m512 position = _mm512_fmadd_ps(_mm512_loadu_ps(d + i), speed, _mm512_loadu_ps(p + i));
+#else
+		__m512 position = _mm512_add_ps(_mm512_loadu_ps(p + i), _mm512_mul_ps(_mm512_loadu_ps(d + i), speed));
+#endif
+		__mmask16 outside = _mm512_cmp_ps_mask(position, lower, _CMP_LE_OQ) | _mm512_cmp_ps_mask(position, upper, _CMP_GE_OQ);
+		__m512i direction = _mm512_castps_si512(_mm512_loadu_ps(d + i));
+		direction = _mm512_mask_xor_epi32(direction, outside, direction, signBit);
+
+		_mm512_storeu_ps(p + i, position);
+		_mm512_storeu_ps(d + i, _mm512_castsi512_ps(direction));
+	}
+
+	size_t stepAVX512(float* px, float* py, float* dx, float* dy, float speed, size_t begin, size_t end) {
+		const __m512 s = _mm512_set1_ps(speed);
+		size_t i = begin;
+		for (; i + 16 <= end; i += 16) {
+			stepAxisAVX512(px, dx, s, i);
+			stepAxisAVX512(py, dy, s, i);
+		}
+		return i;
+	}
+#endif
+
+}
+
+
+Kinematics::Path Kinematics::bestPath() {
+#if defined(KINEMATICS_HAS_AVX512)
+	return Path::AVX512;
+#elif defined(KINEMATICS_HAS_AVX)
+	return Path::AVX;
+#elif defined(KINEMATICS_HAS_SSE)
+	return Path::SSE;
+#else
+	return Path::Scalar;
+#endif
+}
+
+
+const char* Kinematics::pathName(Path path) {
+	switch (path) {
+	case Path::SSE:
+		return "SSE";
+	case Path::AVX:
+		return "AVX";
+	case Path::AVX512:
+		return "AVX-512";
+	default:
+		return "scalar";
+	}
+}
+
+
+std::vector<Kinematics::Path> Kinematics::availablePaths() {
+	std::vector<Path> paths = { Path::Scalar };
+#ifdef KINEMATICS_HAS_SSE
+	paths.push_back(Path::SSE);
+#endif
+#ifdef KINEMATICS_HAS_AVX
+	paths.push_back(Path::AVX);
+#endif
+#ifdef KINEMATICS_HAS_AVX512
+	paths.push_back(Path::AVX512);
+#endif
+	return paths;
+}
+
+
+void Kinematics::stepBouncing(BouncingBodies& bodies, float speed, size_t begin, size_t end, Path path) {
+	float* px = bodies.positionX.data();
+	float* py = bodies.positionY.data();
+	float* dx = bodies.directionX.data();
+	float* dy = bodies.directionY.data();
+
+	size_t i = begin;
+	switch (path) {
+#ifdef KINEMATICS_HAS_AVX512
+	case Path::AVX512:
+		i = stepAVX512(px, py, dx, dy, speed, i, end);
+		break;
+#endif
+#ifdef KINEMATICS_HAS_AVX
+	case Path::AVX:
+		i = stepAVX(px, py, dx, dy, speed, i, end);
+		break;
+#endif
+#ifdef KINEMATICS_HAS_SSE
+	case Path::SSE:
+		i = stepSSE(px, py, dx, dy, speed, i, end);
+		break;
+#endif
+	default:
+		break;
+	}
+	stepScalar(px, py, dx, dy, speed, i, end);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Batch kinematics for bodies that bounce around inside the [-1, 1] box.
+//
+// Bodies are stored as a structure of arrays, one array per component, so a
+// single SIMD instruction can move 4 (SSE), 8 (AVX) or 16 (AVX-512) bodies at
+// once. Which paths exist depends on the instruction sets the compiler was
+// allowed to use, see ENABLE_AVX2 and ENABLE_AVX512 in CMakeLists.txt. The
+// scalar path is always available and is the reference the others must match.
+//
+// Tolerance: zero. Every path does exactly the same single precision
+// operations in the same order, so results are bit-identical to the scalar
+// path. This matters more than it looks: a one ulp difference can decide
+// whether a body bounces this step or the next, after which the two runs
+// drift apart for good. So when FMA is available, every path uses it
+// explicitly, rather than leaving the compiler free to fuse some multiply-adds
+// and not others. The benchmark checks this after thousands of bounces.
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <vector>
+
+#if defined(__AVX512F__)
+#define KINEMATICS_HAS_AVX512
+#endif
+#if defined(__AVX__)
+#define KINEMATICS_HAS_AVX
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KINEMATICS_HAS_SSE
+#endif
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define KINEMATICS_USE_FMA
+#endif
+
+
+struct BouncingBodies {
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> directionX;
+	std::vector<float> directionY;
+
+	size_t size() const { return positionX.size(); }
+	void resize(size_t count);
+};
+
+
+namespace Kinematics {
+
+	enum class Path { Scalar, SSE, AVX, AVX512 };
+
+	// Widest path compiled into this build
+	Path bestPath();
+	const char* pathName(Path path);
+
+	// Every path compiled into this build, narrowest first
+	std::vector<Path> availablePaths();
+
+	// Moves bodies [begin, end) by speed along their direction, and reflects the
+	// direction on any axis where a body has reached the edge of the box.
+	// Same as GameObject::updateDiamond used to do, one body at a time.
+	void stepBouncing(BouncingBodies& bodies, float speed, size_t begin, size_t end, Path path = bestPath());
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A small seedable random number generator (PCG32, https://www.pcg-random.org/)
+//
+// Unlike std::rand or the std::<random> distributions, the sequence it
+// produces is fully specified, so a given seed gives the same game on every
+// platform and compiler. That is what makes input replays reproducible.
+//------------------------------------------------------------------------------
+
+#include <cstdint>
+
+
+class Random {
+
+public:
+	explicit Random(uint64_t seed = 0)
+		: state(0)
+		, increment((seed << 1u) | 1u)
+	{
+		next();
+		state += seed;
+		next();
+	}
+
+	// Uniform in [0, 2^32)
+	uint32_t next() {
+		uint64_t old = state;
+		state = old * 6364136223846793005ull + increment;
+		uint32_t xorShifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+		uint32_t rotation = static_cast<uint32_t>(old >> 59u);
+		return (xorShifted >> rotation) | (xorShifted << ((32u - rotation) & 31u));
+	}
+
+	// Uniform in [0, 1), using the top 24 bits so every value is exact in a float
+	float nextFloat() {
+		return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+	}
+
+private:
+	uint64_t state;
+	uint64_t increment;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Always-on render statistics.
+//
+// The engine classes bump these counters as they go: VertexBuffer::uploadData
+// counts the bytes it sends to the GPU, Texture counts the bytes it keeps
+// resident, ShaderProgram counts recompiles, and draw calls are counted where
+// they are issued. Each count is one relaxed atomic add, cheap enough to leave
+// on all the time.
+//
+// Once a frame, a RenderStats::Recorder turns the running totals into numbers
+// for that frame, keeps a short history for the overlay (see StatsOverlay.h)
+// and can append every frame to a CSV file.
+//
+// Example: RenderStats::Recorder stats;
+//          stats.beginFrame();
+//          ... draw ...
+//          stats.endFrame();
+//------------------------------------------------------------------------------
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+namespace RenderStats {
+
+	void countDrawCall();
+	void countUpload(size_t bytes);
+	void countShaderRecompile();
+
+	// Bytes of texture memory owned by one texture. Moves along with its
+	// texture and uncounts itself when destroyed, so textures can keep the
+	// rule of zero and still be tracked.
+	class TextureBytes {
+
+	public:
+		TextureBytes();
+		explicit TextureBytes(size_t bytes);
+		~TextureBytes();
+
+		TextureBytes(const TextureBytes&) = delete;
+		TextureBytes& operator=(const TextureBytes&) = delete;
+
+		TextureBytes(TextureBytes&& other) noexcept;
+		TextureBytes& operator=(TextureBytes&& other) noexcept;
+
+		void set(size_t bytes);
+		size_t get() const { return bytes; }
+
+	private:
+		size_t bytes;
+	};
+
+
+	// Running totals since startup
+	struct Totals {
+		uint64_t drawCalls = 0;
+		uint64_t uploadBytes = 0;
+		uint64_t shaderRecompiles = 0;
+		uint64_t textureBytes = 0;
+	};
+
+	Totals totals();
+
+
+	// One frame's worth of statistics
+	struct Frame {
+		uint64_t index = 0;
+		float cpuMs = 0.0f;             // beginFrame() to endFrame()
+		float frameMs = 0.0f;           // endFrame() to endFrame(), including waiting on vsync
+		uint64_t drawCalls = 0;
+		uint64_t uploadBytes = 0;
+		uint64_t textureBytes = 0;      // resident at the end of the frame
+		uint64_t shaderRecompiles = 0;  // since startup
+	};
+
+
+	class Recorder {
+
+	public:
+		explicit Recorder(size_t historyLength = 240);
+
+		// Bracket the work of one frame, before swapping buffers
+		void beginFrame();
+		void endFrame();
+
+		// Writes a header now and one row per frame from then on
+		bool openCsv(const std::string& path);
+
+		const Frame& latest() const { return last; }
+
+		// CPU frame times in milliseconds as a ring buffer. Only the first
+		// getHistoryCount() entries have been recorded so far. Once they all
+		// have, the oldest is at getHistoryOffset(), which is how
+		// ImGui::PlotLines takes them; until then it is the first.
+		const std::vector<float>& getCpuHistory() const { return cpuHistory; }
+		size_t getHistoryOffset() const { return historyCount < cpuHistory.size() ? 0 : historyOffset; }
+		size_t getHistoryCount() const { return historyCount; }
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		Clock::time_point frameStart;
+		Clock::time_point previousFrameEnd;
+		Totals previousTotals;
+		Frame last;
+
+		std::vector<float> cpuHistory;
+		size_t historyOffset;
+		size_t historyCount;
+
+		std::ofstream csv;
+	};
+
+}
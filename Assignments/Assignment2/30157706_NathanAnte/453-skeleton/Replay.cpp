@@ -0,0 +1,138 @@
+#include "Replay.h"
+
+#include "Log.h"
+#include "Simulation.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#define RECORDING_MAGIC "453-replay"
+#define RECORDING_VERSION 1
+
+
+// The format is plain text, one tick per line, so recordings can be diffed
+// and hand edited. Floats are written with 9 significant digits, which is
+// enough to read back the exact same bits.
+bool Recording::save(const std::string& path) const {
+	std::ofstream file(path);
+	if (!file) {
+		Log::error("RECORDING could not open {} for writing", path);
+		return false;
+	}
+
+	file << fmt::format("{} {}\n", RECORDING_MAGIC, RECORDING_VERSION);
+	file << fmt::format("seed {} diamonds {} ticks {}\n", seed, diamondCount, inputs.size());
+	for (const PlayerInput& input : inputs) {
+		file << fmt::format(
+			"{:.9g} {:.9g} {:d} {:d} {:d} {:d}\n",
+			input.cursorPosition.x, input.cursorPosition.y,
+			input.startGame, input.resetFlag, input.isMovingForward, input.isMovingBackward
+		);
+	}
+	return static_cast<bool>(file);
+}
+
+
+bool Recording::load(const std::string& path) {
+	std::ifstream file(path);
+	if (!file) {
+		Log::error("RECORDING could not open {}", path);
+		return false;
+	}
+
+	std::string magic, seedLabel, diamondsLabel, ticksLabel;
+	int version = 0;
+	size_t tickCount = 0;
+	file >> magic >> version >> seedLabel >> seed >> diamondsLabel >> diamondCount >> ticksLabel >> tickCount;
+	if (!file || magic != RECORDING_MAGIC || version != RECORDING_VERSION) {
+		Log::error("RECORDING {} is not a version {} recording", path, RECORDING_VERSION);
+		return false;
+	}
+
+	inputs.clear();
+	inputs.reserve(tickCount);
+	for (size_t i = 0; i < tickCount; i++) {
+		PlayerInput input;
+		int startGame, resetFlag, isMovingForward, isMovingBackward;
+		file >> input.cursorPosition.x >> input.cursorPosition.y >> startGame >> resetFlag >> isMovingForward >> isMovingBackward;
+		if (!file) {
+			Log::error("RECORDING {} is truncated at tick {}", path, i);
+			return false;
+		}
+		input.startGame = startGame != 0;
+		input.resetFlag = resetFlag != 0;
+		input.isMovingForward = isMovingForward != 0;
+		input.isMovingBackward = isMovingBackward != 0;
+		inputs.push_back(input);
+	}
+	return true;
+}
+
+
+InputRecorder::InputRecorder(uint64_t seed, int diamondCount) {
+	recording.seed = seed;
+	recording.diamondCount = diamondCount;
+}
+
+
+bool Replay::run(const std::string& recordingPath, const std::string& hashPath, const std::string& expectPath) {
+	Recording recording;
+	if (!recording.load(recordingPath)) {
+		return false;
+	}
+
+	// Run the whole thing first, so that writing hashes out isn't part of the timing
+	Simulation simulation(recording.diamondCount, recording.seed);
+	std::vector<uint64_t> hashes(recording.inputs.size());
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < recording.inputs.size(); i++) {
+		simulation.step(recording.inputs[i]);
+		hashes[i] = hashGameState(simulation.getState());
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	Log::info(
+		"REPLAY {} ticks in {:.3f} ms, {:.0f} ticks/s, final score {}",
+		hashes.size(), seconds * 1000.0, hashes.size() / seconds, simulation.getState().score
+	);
+
+	// One "tick hash" line per tick
+	std::ofstream hashFile;
+	if (!hashPath.empty()) {
+		hashFile.open(hashPath);
+		if (!hashFile) {
+			Log::error("REPLAY could not open {} for writing", hashPath);
+			return false;
+		}
+	}
+	std::ostream& hashOut = hashPath.empty() ? std::cout : hashFile;
+	for (size_t i = 0; i < hashes.size(); i++) {
+		hashOut << fmt::format("{} {:016x}\n", i + 1, hashes[i]);
+	}
+
+	if (expectPath.empty()) {
+		return true;
+	}
+
+	std::ifstream expectFile(expectPath);
+	if (!expectFile) {
+		Log::error("REPLAY could not open {}", expectPath);
+		return false;
+	}
+	size_t tick;
+	std::string expected;
+	for (size_t i = 0; i < hashes.size(); i++) {
+		if (!(expectFile >> tick >> expected)) {
+			Log::error("REPLAY {} ends after {} ticks, replay has {}", expectPath, i, hashes.size());
+			return false;
+		}
+		if (expected != fmt::format("{:016x}", hashes[i])) {
+			Log::error("REPLAY diverged at tick {}: expected {}, got {:016x}", tick, expected, hashes[i]);
+			return false;
+		}
+	}
+	Log::info("REPLAY all {} ticks match {}", hashes.size(), expectPath);
+	return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Input recording and headless replay of the game simulation.
+//
+// A recording is the simulation seed plus the PlayerInput fed to every tick.
+// Since the simulation is deterministic, that is all that's needed to play
+// the exact same game back later, without a window, as fast as possible.
+//
+// Example: 453-skeleton --record=game.replay --seed=42
+//		  453-skeleton --replay=game.replay --hashes=game.hashes
+//		  453-skeleton --replay=game.replay --expect=game.hashes
+//------------------------------------------------------------------------------
+
+#include "GameObject.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+struct Recording {
+	uint64_t seed = 0;
+	int diamondCount = 0;
+	std::vector<PlayerInput> inputs;   // one per tick
+
+	bool save(const std::string& path) const;
+	bool load(const std::string& path);
+};
+
+
+// Collects the input of every tick while the game is played
+class InputRecorder {
+
+public:
+	InputRecorder(uint64_t seed, int diamondCount);
+
+	void record(const PlayerInput& input) { recording.inputs.push_back(input); }
+
+	const Recording& getRecording() const { return recording; }
+	bool save(const std::string& path) const { return recording.save(path); }
+
+private:
+	Recording recording;
+};
+
+
+namespace Replay {
+
+	// Replays a recording headless at maximum speed and reports ticks per second.
+	// The state hash of every tick is written to hashPath (stdout if empty), and
+	// if expectPath is given, compared against a previous run's hashes.
+	// Returns false if the recording can't be read or the hashes don't match.
+	bool run(const std::string& recordingPath, const std::string& hashPath, const std::string& expectPath);
+
+}
@@ -5,15 +5,44 @@
 #include <vector>
 
 #include "Log.h"
+#include "RenderStats.h"
 
 
 ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath)
+	: ShaderProgram(vertexPath, fragmentPath, {})
+{}
+
+
+ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath, const std::vector<std::string>& feedbackVaryings)
+	: ShaderProgram(vertexPath, "", fragmentPath, feedbackVaryings)
+{}
+
+
+// An empty geometryPath leaves the geometry stage out
+ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& geometryPath, const std::string& fragmentPath, const std::vector<std::string>& feedbackVaryings)
 	: programID()
 	, vertex(vertexPath, GL_VERTEX_SHADER)
 	, fragment(fragmentPath, GL_FRAGMENT_SHADER)
+	, feedbackVaryings(feedbackVaryings)
 {
+	if (!geometryPath.empty()) {
+		geometry.emplace(geometryPath, GL_GEOMETRY_SHADER);
+	}
+
 	attach(*this, vertex);
+	if (geometry) {
+		attach(*this, *geometry);
+	}
 	attach(*this, fragment);
+
+	// Has to be set before linking
+	if (!feedbackVaryings.empty()) {
+		std::vector<const GLchar*> names;
+		for (const std::string& name : feedbackVaryings) {
+			names.push_back(name.c_str());
+		}
+		glTransformFeedbackVaryings(programID, static_cast<GLsizei>(names.size()), names.data(), GL_INTERLEAVED_ATTRIBS);
+	}
 	glLinkProgram(programID);
 
 	if (!checkAndLogLinkSuccess()) {
@@ -26,8 +55,9 @@ bool ShaderProgram::recompile() {
 
 	try {
 		// Try to create a new program
-		ShaderProgram newProgram(vertex.getPath(), fragment.getPath());
+		ShaderProgram newProgram(vertex.getPath(), geometry ? geometry->getPath() : "", fragment.getPath(), feedbackVaryings);
 		*this = std::move(newProgram);
+		RenderStats::countShaderRecompile();
 		return true;
 	}
 	catch (std::runtime_error &e) {
@@ -53,15 +83,23 @@ bool ShaderProgram::checkAndLogLinkSuccess() const {
 		std::vector<char> log(logLength);
 		glGetProgramInfoLog(programID, logLength, NULL, log.data());
 
-		Log::error("SHADER_PROGRAM linking {} + {}:\n{}", vertex.getPath(), fragment.getPath(), log.data());
+		Log::error("SHADER_PROGRAM linking {}:\n{}", getPaths(), log.data());
 		return false;
 	}
 	else {
-		Log::info("SHADER_PROGRAM successfully compiled and linked {} + {}", vertex.getPath(), fragment.getPath());
+		Log::info("SHADER_PROGRAM successfully compiled and linked {}", getPaths());
 		return true;
 	}
 }
 
+std::string ShaderProgram::getPaths() const {
+	std::string paths = vertex.getPath();
+	if (geometry) {
+		paths += " + " + geometry->getPath();
+	}
+	return paths + " + " + fragment.getPath();
+}
+
 GLuint ShaderProgram::getProgram() {
 	return programID.value();
 }
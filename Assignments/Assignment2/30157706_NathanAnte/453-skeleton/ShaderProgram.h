@@ -6,7 +6,9 @@
 
 #include <glad/glad.h>
 
+#include <optional>
 #include <string>
+#include <vector>
 
 
 class ShaderProgram {
@@ -14,6 +16,13 @@ class ShaderProgram {
 public:
 	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
 
+	// For transform feedback: the named vertex shader outputs are captured,
+	// interleaved in the order given, into the bound feedback buffer
+	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath, const std::vector<std::string>& feedbackVaryings);
+
+	// Same, with a geometry shader in between whose outputs are captured instead
+	ShaderProgram(const std::string& vertexPath, const std::string& geometryPath, const std::string& fragmentPath, const std::vector<std::string>& feedbackVaryings);
+
 	// Because we're using the ShaderProgramHandle to do RAII for the shader for us
 	// and our other types are trivial or provide their own RAII
 	// we don't have to provide any specialized functions here. Rule of zero
@@ -33,7 +42,10 @@ private:
 	ShaderProgramHandle programID;
 
 	Shader vertex;
+	std::optional<Shader> geometry;
 	Shader fragment;
+	std::vector<std::string> feedbackVaryings;
 
 	bool checkAndLogLinkSuccess() const;
+	std::string getPaths() const;
 };
@@ -0,0 +1,278 @@
+#include "Simulation.h"
+
+#include "Replay.h"
+
+#include <algorithm>
+
+
+uint64_t hashGameState(const GameState& state) {
+	// FNV-1a over the raw bits, so even a one ulp drift shows up
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](const void* data, size_t size) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+	};
+	auto mixArray = [&mix](const auto& array) {
+		mix(array.data(), array.size() * sizeof(array[0]));
+	};
+
+	mix(&state.tick, sizeof(state.tick));
+	mix(&state.score, sizeof(state.score));
+
+	unsigned char appear = state.ship.appear ? 1 : 0;
+	mix(&appear, sizeof(appear));
+	mix(&state.ship.position, sizeof(state.ship.position));
+	mix(&state.ship.direction, sizeof(state.ship.direction));
+	mix(&state.ship.rotation, sizeof(state.ship.rotation));
+	mix(&state.ship.scale, sizeof(state.ship.scale));
+
+	mixArray(state.diamonds.positionX);
+	mixArray(state.diamonds.positionY);
+	mixArray(state.diamonds.directionX);
+	mixArray(state.diamonds.directionY);
+	mixArray(state.diamondAppear);
+	return hash;
+}
+
+
+void packDiamondInstances(const GameState& previous, const GameState& current, float alpha, size_t begin, size_t end, AffineInstance* out) {
+	// Small batches on the stack so packInstances still gets to use SIMD
+	const size_t batchSize = 64;
+	Transform2D batch[batchSize];
+
+	for (size_t batchBegin = begin; batchBegin < end; batchBegin += batchSize) {
+		const size_t count = std::min(batchSize, end - batchBegin);
+		for (size_t k = 0; k < count; k++) {
+			const size_t i = batchBegin + k;
+			batch[k] = interpolateDiamond(previous.diamonds, current.diamonds, i, alpha);
+			if (!current.diamondAppear[i]) {
+				batch[k].scale = glm::vec2(0.0f, 0.0f);
+			}
+		}
+		packInstances(batch, count, out + batchBegin);
+	}
+}
+
+
+Simulation::Simulation(int diamondCount, uint64_t seed, JobSystem* jobs)
+	: rng(seed)
+	, recorder(nullptr)
+	, jobs(jobs)
+{
+	current.diamonds.resize(diamondCount);
+	current.diamondAppear.assign(diamondCount, 1);
+	for (int i = 0; i < diamondCount; i++) {
+		initializeDiamond(current.diamonds, i, rng);
+	}
+	previous = current;
+}
+
+
+void Simulation::step(const PlayerInput& input) {
+	if (recorder != nullptr) {
+		recorder->record(input);
+	}
+
+	previous = current;
+	current.tick++;
+
+	// Reset Score and diamonds. Previous positions are reset too, so the
+	// diamonds jump to their new spots instead of streaking across the screen.
+	const size_t diamondCount = current.diamonds.size();
+	if (input.resetFlag) {
+		current.score = 0;
+		for (size_t i = 0; i < diamondCount; i++) {
+			initializeDiamond(current.diamonds, i, rng);
+		}
+		current.diamondAppear.assign(diamondCount, 1);
+		previous.diamonds = current.diamonds;
+	}
+
+	// Catches found this tick go through here, whichever way they were found
+	auto applyCatches = [this, &input](const std::vector<int>& caught) {
+		if (!input.startGame) {
+			return;
+		}
+		for (int i : caught) {
+			if (current.diamondAppear[i]) {
+				current.score++;
+				current.ship.resizeShip(current.score);
+				current.diamondAppear[i] = 0;
+			}
+		}
+	};
+
+	// Update diamond positions, all of them in SIMD batches. Caught diamonds
+	// keep moving but are never drawn or caught again, so it makes no
+	// difference to the game and keeps the kernel free of branches.
+	auto moveDiamonds = [this](size_t begin, size_t end) {
+		Kinematics::stepBouncing(current.diamonds, DIAMOND_SPEED, begin, end);
+	};
+
+	if (jobs == nullptr) {
+		// Broad phase: find every diamond close enough to the ship to be caught
+		diamondGrids.resize(1, SpatialHash(CATCH_RADIUS));
+		diamondGrids[0].build(current.diamonds.positionX, current.diamonds.positionY);
+
+		caughtDiamonds.assign(1, {});
+		diamondGrids[0].queryRadius(current.ship.position, CATCH_RADIUS, caughtDiamonds[0]);
+		applyCatches(caughtDiamonds[0]);
+
+		moveDiamonds(0, diamondCount);
+		current.ship.updateShip(input);
+		return;
+	}
+
+	// With jobs, the tick becomes
+	//
+	//   broad phase (per chunk) -> apply catches -> move ship
+	//   move diamonds (per chunk)
+	//
+	// The broad phase reads the diamond positions from previous, which are the
+	// same as current's at this point, so the diamonds can move on at the same
+	// time. Each chunk gets a grid of its own so no chunk waits on another.
+	// Each diamond is only a few instructions, so keep chunks big enough to be
+	// worth scheduling, and a multiple of the widest SIMD width.
+	const size_t minGrainSize = 4096;
+	size_t grainSize = std::max(jobs->grainSizeFor(diamondCount), minGrainSize);
+	grainSize = (grainSize + 15) & ~size_t(15);
+
+	const size_t chunkCount = std::max<size_t>(1, (diamondCount + grainSize - 1) / grainSize);
+	diamondGrids.resize(chunkCount, SpatialHash(CATCH_RADIUS));
+	caughtDiamonds.resize(chunkCount);
+
+	JobHandle broadPhase = jobs->parallelFor(0, diamondCount, grainSize, [this, grainSize](size_t begin, size_t end) {
+		const size_t chunk = begin / grainSize;
+		SpatialHash& grid = diamondGrids[chunk];
+		grid.build(previous.diamonds.positionX.data() + begin, previous.diamonds.positionY.data() + begin, end - begin);
+
+		std::vector<int>& caught = caughtDiamonds[chunk];
+		caught.clear();
+		grid.queryRadius(current.ship.position, CATCH_RADIUS, caught);
+		for (int& i : caught) {
+			i += static_cast<int>(begin);
+		}
+	});
+
+	JobHandle catches = jobs->run([this, &applyCatches] {
+		for (const std::vector<int>& caught : caughtDiamonds) {
+			applyCatches(caught);
+		}
+	}, { broadPhase });
+
+	// After the broad phase has used the old ship position
+	JobHandle ship = jobs->run([this, &input] { current.ship.updateShip(input); }, { catches });
+	JobHandle diamonds = jobs->parallelFor(0, diamondCount, grainSize, moveDiamonds);
+
+	jobs->wait(diamonds);
+	jobs->wait(ship);
+}
+
+
+FixedTimestep::FixedTimestep(double timestep)
+	: timestep(timestep)
+	, accumulator(0.0)
+{}
+
+
+int FixedTimestep::advance(double frameTime) {
+	const double maxFrameTime = 0.25;
+	accumulator += std::min(frameTime, maxFrameTime);
+
+	int ticks = 0;
+	while (accumulator >= timestep) {
+		accumulator -= timestep;
+		ticks++;
+	}
+	return ticks;
+}
+
+
+SimulationThread::SimulationThread(Simulation& simulation)
+	: simulation(simulation)
+	, running(false)
+{
+	// Make sure the reader has something sensible before the first tick lands
+	GameSnapshot& initial = snapshots.writeBuffer();
+	initial.previous = simulation.getPreviousState();
+	initial.current = simulation.getState();
+	initial.tickTime = std::chrono::steady_clock::now();
+	snapshots.publish();
+}
+
+
+SimulationThread::~SimulationThread() {
+	stop();
+}
+
+
+void SimulationThread::start() {
+	if (running) {
+		return;
+	}
+	running = true;
+	thread = std::thread(&SimulationThread::run, this);
+}
+
+
+void SimulationThread::stop() {
+	running = false;
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+
+void SimulationThread::submitInput(const PlayerInput& input) {
+	std::lock_guard<std::mutex> lock(inputMutex);
+	pendingInput.merge(input);
+}
+
+
+const GameSnapshot& SimulationThread::readSnapshot() {
+	snapshots.update();
+	return snapshots.readBuffer();
+}
+
+
+float SimulationThread::alpha() const {
+	using namespace std::chrono;
+	double sinceTick = duration<double>(steady_clock::now() - snapshots.readBuffer().tickTime).count();
+	return static_cast<float>(std::clamp(sinceTick / Simulation::TIMESTEP, 0.0, 1.0));
+}
+
+
+void SimulationThread::run() {
+	using namespace std::chrono;
+	const steady_clock::duration timestep = duration_cast<steady_clock::duration>(duration<double>(Simulation::TIMESTEP));
+	const steady_clock::duration maxLag = duration_cast<steady_clock::duration>(duration<double>(0.25));
+
+	steady_clock::time_point nextTick = steady_clock::now();
+	while (running) {
+		PlayerInput input;
+		{
+			std::lock_guard<std::mutex> lock(inputMutex);
+			input = pendingInput;
+			pendingInput.clearEvents();
+		}
+
+		simulation.step(input);
+
+		GameSnapshot& snapshot = snapshots.writeBuffer();
+		snapshot.previous = simulation.getPreviousState();
+		snapshot.current = simulation.getState();
+		snapshot.tickTime = nextTick;
+		snapshots.publish();
+
+		// Sleep until the next tick is due. If we fell far behind, skip ahead
+		// rather than running a burst of ticks to catch up.
+		nextTick += timestep;
+		steady_clock::time_point now = steady_clock::now();
+		if (now - nextTick > maxLag) {
+			nextTick = now;
+		}
+		std::this_thread::sleep_until(nextTick);
+	}
+}
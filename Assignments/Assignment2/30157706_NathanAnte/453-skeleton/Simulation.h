@@ -0,0 +1,164 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Fixed timestep game simulation, decoupled from rendering.
+//
+// The game always advances in ticks of Simulation::TIMESTEP seconds, no matter
+// how fast frames are drawn. The renderer blends the last two ticks together
+// so motion stays smooth when the frame rate and tick rate don't line up.
+//
+// The simulation can either be stepped from the render loop with a
+// FixedTimestep accumulator, or run on its own thread with SimulationThread.
+// Given a JobSystem, each tick is split into jobs: the catch check and the
+// diamond update run side by side, and the diamond update is spread across
+// every worker.
+//------------------------------------------------------------------------------
+
+#include "GameObject.h"
+#include "JobSystem.h"
+#include "Random.h"
+#include "SpatialHash.h"
+#include "Transform2D.h"
+#include "TripleBuffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define CATCH_RADIUS 0.080f
+
+
+// Everything needed to draw one tick of the game
+struct GameState {
+	GameObject ship{ DEFAULT_SHIP_WIDTH, DEFAULT_SHIP_HEIGHT };
+	BouncingBodies diamonds;
+	std::vector<uint8_t> diamondAppear;
+	int score = 0;
+	uint64_t tick = 0;
+};
+
+
+// The two most recent ticks, handed to the renderer for interpolation
+struct GameSnapshot {
+	GameState previous;
+	GameState current;
+
+	// When current was due, used by the render thread to work out how far past it we are
+	std::chrono::steady_clock::time_point tickTime;
+};
+
+
+// Hash of everything that affects how the game plays out, for checking that
+// two runs stayed in lockstep
+uint64_t hashGameState(const GameState& state);
+
+
+// Blends diamonds [begin, end) between two ticks and packs them straight into
+// instance data, one instance per diamond. Caught diamonds get a zero scale so
+// they collapse to nothing, which keeps every range independent of the rest.
+void packDiamondInstances(const GameState& previous, const GameState& current, float alpha, size_t begin, size_t end, AffineInstance* out);
+
+
+class InputRecorder;
+
+
+class Simulation {
+
+public:
+	// Length of one tick in seconds. The per-tick speeds in GameObject were
+	// tuned for a 60Hz display, so this keeps the game feeling the same.
+	static constexpr double TIMESTEP = 1.0 / 60.0;
+
+	// The same seed and the same per-tick input always play out the same game,
+	// with or without jobs
+	Simulation(int diamondCount, uint64_t seed, JobSystem* jobs = nullptr);
+
+	// Advance the game by exactly one tick
+	void step(const PlayerInput& input);
+
+	// Optionally capture the input of every tick from now on, for replaying later
+	void setRecorder(InputRecorder* recorder_) { recorder = recorder_; }
+
+	const GameState& getState() const { return current; }
+	const GameState& getPreviousState() const { return previous; }
+
+private:
+	GameState previous;
+	GameState current;
+
+	Random rng;
+	InputRecorder* recorder;
+	JobSystem* jobs;
+
+	// Broad phase for ship/diamond catches, rebuilt every tick. One grid per
+	// chunk of diamonds when running as jobs, otherwise just the one.
+	std::vector<SpatialHash> diamondGrids;
+	std::vector<std::vector<int>> caughtDiamonds;
+};
+
+
+// Turns variable frame times into a whole number of fixed ticks.
+//
+// Example: int ticks = timestep.advance(frameTime);
+//		  for (int i = 0; i < ticks; i++) simulation.step(input);
+//		  float alpha = timestep.alpha();
+class FixedTimestep {
+
+public:
+	explicit FixedTimestep(double timestep);
+
+	// Adds frameTime seconds and returns how many ticks are now due. Long
+	// stalls (breakpoints, window drags) are clamped so we don't try to
+	// catch up on seconds of game time in one frame.
+	int advance(double frameTime);
+
+	// How far we are between the last tick and the next one, in [0, 1)
+	float alpha() const { return static_cast<float>(accumulator / timestep); }
+
+private:
+	double timestep;
+	double accumulator;
+};
+
+
+// Runs a Simulation on its own thread at a fixed rate.
+//
+// Input goes in through submitInput() and comes out the other side as
+// GameSnapshots through a lock-free TripleBuffer, so the render thread
+// never waits on the simulation to draw a frame.
+class SimulationThread {
+
+public:
+	explicit SimulationThread(Simulation& simulation);
+	~SimulationThread();
+
+	SimulationThread(const SimulationThread&) = delete;
+	SimulationThread operator=(const SimulationThread&) = delete;
+
+	void start();
+	void stop();
+
+	// Render thread: queue up input for the next tick
+	void submitInput(const PlayerInput& input);
+
+	// Render thread: latest snapshot, and how far past its tick we are in [0, 1]
+	const GameSnapshot& readSnapshot();
+	float alpha() const;
+
+private:
+	Simulation& simulation;
+	std::thread thread;
+	std::atomic<bool> running;
+
+	// Input is tiny and touched once per frame and once per tick, so a
+	// plain mutex is plenty here
+	std::mutex inputMutex;
+	PlayerInput pendingInput;
+
+	TripleBuffer<GameSnapshot> snapshots;
+
+	void run();
+};
@@ -0,0 +1,143 @@
+#include "SpatialHash.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+SpatialHash::SpatialHash(float cellSize)
+	: cellSize(cellSize)
+	, inverseCellSize(1.0f / cellSize)
+	, bucketMask(0)
+{}
+
+
+glm::ivec2 SpatialHash::cellOf(glm::vec2 point) const {
+	return glm::ivec2(
+		static_cast<int>(std::floor(point.x * inverseCellSize)),
+		static_cast<int>(std::floor(point.y * inverseCellSize))
+	);
+}
+
+
+uint32_t SpatialHash::bucketOf(glm::ivec2 cell) const {
+	// Large primes from Teschner et al. "Optimized Spatial Hashing for Collision Detection"
+	uint32_t h = (static_cast<uint32_t>(cell.x) * 73856093u) ^ (static_cast<uint32_t>(cell.y) * 19349663u);
+	return h & bucketMask;
+}
+
+
+void SpatialHash::build(const std::vector<glm::vec2>& positions) {
+	buildFrom(positions.size(), [&positions](size_t i) { return positions[i]; });
+}
+
+
+void SpatialHash::build(const std::vector<float>& positionX, const std::vector<float>& positionY) {
+	build(positionX.data(), positionY.data(), positionX.size());
+}
+
+
+void SpatialHash::build(const float* positionX, const float* positionY, size_t count) {
+	buildFrom(count, [positionX, positionY](size_t i) { return glm::vec2(positionX[i], positionY[i]); });
+}
+
+
+template <typename GetPosition>
+void SpatialHash::buildFrom(size_t n, GetPosition getPosition) {
+	// Roughly two buckets per entity keeps the chains short, rounded up to a
+	// power of two so the hash can be masked instead of taken modulo
+	uint32_t bucketCount = 16;
+	while (bucketCount < 2 * n) {
+		bucketCount <<= 1;
+	}
+	bucketMask = bucketCount - 1;
+
+	bucketStart.assign(bucketCount + 1, 0);
+	entityBucket.resize(n);
+	sortedIds.resize(n);
+	sortedPositions.resize(n);
+	sortedCells.resize(n);
+
+	// Counting sort by bucket: count, prefix sum, then scatter
+	for (size_t i = 0; i < n; i++) {
+		uint32_t b = bucketOf(cellOf(getPosition(i)));
+		entityBucket[i] = b;
+		bucketStart[b + 1]++;
+	}
+	for (uint32_t b = 0; b < bucketCount; b++) {
+		bucketStart[b + 1] += bucketStart[b];
+	}
+
+	// Scatter using bucketStart[b] as a write cursor, then shift it back afterwards
+	for (size_t i = 0; i < n; i++) {
+		int slot = bucketStart[entityBucket[i]]++;
+		sortedIds[slot] = static_cast<int>(i);
+		sortedPositions[slot] = getPosition(i);
+		sortedCells[slot] = cellOf(sortedPositions[slot]);
+	}
+	for (uint32_t b = bucketCount; b > 0; b--) {
+		bucketStart[b] = bucketStart[b - 1];
+	}
+	bucketStart[0] = 0;
+}
+
+
+void SpatialHash::queryRadius(glm::vec2 point, float radius, std::vector<int>& out) const {
+	if (sortedIds.empty()) {
+		return;
+	}
+
+	const float radiusSquared = radius * radius;
+	const glm::ivec2 minCell = cellOf(point - glm::vec2(radius));
+	const glm::ivec2 maxCell = cellOf(point + glm::vec2(radius));
+
+	for (int cy = minCell.y; cy <= maxCell.y; cy++) {
+		for (int cx = minCell.x; cx <= maxCell.x; cx++) {
+			const glm::ivec2 cell(cx, cy);
+			const uint32_t b = bucketOf(cell);
+
+			for (int k = bucketStart[b]; k < bucketStart[b + 1]; k++) {
+				// Other cells can share this bucket, so skip anything that isn't
+				// actually in the cell being visited
+				if (sortedCells[k] != cell) {
+					continue;
+				}
+				glm::vec2 d = sortedPositions[k] - point;
+				if (glm::dot(d, d) <= radiusSquared) {
+					out.push_back(sortedIds[k]);
+				}
+			}
+		}
+	}
+}
+
+
+void SpatialHash::overlappingPairs(float radius, std::vector<std::pair<int, int>>& out) const {
+	const float radiusSquared = radius * radius;
+
+	// Number of neighbouring cells that can hold something within radius
+	const int span = static_cast<int>(std::ceil(radius * inverseCellSize));
+
+	for (size_t k = 0; k < sortedIds.size(); k++) {
+		const int id = sortedIds[k];
+		const glm::vec2 p = sortedPositions[k];
+		const glm::ivec2 home = sortedCells[k];
+
+		for (int cy = home.y - span; cy <= home.y + span; cy++) {
+			for (int cx = home.x - span; cx <= home.x + span; cx++) {
+				const glm::ivec2 cell(cx, cy);
+				const uint32_t b = bucketOf(cell);
+
+				for (int m = bucketStart[b]; m < bucketStart[b + 1]; m++) {
+					// Only report each pair once, from its lower index
+					if (sortedIds[m] <= id || sortedCells[m] != cell) {
+						continue;
+					}
+					glm::vec2 d = sortedPositions[m] - p;
+					if (glm::dot(d, d) <= radiusSquared) {
+						out.emplace_back(id, sortedIds[m]);
+					}
+				}
+			}
+		}
+	}
+}
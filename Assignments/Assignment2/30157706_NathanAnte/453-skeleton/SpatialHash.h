@@ -0,0 +1,66 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A uniform-grid spatial hash for broad phase collision queries.
+//
+// Every entity is dropped into a square grid cell of side cellSize, and cells
+// are hashed into a fixed number of buckets. build() rebuilds the structure
+// from scratch with a counting sort, so it is linear in the number of entities
+// and cheap enough to redo every tick.
+//
+// Example: SpatialHash grid(0.1f);
+//		  grid.build(positions);
+//		  grid.queryRadius(shipPosition, 0.08f, hits);
+//------------------------------------------------------------------------------
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+class SpatialHash {
+
+public:
+	explicit SpatialHash(float cellSize);
+
+	// Rebuilds the grid over the given positions. Entities are identified
+	// by their index in this vector in all query results.
+	void build(const std::vector<glm::vec2>& positions);
+
+	// Same, for positions stored as separate x and y arrays
+	void build(const std::vector<float>& positionX, const std::vector<float>& positionY);
+	void build(const float* positionX, const float* positionY, size_t count);
+
+	// Appends the index of every entity within radius of point to out
+	void queryRadius(glm::vec2 point, float radius, std::vector<int>& out) const;
+
+	// Appends every pair (i, j) with i < j whose distance is within radius to out
+	void overlappingPairs(float radius, std::vector<std::pair<int, int>>& out) const;
+
+	float getCellSize() const { return cellSize; }
+	size_t size() const { return sortedIds.size(); }
+
+private:
+	float cellSize;
+	float inverseCellSize;
+	uint32_t bucketMask;
+
+	// bucketStart[b] .. bucketStart[b + 1] is the range of sorted entries in bucket b
+	std::vector<int> bucketStart;
+
+	// Entities sorted by bucket, so each bucket is a contiguous run in memory
+	std::vector<int> sortedIds;
+	std::vector<glm::vec2> sortedPositions;
+	std::vector<glm::ivec2> sortedCells;
+
+	// Scratch space reused between builds
+	std::vector<uint32_t> entityBucket;
+
+	glm::ivec2 cellOf(glm::vec2 point) const;
+	uint32_t bucketOf(glm::ivec2 cell) const;
+
+	template <typename GetPosition>
+	void buildFrom(size_t count, GetPosition getPosition);
+};
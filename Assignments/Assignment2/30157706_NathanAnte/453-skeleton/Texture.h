@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GLHandles.h"
+#include "RenderStats.h"
 #include <glad/glad.h>
 #include <string>
 
@@ -33,6 +34,7 @@ private:
 	TextureHandle textureID;
 	std::string path;
 	GLint interpolation;
+	RenderStats::TextureBytes residentBytes;
 
 
 	// Although uint might make more sense here, went with int under the assumption
@@ -0,0 +1,55 @@
+#include "Transform2D.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSFORM2D_USE_SSE
+#endif
+
+
+Transform2D Transform2D::fromAngle(glm::vec2 position, float angle, glm::vec2 scale) {
+	Transform2D transform;
+	transform.position = position;
+	transform.rotation = glm::vec2(std::cos(angle), std::sin(angle));
+	transform.scale = scale;
+	return transform;
+}
+
+
+glm::mat4 Transform2D::toMat4() const {
+	glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(position, 0.0f));
+	glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), std::atan2(rotation.y, rotation.x), glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::mat4 scalingMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(scale, 1.0f));
+	return translationMatrix * rotationMatrix * scalingMatrix;
+}
+
+
+void packInstances(const Transform2D* transforms, size_t count, AffineInstance* out) {
+#ifdef TRANSFORM2D_USE_SSE
+	// linear = (c, s, s, c) * (sx, sx, sy, sy) with the sign of the third lane flipped
+	const __m128 negateThird = _mm_castsi128_ps(_mm_set_epi32(0, static_cast<int>(0x80000000), 0, 0));
+
+	for (size_t i = 0; i < count; i++) {
+		// rotation and scale are contiguous: (c, s, sx, sy)
+		__m128 rotationScale = _mm_loadu_ps(&transforms[i].rotation.x);
+		__m128 rotation = _mm_shuffle_ps(rotationScale, rotationScale, _MM_SHUFFLE(0, 1, 1, 0));
+		__m128 scale = _mm_shuffle_ps(rotationScale, rotationScale, _MM_SHUFFLE(3, 3, 2, 2));
+		__m128 linear = _mm_xor_ps(_mm_mul_ps(rotation, scale), negateThird);
+
+		_mm_storeu_ps(&out[i].linear.x, linear);
+		out[i].translation = transforms[i].position;
+	}
+#else
+	for (size_t i = 0; i < count; i++) {
+		const Transform2D& t = transforms[i];
+		out[i].linear = glm::vec4(
+			t.rotation.x * t.scale.x, t.rotation.y * t.scale.x,
+			-t.rotation.y * t.scale.y, t.rotation.x * t.scale.y
+		);
+		out[i].translation = t.position;
+	}
+#endif
+}
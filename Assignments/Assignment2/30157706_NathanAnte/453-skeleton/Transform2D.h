@@ -0,0 +1,44 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Compact 2D transforms.
+//
+// Everything in this game is flat, so a full glm::mat4 per object is mostly
+// zeros and ones. A Transform2D is just a position, a rotation stored as the
+// unit vector (cos theta, sin theta), and a non-uniform scale. Storing the
+// rotation as a vector means facing a direction never needs atan2, sin or cos.
+//
+// For drawing, transforms are packed into AffineInstances: the 2x2 linear part
+// and the translation of a 3x2 affine matrix. That's 24 bytes per instance
+// instead of 64, and the vertex shader applies it directly.
+//------------------------------------------------------------------------------
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+
+struct Transform2D {
+	glm::vec2 position = glm::vec2(0.0f, 0.0f);
+	glm::vec2 rotation = glm::vec2(1.0f, 0.0f);   // (cos theta, sin theta)
+	glm::vec2 scale = glm::vec2(1.0f, 1.0f);
+
+	static Transform2D fromAngle(glm::vec2 position, float angle, glm::vec2 scale);
+
+	// Same as translate * rotate * scale with glm::mat4s, for comparison
+	glm::mat4 toMat4() const;
+};
+
+
+// GPU-ready per-instance data, matching the instance attributes in test.vert
+struct AffineInstance {
+	glm::vec4 linear;        // columns of the 2x2 matrix: (m00, m10, m01, m11)
+	glm::vec2 translation;
+};
+
+static_assert(sizeof(Transform2D) == 6 * sizeof(float), "Transform2D must be tightly packed");
+static_assert(sizeof(AffineInstance) == 6 * sizeof(float), "AffineInstance must be tightly packed");
+
+
+// Converts count transforms into instance data, using SSE where available
+void packInstances(const Transform2D* transforms, size_t count, AffineInstance* out);
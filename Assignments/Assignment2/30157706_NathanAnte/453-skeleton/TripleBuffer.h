@@ -0,0 +1,55 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A lock-free single producer, single consumer triple buffer.
+//
+// The writer always has a buffer of its own to fill and the reader always has
+// one of its own to read, so neither ever waits on the other. publish() and
+// update() just swap buffer indices with the shared middle slot atomically.
+// The reader only ever sees the most recently published value; anything
+// published in between is dropped, which is what we want for game state.
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstdint>
+
+
+template <typename T>
+class TripleBuffer {
+
+public:
+	TripleBuffer() : backIndex(0), frontIndex(1), middle(2) {}
+
+	// Disallow copying and moving, the atomic ties it to one place in memory
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer operator=(const TripleBuffer&) = delete;
+
+	// Writer side: fill writeBuffer(), then publish() it
+	T& writeBuffer() { return buffers[backIndex]; }
+	void publish() {
+		uint8_t previous = middle.exchange(backIndex | DIRTY, std::memory_order_acq_rel);
+		backIndex = previous & INDEX_MASK;
+	}
+
+	// Reader side: update() picks up the latest published buffer, if there is
+	// one, and returns whether anything changed. Then read from readBuffer().
+	bool update() {
+		if ((middle.load(std::memory_order_relaxed) & DIRTY) == 0) {
+			return false;
+		}
+		uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+		frontIndex = previous & INDEX_MASK;
+		return true;
+	}
+	const T& readBuffer() const { return buffers[frontIndex]; }
+
+private:
+	static constexpr uint8_t INDEX_MASK = 0x3;
+	static constexpr uint8_t DIRTY = 0x4;
+
+	T buffers[3];
+
+	uint8_t backIndex;              // only touched by the writer
+	uint8_t frontIndex;             // only touched by the reader
+	std::atomic<uint8_t> middle;    // index of the shared buffer, plus the dirty bit
+};
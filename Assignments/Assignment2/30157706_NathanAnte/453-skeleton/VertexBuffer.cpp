@@ -1,5 +1,7 @@
 #include "VertexBuffer.h"
 
+#include "RenderStats.h"
+
 #include <utility>
 
 
@@ -15,4 +17,5 @@ VertexBuffer::VertexBuffer(GLuint index, GLint size, GLenum dataType)
 void VertexBuffer::uploadData(GLsizeiptr size, const void* data, GLenum usage) {
 	bind();
 	glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+	RenderStats::countUpload(size);
 }
@@ -1,56 +1,51 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
 #include <iostream>
+#include <optional>
 #include <string>
-#include <cstdlib>
 #include <ctime> 
+#include <thread>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
 
+#include "Benchmark.h"
+#include "GameObject.h"
 #include "Geometry.h"
 #include "GLDebug.h"
+#include "GpuKinematics.h"
+#include "GpuSimulation.h"
+#include "JobSystem.h"
 #include "Log.h"
+#include "RenderStats.h"
+#include "Replay.h"
 #include "ShaderProgram.h"
 #include "Shader.h"
+#include "Simulation.h"
+#include "StatsOverlay.h"
 #include "Texture.h"
+#include "Transform2D.h"
 #include "Window.h"
 
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
 
-#include <glm/gtc/type_ptr.hpp>
+#include <argh.h>
 
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 800
 
-#define DEFAULT_SHIP_WIDTH 0.12f
-#define DEFAULT_SHIP_HEIGHT 0.08f
+#define DIAMOND_COUNT 4
 
-#define DEFAULT_DIAMOND_WIDTH 0.10f
-#define DEFAULT_DIAMOND_HEIGHT 0.10f
-
-// Player Input Struct
-struct PlayerInput {
-	glm::vec2 cursorPosition = glm::vec2(0.0f, 1.0f);
-	bool startGame = false;
-	bool resetFlag = false;
-	bool isMovingForward = false;
-	bool isMovingBackward = false;
-};
-
-// An example struct for Game Objects.
-// You are encouraged to customize this as you see fit.
-struct GameObject {
+// Everything the GPU needs to draw a textured quad.
+// Game logic lives in GameObject, see GameObject.h
+struct Sprite {
 	// Struct's constructor deals with the texture.
-	// Also sets default position, theta, scale, and transformationMatrix
-	GameObject(std::string texturePath, GLenum textureInterpolation, float objectWidth, float objectHeight) :
-		texture(texturePath, textureInterpolation),
-		position(glm::vec2(0.0f, 0.0f)),
-		direction(glm::vec2(0.0f, 0.0f)),
-		appear(true)
+	Sprite(std::string texturePath, GLenum textureInterpolation) :
+		texture(texturePath, textureInterpolation)
 	{
 		// vertex coordinates
 		cgeom.verts.push_back(glm::vec3(-1.f, 1.f, 0.f));
@@ -71,132 +66,36 @@ struct GameObject {
 		// GPU Geometry
 		ggeom.setVerts(cgeom.verts);
 		ggeom.setTexCoords(cgeom.texCoords);
-
-		// Setting Initial Transformation Matrixes
-		scalingMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(objectWidth, objectHeight, 1.0f));
-		rotationMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-		translationMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f));
-	}
-
-	glm::mat4 getTransformationMatrix() {
-		return translationMatrix * rotationMatrix * scalingMatrix;
 	}
 
-	void resizeShip(int score) {
-		scalingMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(DEFAULT_SHIP_WIDTH + (0.05 * score), DEFAULT_SHIP_HEIGHT + (0.05 * score), 1.0f));
+	// Draws one copy of the sprite per transform with a single instanced draw call
+	void draw(const std::vector<Transform2D>& transforms) {
+		instances.resize(transforms.size());
+		packInstances(transforms.data(), transforms.size(), instances.data());
+		drawInstances();
 	}
 
-	void updateShip(PlayerInput input) {
-		// Check for reset flag
-		if (input.resetFlag == true) {
-			position = glm::vec2(0.0f, 0.0f);
-			direction = glm::vec2(0.0f, 1.0f);
-			scalingMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(DEFAULT_SHIP_WIDTH, DEFAULT_SHIP_HEIGHT, 1.0f));
-			rotationMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-			translationMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f));
+	// Same, for when instances has already been filled in
+	void drawInstances() {
+		if (instances.empty()) {
 			return;
 		}
-
-		// Calculate direction vector and normalize
-		glm::vec2 directionToCursor = input.cursorPosition - position;
-		float distanceToCursor = glm::length(directionToCursor);
-
-		// Compute the angle between the current direction and the new direction
-		float angleToCursor = atan2(directionToCursor.y, directionToCursor.x) - glm::radians(90.0f); // Angle to face cursor
-
-		// Set the rotation matrix to new angle
-		rotationMatrix = glm::rotate(glm::mat4(1.0f), angleToCursor, glm::vec3(0.0f, 0.0f, 1.0f));
-
-		// Check if the ship is far enough from the cursor
-		const float proximityThreshold = 0.15f;
-		if (distanceToCursor < proximityThreshold) {
-			input.isMovingForward = false;
-		}
-
-		// Calculate new direction vector
-		glm::vec2 newDirection = glm::normalize(directionToCursor);
-
-		// Translate if moving forward or backward
-		glm::vec3 translation(0.0f);
-		if (input.isMovingForward && !input.isMovingBackward) {
-			translation = glm::vec3(newDirection * 0.02f, 0.0f); 
-		}
-		else if (!input.isMovingForward && input.isMovingBackward) {
-			translation = glm::vec3(-newDirection * 0.02f, 0.0f); 
-		}
-
-		// Calculate new position
-		glm::vec2 newPosition = position + glm::vec2(translation.x, translation.y);
-
-		// Check if new position is within bounds
-		if (newPosition.x >= -1.0f + (DEFAULT_SHIP_WIDTH / 2) && newPosition.x <= 1.0f - (DEFAULT_SHIP_WIDTH / 2) &&
-			newPosition.y >= -1.0f + (DEFAULT_SHIP_HEIGHT / 2) && newPosition.y <= 1.0f - (DEFAULT_SHIP_HEIGHT / 2)) {
-			// If new position is within bounds, apply the translation
-			translationMatrix = glm::translate(translationMatrix, translation);
-			position = newPosition;
-		}
-	}
-
-	void initializeDiamond() {
-		// Generate a random position within the window bounds
-		appear = true;
-		
-		position = glm::vec2(
-			(static_cast<float>(rand()) / RAND_MAX) - 0.5f,  // Random X position
-			(static_cast<float>(rand()) / RAND_MAX) - 0.5f  // Random Y position
-		);
-		// std::cout << "X: " << position.x << " Y: " << position.y << std::endl;
-
-		// Create a translation matrix using the position
-		translationMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(position, 0.0f));
-
-		// Generate a random direction vector in the range of [-1, 1]
-		direction = glm::vec2(
-			(static_cast<float>(rand()) / RAND_MAX * 2.0f) - 1.0f, // Random X direction between -1 and 1
-			(static_cast<float>(rand()) / RAND_MAX * 2.0f) - 1.0f  // Random Y direction between -1 and 1
-		);
-
-		// std::cout << "X: " << direction.x << " Y: " << direction.y << std::endl;
-
-		// Normalize the direction vector to maintain consistent speed
-		direction = glm::normalize(direction);
-	}
-
-	void updateDiamond(PlayerInput input) {
-		// Update the position based on direction
-		position += direction * 0.003f; // Move in the current direction
-
-		// Check bounds and invert direction if needed
-		if (position.x <= -1.0f || position.x >= 1.0f) {
-			direction.x = -direction.x; // Invert X direction
-		}
-		if (position.y <= -1.0f || position.y >= 1.0f) {
-			direction.y = -direction.y; // Invert Y direction
-		}
-
-		// Update the transformation matrix
-		translationMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(position, 0.0f));
+		ggeom.bind();
+		ggeom.setInstances(instances);
+		texture.bind();
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(instances.size()));
+		RenderStats::countDrawCall();
+		texture.unbind();
 	}
 
 	CPU_Geometry cgeom;
 	GPU_Geometry ggeom;
 	Texture texture;
 
-	bool appear;
-
-	glm::vec2 position;
-	glm::vec2 direction;
-
-	glm::mat4 scalingMatrix;
-	glm::mat4 rotationMatrix;
-	glm::mat4 translationMatrix;
+	// Reused every frame to avoid reallocating
+	std::vector<AffineInstance> instances;
 };
 
-bool isCaught(const glm::vec2& shipPosition, const glm::vec2& diamondPosition) {
-	float distance = glm::length(shipPosition - diamondPosition);
-	return distance <= 0.080f;
-}
-
 // EXAMPLE CALLBACKS
 class MyCallbacks : public CallbackInterface {
 
@@ -265,13 +164,61 @@ private:
 
 // END EXAMPLES
 
-int main() {
+int main(int argc, char** argv) {
 	Log::debug("Starting main");
 
-	std::srand(static_cast<unsigned int>(std::time(0)));
+	// Headless benchmarks and replays, e.g. --bench=spatial or --replay=game.replay
+	// Everything else is a flag, e.g. --threaded-sim
+	argh::parser cmdl(argc, argv);
+	std::string benchmark;
+	if (cmdl("bench") >> benchmark) {
+		return Benchmark::run(benchmark) ? 0 : 1;
+	}
+	std::string replayPath;
+	if (cmdl("replay") >> replayPath) {
+		return Replay::run(replayPath, cmdl("hashes").str(), cmdl("expect").str()) ? 0 : 1;
+	}
+
+	// A fixed --seed gives the same diamonds every time
+	uint64_t seed;
+	cmdl("seed", static_cast<uint64_t>(std::time(0))) >> seed;
+
+	// --diamonds=N for a bigger crowd, --threads=N to limit the job system
+	int diamondCount;
+	cmdl("diamonds", DIAMOND_COUNT) >> diamondCount;
+	unsigned threadCount;
+	cmdl("threads", std::max(1u, std::thread::hardware_concurrency())) >> threadCount;
 
 	// WINDOW
 	glfwInit();
+
+	// --gpu-compare[=N] runs N diamonds on the GPU and the CPU side by side
+	// for --ticks ticks and checks they agree, first the kinematics alone and
+	// then the whole game. It needs a GL context, so it opens a hidden window,
+	// but also works under Mesa's software renderer (LIBGL_ALWAYS_SOFTWARE=1)
+	// on machines without a GPU.
+	if (cmdl["gpu-compare"] || cmdl("gpu-compare")) {
+		size_t compareCount;
+		cmdl("gpu-compare", 100000) >> compareCount;
+		int compareTicks;
+		cmdl("ticks", 2000) >> compareTicks;
+
+		bool matched;
+		{
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+			Window hiddenWindow(64, 64, "CPSC 453");
+			GLDebug::enable();
+			matched = GpuKinematics::compare(compareCount, compareTicks, seed);
+			matched = GpuSimulation::compare(static_cast<int>(compareCount), compareTicks, seed) && matched;
+
+			ImGui_ImplOpenGL3_Shutdown();
+			ImGui_ImplGlfw_Shutdown();
+			ImGui::DestroyContext();
+		}
+		glfwTerminate();
+		return matched ? 0 : 1;
+	}
+
 	Window window(WINDOW_WIDTH, WINDOW_HEIGHT, "CPSC 453"); // can set callbacks at construction if desired
 
 	GLDebug::enable();
@@ -285,35 +232,102 @@ int main() {
 
 	// GL_NEAREST looks a bit better for low-res pixel art than GL_LINEAR.
 	// But for most other cases, you'd want GL_LINEAR interpolation.
-	GameObject ship("textures/ship.png", GL_NEAREST, DEFAULT_SHIP_WIDTH, DEFAULT_SHIP_HEIGHT);
+	Sprite shipSprite("textures/ship.png", GL_NEAREST);
+	Sprite diamondSprite("textures/diamond.png", GL_NEAREST);
+
+	// JOBS
+	// This thread helps out while it waits, so it counts as one of the threads
+	JobSystem jobs(std::max(1u, threadCount) - 1);
+
+	// GAME SIMULATION
+	// Runs at a fixed tick rate, either here in the render loop or,
+	// with --threaded-sim, on a thread of its own
+	Simulation simulation(diamondCount, seed, &jobs);
+
+	// --gpu-diamonds keeps the diamonds on the GPU instead, see GpuSimulation.h.
+	// It needs the GL context, so it always steps here in the render loop.
+	std::optional<GpuSimulation> gpuSimulation;
+	if (cmdl["gpu-diamonds"]) {
+		gpuSimulation.emplace(diamondCount, seed, diamondSprite.cgeom);
+	}
 
-	std::vector<GameObject> diamonds;
-	GameObject diamond1("textures/diamond.png", GL_NEAREST, DEFAULT_DIAMOND_WIDTH, DEFAULT_DIAMOND_HEIGHT);
-	GameObject diamond2("textures/diamond.png", GL_NEAREST, DEFAULT_DIAMOND_WIDTH, DEFAULT_DIAMOND_HEIGHT);
-	GameObject diamond3("textures/diamond.png", GL_NEAREST, DEFAULT_DIAMOND_WIDTH, DEFAULT_DIAMOND_HEIGHT);
-	GameObject diamond4("textures/diamond.png", GL_NEAREST, DEFAULT_DIAMOND_WIDTH, DEFAULT_DIAMOND_HEIGHT);
-	diamond1.initializeDiamond();
-	diamond2.initializeDiamond();
-	diamond3.initializeDiamond();
-	diamond4.initializeDiamond();
+	// --record=game.replay captures every tick's input for Replay::run
+	std::string recordPath = cmdl("record").str();
+	InputRecorder recorder(seed, diamondCount);
+	if (!recordPath.empty()) {
+		if (gpuSimulation) {
+			gpuSimulation->setRecorder(&recorder);
+		}
+		else {
+			simulation.setRecorder(&recorder);
+		}
+	}
 
-	// Game Score
-	int score = 0;
+	SimulationThread simulationThread(simulation);
+	FixedTimestep timestep(Simulation::TIMESTEP);
+	PlayerInput pendingInput;
+
+	const bool threadedSimulation = cmdl["threaded-sim"] && !gpuSimulation;
+	if (threadedSimulation) {
+		simulationThread.start();
+	}
+	else if (cmdl["threaded-sim"]) {
+		Log::warn("--threaded-sim is ignored with --gpu-diamonds");
+	}
+
+	std::vector<Transform2D> shipTransforms;
+
+	// PERFORMANCE STATS
+	// --stats shows the overlay, --stats-csv=FILE writes every frame to FILE
+	const bool showStats = cmdl["stats"];
+	RenderStats::Recorder renderStats;
+	std::string statsCsvPath = cmdl("stats-csv").str();
+	if (!statsCsvPath.empty() && !renderStats.openCsv(statsCsvPath)) {
+		Log::error("STATS could not write {}", statsCsvPath);
+	}
+
+	double previousTime = glfwGetTime();
 
 	// RENDER LOOP
 	while (!window.shouldClose()) {
 		
 		glfwPollEvents();
+		renderStats.beginFrame();
+
+		const GameState* previous = nullptr;
+		const GameState* current = nullptr;
+		float alpha;
 
-		PlayerInput input = callback->getPlayerInput();
+		if (threadedSimulation) {
+			simulationThread.submitInput(callback->getPlayerInput());
+
+			const GameSnapshot& snapshot = simulationThread.readSnapshot();
+			previous = &snapshot.previous;
+			current = &snapshot.current;
+			alpha = simulationThread.alpha();
+		}
+		else {
+			pendingInput.merge(callback->getPlayerInput());
+
+			double currentTime = glfwGetTime();
+			int ticks = timestep.advance(currentTime - previousTime);
+			previousTime = currentTime;
+
+			// One-shot events (key presses, reset) are consumed by the first
+			// tick only, so the game plays the same at any frame rate
+			for (int i = 0; i < ticks; i++) {
+				if (gpuSimulation) {
+					gpuSimulation->step(pendingInput);
+				}
+				else {
+					simulation.step(pendingInput);
+				}
+				pendingInput.clearEvents();
+			}
 
-		// Reset Score and diamonds
-		if (input.resetFlag) {
-			score = 0;
-			diamond1.initializeDiamond();
-			diamond2.initializeDiamond();
-			diamond3.initializeDiamond();
-			diamond4.initializeDiamond();
+			previous = &simulation.getPreviousState();
+			current = &simulation.getState();
+			alpha = timestep.alpha();
 		}
 
 		shader.use();
@@ -322,110 +336,34 @@ int main() {
 		glEnable(GL_FRAMEBUFFER_SRGB);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-
-		/*---------------------------------------------------------------*/
-
-		glm::mat4 diamondTransformationMatrix;
-
-		// Update diamond1 position
-		if (diamond1.appear) {
-			if (isCaught(ship.position, diamond1.position) && input.startGame) {
-				score++;
-				ship.resizeShip(score);
-				diamond1.appear = false;
-			}
-			else {
-				diamond1.updateDiamond(input);
-				diamondTransformationMatrix = diamond1.getTransformationMatrix();
-				glUniformMatrix4fv(
-					glGetUniformLocation(shader.getProgram(), "transformationMatrix"),
-					1, GL_FALSE, glm::value_ptr(diamondTransformationMatrix)
-				);
-				diamond1.ggeom.bind();
-				diamond1.texture.bind();
-				glDrawArrays(GL_TRIANGLES, 0, 6);
-				diamond1.texture.unbind();
-			}
-		}
-
-		// Update diamond2 position
-		if (diamond2.appear) {
-			if (isCaught(ship.position, diamond2.position) && input.startGame) {
-				score++;
-				ship.resizeShip(score);
-				diamond2.appear = false;
-			}
-			else {
-				diamond2.updateDiamond(input);
-				diamondTransformationMatrix = diamond2.getTransformationMatrix();
-				glUniformMatrix4fv(
-					glGetUniformLocation(shader.getProgram(), "transformationMatrix"),
-					1, GL_FALSE, glm::value_ptr(diamondTransformationMatrix)
-				);
-				diamond2.ggeom.bind();
-				diamond2.texture.bind();
-				glDrawArrays(GL_TRIANGLES, 0, 6);
-				diamond2.texture.unbind();
-			}
+		// Render diamonds, blended between the last two ticks. The instance
+		// data is filled in on the job system, then uploaded from here.
+		// On the GPU path they are drawn straight from the state buffers.
+		int score;
+		if (gpuSimulation) {
+			diamondSprite.texture.bind();
+			gpuSimulation->drawDiamonds(alpha);
+			diamondSprite.texture.unbind();
+			shader.use();
+
+			shipTransforms.assign(1, interpolateTransform(gpuSimulation->getPreviousShip(), gpuSimulation->getShip(), alpha));
+			score = gpuSimulation->getScore();
 		}
-
-		// Update diamond3 position
-		if (diamond3.appear) {
-			if (isCaught(ship.position, diamond3.position) && input.startGame) {
-				score++;
-				ship.resizeShip(score);
-				diamond3.appear = false;
-			}
-			else {
-				diamond3.updateDiamond(input);
-				diamondTransformationMatrix = diamond3.getTransformationMatrix();
-				glUniformMatrix4fv(
-					glGetUniformLocation(shader.getProgram(), "transformationMatrix"),
-					1, GL_FALSE, glm::value_ptr(diamondTransformationMatrix)
-				);
-				diamond3.ggeom.bind();
-				diamond3.texture.bind();
-				glDrawArrays(GL_TRIANGLES, 0, 6);
-				diamond3.texture.unbind();
-			}
-		}
-
-		// Update diamond4 position
-		if (diamond4.appear) {
-			if (isCaught(ship.position, diamond4.position) && input.startGame) {
-				score++;
-				ship.resizeShip(score);
-				diamond4.appear = false;
-			}
-			else {
-				diamond4.updateDiamond(input);
-				diamondTransformationMatrix = diamond4.getTransformationMatrix();
-				glUniformMatrix4fv(
-					glGetUniformLocation(shader.getProgram(), "transformationMatrix"),
-					1, GL_FALSE, glm::value_ptr(diamondTransformationMatrix)
-				);
-				diamond4.ggeom.bind();
-				diamond4.texture.bind();
-				glDrawArrays(GL_TRIANGLES, 0, 6);
-				diamond4.texture.unbind();
-			}
+		else {
+			const size_t diamondInstances = current->diamonds.size();
+			const size_t grainSize = std::max<size_t>(jobs.grainSizeFor(diamondInstances), 1024);
+			diamondSprite.instances.resize(diamondInstances);
+			jobs.wait(jobs.parallelFor(0, diamondInstances, grainSize, [&](size_t begin, size_t end) {
+				packDiamondInstances(*previous, *current, alpha, begin, end, diamondSprite.instances.data());
+			}));
+			diamondSprite.drawInstances();
+
+			shipTransforms.assign(1, interpolateTransform(previous->ship, current->ship, alpha));
+			score = current->score;
 		}
-		/*---------------------------------------------------------------*/
-
-
-		// Update ship position
-		ship.updateShip(input);
-		glm::mat4 transformationMatrix = ship.getTransformationMatrix();
-		glUniformMatrix4fv(
-			glGetUniformLocation(shader.getProgram(), "transformationMatrix"),
-			1, GL_FALSE, glm::value_ptr(transformationMatrix)
-		);
 
 		// Render Ship
-		ship.ggeom.bind();
-		ship.texture.bind();
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-		ship.texture.unbind();
+		shipSprite.draw(shipTransforms);
 
 		glDisable(GL_FRAMEBUFFER_SRGB); // disable sRGB for things like imgui
 
@@ -453,7 +391,7 @@ int main() {
 		// Scale up text a little, and set its value
 		ImGui::SetWindowFontScale(1.5f);
 
-		if (score == 4) {
+		if (score == diamondCount) {
 			ImGui::Text("Winner Winner Chicken Dinner | Press [R] to reset the game");
 		}
 		else {
@@ -463,11 +401,22 @@ int main() {
 		// End the window.
 		ImGui::End();
 
+		if (showStats) {
+			StatsOverlay::draw(renderStats, static_cast<float>(window.getWidth()));
+		}
+
 		ImGui::Render();	// Render the ImGui window
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // Some middleware thing
 
+		renderStats.endFrame();
 		window.swapBuffers();
 	}
+	simulationThread.stop();
+
+	if (!recordPath.empty() && recorder.save(recordPath)) {
+		Log::info("Saved {} ticks of input to {}", recorder.getRecording().inputs.size(), recordPath);
+	}
+
 	// ImGui cleanup
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
@@ -0,0 +1,19 @@
+#version 330 core
+// One diamond per vertex, tested against the ship before it moves this tick.
+// catch.geom passes on only the ones that are caught, so the CPU reads back a
+// handful of indices instead of every diamond. Same test as
+// SpatialHash::queryRadius.
+layout (location = 0) in vec4 state;   // position.xy, direction.xy
+layout (location = 1) in float appear;
+
+flat out int index;
+flat out int caught;
+
+uniform vec2 shipPosition;
+uniform float radiusSquared;
+
+void main() {
+	vec2 d = state.xy - shipPosition;
+	index = gl_VertexID;
+	caught = (appear != 0.0 && d.x * d.x + d.y * d.y <= radiusSquared) ? 1 : 0;
+}
@@ -0,0 +1,21 @@
+#version 330 core
+// Draws the diamonds straight from GpuSimulation's state buffers, one
+// instance per diamond, blended between the last two ticks. Same placement
+// as packDiamondInstances on the CPU, caught diamonds collapse to nothing.
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec2 texCoord;
+
+layout (location = 2) in vec4 previousState;   // position.xy, direction.xy
+layout (location = 3) in vec4 currentState;
+layout (location = 4) in float appear;
+
+out vec2 tc;
+
+uniform float alpha;
+uniform vec2 size;
+
+void main() {
+	tc = texCoord;
+	vec2 position = mix(previousState.xy, currentState.xy, alpha);
+	gl_Position = vec4(pos.xy * size * appear + position, pos.z, 1.0);
+}
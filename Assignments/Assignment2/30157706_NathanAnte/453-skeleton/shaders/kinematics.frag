@@ -0,0 +1,9 @@
+#version 330 core
+// The transform feedback passes (kinematics.vert, catch.vert) run with
+// GL_RASTERIZER_DISCARD, so nothing ever reaches this. It is only here
+// because ShaderProgram always links a fragment shader.
+out vec4 color;
+
+void main() {
+	color = vec4(0.0);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+// One bouncing body per vertex, advanced by one tick and captured with
+// transform feedback. Same maths as Kinematics::stepBouncing on the CPU.
+layout (location = 0) in vec4 state;   // position.xy, direction.xy
+
+out vec4 nextState;
+
+uniform float speed;
+
+void main() {
+	vec2 position = state.xy + state.zw * speed;
+
+	// Flip the direction on any axis that has reached the edge of the box.
+	// Multiplying by exactly +1 or -1 keeps the result bit-for-bit the same.
+	vec2 outside = vec2(lessThanEqual(position, vec2(-1.0))) + vec2(greaterThanEqual(position, vec2(1.0)));
+	vec2 direction = state.zw * (1.0 - 2.0 * min(outside, vec2(1.0)));
+
+	nextState = vec4(position, direction);
+}
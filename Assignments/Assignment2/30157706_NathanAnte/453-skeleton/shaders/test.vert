@@ -2,13 +2,16 @@
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec2 texCoord;
 
-out vec2 tc;
+// Per-instance 2D affine transform (see Transform2D.h)
+layout (location = 2) in vec4 instanceLinear;       // columns of the 2x2 matrix
+layout (location = 3) in vec2 instanceTranslation;
 
-uniform mat4 transformationMatrix;
+out vec2 tc;
 
 uniform float time;
 
 void main() {
 	tc = texCoord;
-	gl_Position = transformationMatrix * vec4(pos, 1.0);
+	vec2 p = mat2(instanceLinear.xy, instanceLinear.zw) * pos.xy + instanceTranslation;
+	gl_Position = vec4(p, pos.z, 1.0);
 }
@@ -0,0 +1,655 @@
+#include "Benchmark.h"
+
+#include "Bezier.h"
+#include "Chaikin.h"
+#include "ComputeSubdivision.h"
+#include "GLHandles.h"
+#include "Log.h"
+#include "PointIndex.h"
+#include "TensorSurface.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+	using Clock = std::chrono::steady_clock;
+
+	double millisecondsSince(Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// Control points scattered over the curve editor's [-1, 1] square
+	std::vector<glm::vec3> randomPoints(size_t count, unsigned int seed) {
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+
+		std::vector<glm::vec3> points(count);
+		for (glm::vec3& p : points) {
+			p = glm::vec3(coord(rng), coord(rng), 0.0f);
+		}
+		return points;
+	}
+
+	// How main.cpp used to evaluate Bezier curves: a copy of the control
+	// points per call, then O(n^2) interpolation
+	glm::vec3 deCasteljauCopying(std::vector<glm::vec3>& controlPoints, float u) {
+		std::vector<glm::vec3> P = controlPoints;
+		int d = P.size();
+		for (int i = 1; i < d; ++i) {
+			for (int j = 0; j < (d - i); ++j) {
+				P[j] = (1.0f - u) * P[j] + u * P[j + 1];
+			}
+		}
+		return P[0];
+	}
+
+	// How main.cpp used to subdivide: a copy of the input and a growing
+	// output per round, one recursive call per round
+	std::vector<glm::vec3> chaikinRecursive(std::vector<glm::vec3>& coarsePoints, int iterations) {
+		int n = coarsePoints.size();
+		if ((iterations == 0) || (n < 2)) {
+			return coarsePoints;
+		}
+		std::vector<glm::vec3> C = coarsePoints;
+		std::vector<glm::vec3> F;
+		F.push_back(C[0]);
+		F.push_back(0.5f * C[0] + 0.5f * C[1]);
+		for (int i = 1; i < n - 2; ++i) {
+			F.push_back(0.75f * C[i] + 0.25f * C[i + 1]);
+			F.push_back(0.25f * C[i] + 0.75f * C[i + 1]);
+		}
+		F.push_back(0.5f * C[n - 2] + 0.5f * C[n - 1]);
+		F.push_back(C[n - 1]);
+		return chaikinRecursive(F, iterations - 1);
+	}
+
+	// How main.cpp used to build tensor product surfaces: a vector per row,
+	// two transposes built a point at a time, and unshared triangles
+	std::vector<glm::vec3> tensorProductSurfaceTransposing(const std::vector<std::vector<glm::vec3>>& controlPoints, int iterations) {
+		std::vector<std::vector<glm::vec3>> smoothedRows;
+		for (const std::vector<glm::vec3>& row : controlPoints) {
+			std::vector<glm::vec3> coarseRow = row;
+			smoothedRows.push_back(Chaikin::subdivide(coarseRow, iterations));
+		}
+
+		std::vector<std::vector<glm::vec3>> transposedGrid;
+		for (size_t i = 0; i < smoothedRows[0].size(); i++) {
+			std::vector<glm::vec3> column;
+			for (std::vector<glm::vec3>& row : smoothedRows) {
+				column.push_back(row[i]);
+			}
+			transposedGrid.push_back(column);
+		}
+
+		std::vector<std::vector<glm::vec3>> smoothedColumns;
+		for (const std::vector<glm::vec3>& column : transposedGrid) {
+			std::vector<glm::vec3> col = column;
+			smoothedColumns.push_back(Chaikin::subdivide(col, iterations));
+		}
+
+		std::vector<std::vector<glm::vec3>> finalGrid;
+		for (size_t i = 0; i < smoothedColumns[0].size(); i++) {
+			std::vector<glm::vec3> row;
+			for (const auto& col : smoothedColumns) {
+				row.push_back(col[i]);
+			}
+			finalGrid.push_back(row);
+		}
+
+		std::vector<glm::vec3> surfacePoints;
+		for (size_t i = 0; i < finalGrid.size() - 1; i++) {
+			for (size_t j = 0; j < finalGrid[i].size() - 1; j++) {
+				glm::vec3 v1 = finalGrid[i][j];
+				glm::vec3 v2 = finalGrid[i + 1][j];
+				glm::vec3 v3 = finalGrid[i + 1][j + 1];
+				glm::vec3 v4 = finalGrid[i][j + 1];
+
+				surfacePoints.push_back(v1);
+				surfacePoints.push_back(v2);
+				surfacePoints.push_back(v3);
+
+				surfacePoints.push_back(v1);
+				surfacePoints.push_back(v3);
+				surfacePoints.push_back(v4);
+			}
+		}
+		return surfacePoints;
+	}
+
+	// A size x size net over the [-2, 2] square of the tensor view, with
+	// random heights
+	std::vector<std::vector<glm::vec3>> randomNet(size_t size, unsigned int seed) {
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> height(-1.0f, 1.0f);
+
+		std::vector<std::vector<glm::vec3>> net(size, std::vector<glm::vec3>(size));
+		for (size_t i = 0; i < size; i++) {
+			for (size_t j = 0; j < size; j++) {
+				net[i][j] = glm::vec3(4.0f * j / (size - 1) - 2.0f, height(rng), 4.0f * i / (size - 1) - 2.0f);
+			}
+		}
+		return net;
+	}
+
+	// A curve's worth of control points, in order along a spiral out from
+	// the middle of the editor. Later points sit further out, so the linear
+	// scan has further to go to reach them, like clicking near the end of a
+	// long curve.
+	std::vector<glm::vec3> spiralPoints(size_t count) {
+		std::vector<glm::vec3> points(count);
+		for (size_t i = 0; i < count; i++) {
+			float radius = 0.95f * std::sqrt((float(i) + 0.5f) / float(count));
+			float angle = 2.39996323f * float(i);		// the golden angle, for even cover
+			points[i] = glm::vec3(radius * std::cos(angle), radius * std::sin(angle), 0.0f);
+		}
+		return points;
+	}
+
+	// How main.cpp used to pick control points: the first one close enough,
+	// in order
+	int selectLinear(const std::vector<glm::vec3>& points, const glm::vec3& cursor, float radius) {
+		for (size_t i = 0; i < points.size(); i++) {
+			if (glm::length(cursor - points[i]) <= radius) {
+				return int(i);
+			}
+		}
+		return -1;
+	}
+
+	// The nearest point within radius of a ray, by looking at every point
+	int pickRayLinear(const std::vector<glm::vec3>& points, const glm::vec3& origin, const glm::vec3& direction, float radius) {
+		const glm::vec3 d = glm::normalize(direction);
+		int picked = -1;
+		float pickedT = 1.0e30f;
+		for (size_t i = 0; i < points.size(); i++) {
+			const glm::vec3 v = points[i] - origin;
+			const float t = glm::dot(v, d);
+			if (t >= 0.0f && glm::dot(v, v) - t * t <= radius * radius && t < pickedT) {
+				picked = int(i);
+				pickedT = t;
+			}
+		}
+		return picked;
+	}
+
+	// Microseconds each query took
+	struct Latency {
+		std::vector<double> samples;
+
+		template <typename Query>
+		auto time(Query query) {
+			Clock::time_point start = Clock::now();
+			auto result = query();
+			samples.push_back(millisecondsSince(start) * 1000.0);
+			return result;
+		}
+		double average() const {
+			double total = 0.0;
+			for (double us : samples) {
+				total += us;
+			}
+			return samples.empty() ? 0.0 : total / samples.size();
+		}
+		// The 99th percentile, rather than the worst, which is mostly the
+		// scheduler's doing
+		double p99() {
+			if (samples.empty()) {
+				return 0.0;
+			}
+			std::sort(samples.begin(), samples.end());
+			return samples[samples.size() * 99 / 100];
+		}
+	};
+
+	// Average milliseconds per call of step, best of a few runs
+	template <typename Step>
+	double bestTimePerCall(int calls, Step step) {
+		step(); // warm up
+		double best = 1.0e30;
+		for (int run = 0; run < 3; run++) {
+			Clock::time_point start = Clock::now();
+			for (int i = 0; i < calls; i++) {
+				step();
+			}
+			best = std::min(best, millisecondsSince(start) / calls);
+		}
+		return best;
+	}
+
+	// de Casteljau in double, as the reference for the error columns
+	glm::dvec3 deCasteljauExact(const std::vector<glm::vec3>& controlPoints, double u) {
+		std::vector<glm::dvec3> P(controlPoints.begin(), controlPoints.end());
+		for (size_t i = 1; i < P.size(); i++) {
+			for (size_t j = 0; j < P.size() - i; j++) {
+				P[j] = (1.0 - u) * P[j] + u * P[j + 1];
+			}
+		}
+		return P[0];
+	}
+
+	double maxError(const std::vector<glm::vec3>& points, const std::vector<glm::dvec3>& reference) {
+		double error = 0.0;
+		for (size_t i = 0; i < points.size(); i++) {
+			error = std::max(error, glm::length(glm::dvec3(points[i]) - reference[i]));
+		}
+		return error;
+	}
+
+	// Nanoseconds per curve point of sampling the whole curve with sampleCurve
+	template <typename SampleCurve>
+	double nanosecondsPerPoint(size_t samples, SampleCurve sampleCurve) {
+		sampleCurve(); // warm up
+
+		// Enough curves for a few milliseconds, best of a few runs
+		const int curves = 2000;
+		double best = 1.0e30;
+		for (int run = 0; run < 3; run++) {
+			Clock::time_point start = Clock::now();
+			for (int c = 0; c < curves; c++) {
+				sampleCurve();
+			}
+			best = std::min(best, millisecondsSince(start));
+		}
+		return best * 1.0e6 / (double(curves) * samples);
+	}
+
+}
+
+
+bool Benchmark::run(const std::string& name) {
+	if (name == "bezier") {
+		bezier();
+	}
+	else if (name == "chaikin") {
+		chaikin();
+	}
+	else if (name == "tensor") {
+		tensor();
+	}
+	else if (name == "picking") {
+		picking();
+	}
+	else if (name == "compute") {
+		compute();
+	}
+	else {
+		Log::error("BENCHMARK unknown benchmark '{}'", name);
+		return false;
+	}
+	return true;
+}
+
+
+bool Benchmark::needsContext(const std::string& name) {
+	return name == "compute";
+}
+
+
+void Benchmark::bezier() {
+	// The editor's sample count: every 0.01, plus the end point
+	const size_t samples = 101;
+	Log::info("BENCHMARK Bezier evaluation, {} samples per curve, ns per point (max error)", samples);
+
+	std::vector<float> us(samples);
+	for (size_t k = 0; k < samples; k++) {
+		us[k] = float(k) / float(samples - 1);
+	}
+
+	std::vector<glm::vec3> out(samples);
+	std::vector<glm::dvec3> reference(samples);
+	Bezier::UniformSampler sampler(samples);
+
+	for (size_t degree = 3; degree <= 20; degree++) {
+		std::vector<glm::vec3> points = randomPoints(degree + 1, 453 + unsigned(degree));
+		for (size_t k = 0; k < samples; k++) {
+			reference[k] = deCasteljauExact(points, us[k]);
+		}
+
+		// Keeps the optimizer from dropping the loops whose results go unused
+		volatile float sink = 0.0f;
+
+		double copyingNs = nanosecondsPerPoint(samples, [&] {
+			for (size_t k = 0; k < samples; k++) {
+				out[k] = deCasteljauCopying(points, us[k]);
+			}
+			sink = out[samples / 2].x;
+		});
+		double copyingError = maxError(out, reference);
+
+		double hornerNs = nanosecondsPerPoint(samples, [&] {
+			for (size_t k = 0; k < samples; k++) {
+				out[k] = Bezier::evaluate(points.data(), points.size(), us[k]);
+			}
+			sink = out[samples / 2].x;
+		});
+		double hornerError = maxError(out, reference);
+
+		double manyNs = nanosecondsPerPoint(samples, [&] {
+			Bezier::evaluateMany(points.data(), points.size(), us.data(), samples, out.data());
+			sink = out[samples / 2].x;
+		});
+		double manyError = maxError(out, reference);
+
+		double differenceNs = nanosecondsPerPoint(samples, [&] {
+			Bezier::forwardDifference(points.data(), points.size(), samples, out.data());
+			sink = out[samples / 2].x;
+		});
+		double differenceError = maxError(out, reference);
+
+		double tableNs = nanosecondsPerPoint(samples, [&] {
+			sampler.evaluate(points.data(), points.size(), out.data());
+			sink = out[samples / 2].x;
+		});
+		double tableError = maxError(out, reference);
+		(void)sink;
+
+		Log::info(
+			"degree {:>2}: de Casteljau (copying) {:6.1f} ({:.1e}), evaluate {:5.1f} ({:.1e}), evaluateMany {:5.1f} ({:.1e}), "
+			"forwardDifference {:5.1f} ({:.1e}), UniformSampler {:5.1f} ({:.1e}), {:4.1f}x faster",
+			degree, copyingNs, copyingError, hornerNs, hornerError, manyNs, manyError,
+			differenceNs, differenceError, tableNs, tableError, copyingNs / tableNs
+		);
+	}
+}
+
+
+void Benchmark::chaikin() {
+	const size_t count = 1000;
+	Log::info("BENCHMARK Chaikin subdivision of {} points, ms per curve", count);
+
+	std::vector<glm::vec3> points = randomPoints(count, 453);
+	std::vector<glm::vec3> out, scratch, scalarOut;
+
+	for (int iterations = 1; iterations <= 10; iterations++) {
+		// Fewer calls as the output doubles, about the same total work each
+		const int calls = std::max(1, 2048 >> iterations);
+
+		std::vector<glm::vec3> reference;
+		double recursiveMs = bestTimePerCall(calls, [&] {
+			reference = chaikinRecursive(points, iterations);
+		});
+		double scalarMs = bestTimePerCall(calls, [&] {
+			Chaikin::subdivideScalar(points.data(), points.size(), iterations, scalarOut, scratch);
+		});
+		double simdMs = bestTimePerCall(calls, [&] {
+			Chaikin::subdivide(points.data(), points.size(), iterations, out, scratch);
+		});
+
+		bool identical = out.size() == reference.size() && scalarOut.size() == reference.size()
+			&& std::equal(out.begin(), out.end(), reference.begin())
+			&& std::equal(scalarOut.begin(), scalarOut.end(), reference.begin());
+
+		Log::info(
+			"{:>2} iterations, {:>7} points: recursive {:8.3f}, ping-pong {:8.3f}, ping-pong SIMD {:8.3f} ({:4.1f}x), {}",
+			iterations, out.size(), recursiveMs, scalarMs, simdMs, recursiveMs / simdMs,
+			identical ? "identical" : "DIFFERENT"
+		);
+	}
+
+	// Dragging one point, with the rounds kept to redo just what it reaches
+	const int dragIterations = 8;
+	std::mt19937 rng(453);
+	for (size_t dragCount : { size_t(1000), size_t(10000), size_t(100000) }) {
+		std::vector<glm::vec3> dragPoints = randomPoints(dragCount, 453);
+		Chaikin::Refinement<glm::vec3> refinement;
+
+		double rebuildMs = bestTimePerCall(1, [&] {
+			refinement.rebuild(dragPoints.data(), dragPoints.size(), dragIterations);
+		});
+
+		size_t redone = 0;
+		const int moves = 1000;
+		double moveMs = bestTimePerCall(moves, [&] {
+			size_t index = rng() % dragCount;
+			dragPoints[index] = glm::vec3(float(rng() % 2000) / 1000.0f - 1.0f, dragPoints[index].y, 0.0f);
+			auto [first, last] = refinement.move(index, dragPoints[index]);
+			redone = std::max(redone, last - first);
+		});
+
+		Chaikin::subdivide(dragPoints.data(), dragPoints.size(), dragIterations, out, scratch);
+		bool identical = out == refinement.result();
+
+		Log::info(
+			"dragging 1 of {:>6} points, {} iterations, {:>8} points: rebuild {:8.3f}, local update {:6.3f} "
+			"(at most {} points, {:.0f}x), {}",
+			dragCount, dragIterations, out.size(), rebuildMs, moveMs, redone, rebuildMs / moveMs,
+			identical ? "identical" : "DIFFERENT"
+		);
+	}
+}
+
+
+void Benchmark::tensor() {
+	TensorSurface tensorSurface;
+	Log::info("BENCHMARK Tensor product surfaces, ms per surface, up to {} threads", tensorSurface.getThreadCount());
+
+	struct Case {
+		size_t size;
+		int iterations;
+		bool compare;		// the transposing version runs out of memory on the big ones
+	};
+	const Case cases[] = {
+		{ 5, 5, true }, { 64, 3, true }, { 256, 3, true }, { 1000, 1, true },
+		{ 1000, 2, false }, { 1000, 3, false }
+	};
+
+	Grid<glm::vec3> surface;
+	std::vector<GLuint> indices;
+	for (const Case& c : cases) {
+		std::vector<std::vector<glm::vec3>> rows = randomNet(c.size, 453 + unsigned(c.size));
+		Grid<glm::vec3> net = Grid<glm::vec3>::fromRows(rows);
+
+		// One call per run once the surfaces get big
+		const size_t cells = Chaikin::subdividedSize(c.size, c.iterations) * Chaikin::subdividedSize(c.size, c.iterations);
+		const int calls = int(std::max<size_t>(1, (size_t(1) << 22) / cells));
+
+		double gridMs = bestTimePerCall(calls, [&] {
+			tensorSurface.subdivide(net, c.iterations, surface);
+		});
+
+		if (!c.compare) {
+			Log::info(
+				"{:>4} x {:<4} net, {} iterations, {:>4} x {:<4} surface: transposing skipped, flat grid {:8.1f}",
+				c.size, c.size, c.iterations, surface.getRows(), surface.getColumns(), gridMs
+			);
+			continue;
+		}
+
+		double indexedMs = bestTimePerCall(calls, [&] {
+			tensorSurface.generate(net, c.iterations, surface, indices);
+		});
+
+		std::vector<glm::vec3> reference;
+		double transposingMs = bestTimePerCall(calls, [&] {
+			reference = tensorProductSurfaceTransposing(rows, c.iterations);
+		});
+
+		// The same triangles, corner for corner
+		bool identical = indices.size() == reference.size();
+		for (size_t k = 0; identical && k < indices.size(); k++) {
+			identical = surface.getCells()[indices[k]] == reference[k];
+		}
+		std::vector<glm::vec3>().swap(reference);
+
+		Log::info(
+			"{:>4} x {:<4} net, {} iterations, {:>4} x {:<4} surface: transposing {:8.1f}, flat grid {:8.1f}, "
+			"with indices {:8.1f} ({:5.1f}x), {}",
+			c.size, c.size, c.iterations, surface.getRows(), surface.getColumns(), transposingMs, gridMs,
+			indexedMs, transposingMs / indexedMs, identical ? "identical" : "DIFFERENT"
+		);
+	}
+}
+
+
+void Benchmark::picking() {
+	const float radius = 0.08f;
+	const int queries = 2000;
+	Log::info("BENCHMARK Control point picking, microseconds per query, average (99th percentile)");
+
+	std::mt19937 rng(453);
+	std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+
+	// The curve editor: the first point near the cursor, and the edits.
+	// Erasing renumbers every point after the erased one.
+	for (size_t count : { size_t(1000), size_t(100000), size_t(1000000) }) {
+		std::vector<glm::vec3> points = spiralPoints(count);
+		PointIndex index(radius);
+		double rebuildMs = bestTimePerCall(1, [&] {
+			index.rebuild(points);
+		});
+
+		Latency linear, indexed, moves, appends, erases;
+		bool identical = true;
+		for (int q = 0; q < queries; q++) {
+			glm::vec3 cursor(coord(rng), coord(rng), 0.0f);
+			int expected = linear.time([&] { return selectLinear(points, cursor, radius); });
+			int found = indexed.time([&] { return index.findFirstWithin(cursor, radius); });
+			identical = identical && found == expected;
+
+			size_t moved = rng() % points.size();
+			points[moved] = glm::vec3(coord(rng), coord(rng), 0.0f);
+			moves.time([&] { index.move(int(moved), points[moved]); return 0; });
+		}
+		for (int q = 0; q < 100; q++) {
+			points.push_back(glm::vec3(coord(rng), coord(rng), 0.0f));
+			appends.time([&] { index.insert(int(points.size()) - 1, points.back()); return 0; });
+			size_t erased = rng() % points.size();
+			points.erase(points.begin() + erased);
+			erases.time([&] { index.erase(int(erased)); return 0; });
+		}
+		for (int q = 0; q < 100; q++) {
+			glm::vec3 cursor(coord(rng), coord(rng), 0.0f);
+			identical = identical && index.findFirstWithin(cursor, radius) == selectLinear(points, cursor, radius);
+		}
+
+		Log::info(
+			"{:>7} editor points: rebuild {:7.1f} ms, pick linear {:7.1f} ({:7.1f}), indexed {:5.1f} ({:5.1f}), "
+			"move {:4.1f}, append {:4.1f}, erase {:7.1f}, {}",
+			count, rebuildMs, linear.average(), linear.p99(), indexed.average(), indexed.p99(),
+			moves.average(), appends.average(), erases.average(), identical ? "identical" : "DIFFERENT"
+		);
+	}
+
+	// Tensor nets in the orbit view: rays from around the net through it
+	const float pickRadius = 0.1f;
+	for (size_t size : { size_t(317), size_t(1000) }) {
+		std::uniform_real_distribution<float> height(-0.5f, 0.5f);
+		std::vector<glm::vec3> net;
+		net.reserve(size * size);
+		for (size_t i = 0; i < size; i++) {
+			for (size_t j = 0; j < size; j++) {
+				net.push_back(glm::vec3(4.0f * j / (size - 1) - 2.0f, height(rng), 4.0f * i / (size - 1) - 2.0f));
+			}
+		}
+		PointIndex index(pickRadius);
+		index.rebuild(net);
+
+		Latency linear, indexed;
+		bool identical = true;
+		int hits = 0;
+		for (int q = 0; q < queries; q++) {
+			// Half aimed at points, half at anywhere around the net
+			std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+			float yaw = angle(rng);
+			glm::vec3 camera(5.0f * std::cos(yaw), 1.0f + 3.0f * std::abs(coord(rng)), 5.0f * std::sin(yaw));
+			glm::vec3 target = q % 2 == 0 ? net[rng() % net.size()] : glm::vec3(3.0f * coord(rng), coord(rng), 3.0f * coord(rng));
+
+			int expected = linear.time([&] { return pickRayLinear(net, camera, target - camera, pickRadius); });
+			int found = indexed.time([&] { return index.pickRay(camera, target - camera, pickRadius); });
+			identical = identical && found == expected;
+			hits += found != -1;
+		}
+
+		Log::info(
+			"{:>4} x {:<4} net ({:>7} points): ray pick linear {:7.1f} ({:7.1f}), indexed {:5.1f} ({:5.1f}), {} of {} hit, {}",
+			size, size, net.size(), linear.average(), linear.p99(), indexed.average(), indexed.p99(),
+			hits, queries, identical ? "identical" : "DIFFERENT"
+		);
+	}
+}
+
+
+void Benchmark::compute() {
+	if (!ComputeSubdivision::isSupported()) {
+		Log::error("BENCHMARK compute shaders need OpenGL 4.3, this context is {}.{}", GLVersion.major, GLVersion.minor);
+		return;
+	}
+	Log::info("BENCHMARK Chaikin subdivision in a compute shader on {}, ms per curve or surface", (const char*)glGetString(GL_RENDERER));
+
+	ComputeSubdivision computeSubdivision;
+	VertexBufferHandle upload;
+	std::vector<glm::vec3> fromGPU;
+
+	// The CPU result still has to get to the GPU to be drawn
+	auto uploadToGPU = [&upload](const std::vector<glm::vec3>& points) {
+		glBindBuffer(GL_ARRAY_BUFFER, upload);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * points.size(), points.data(), GL_DYNAMIC_DRAW);
+		glFinish();
+	};
+
+	struct Case {
+		size_t size;
+		int iterations;
+	};
+
+	// The editor's B-splines take 8 rounds
+	const Case curves[] = { { 1000, 8 }, { 10000, 8 }, { 100000, 4 } };
+	std::vector<glm::vec3> out, scratch;
+	for (const Case& c : curves) {
+		std::vector<glm::vec3> points = randomPoints(c.size, 453);
+		const size_t finalCount = Chaikin::subdividedSize(c.size, c.iterations);
+		const int calls = int(std::max<size_t>(1, (size_t(1) << 22) / finalCount));
+
+		double cpuMs = bestTimePerCall(calls, [&] {
+			Chaikin::subdivide(points.data(), points.size(), c.iterations, out, scratch);
+		});
+		double cpuUploadMs = bestTimePerCall(calls, [&] {
+			Chaikin::subdivide(points.data(), points.size(), c.iterations, out, scratch);
+			uploadToGPU(out);
+		});
+		double gpuMs = bestTimePerCall(calls, [&] {
+			computeSubdivision.subdivide(points, c.iterations);
+			glFinish();
+		});
+
+		computeSubdivision.readBack(fromGPU);
+		Log::info(
+			"{:>7} point curve, {} iterations, {:>8} points: CPU {:8.2f}, CPU + upload {:8.2f}, compute {:8.2f} ({:5.1f}x), {}",
+			c.size, c.iterations, finalCount, cpuMs, cpuUploadMs, gpuMs, cpuUploadMs / gpuMs,
+			fromGPU == out ? "identical" : "DIFFERENT"
+		);
+	}
+
+	TensorSurface tensorSurface;
+	Grid<glm::vec3> surface;
+	const Case nets[] = { { 5, 5 }, { 64, 3 }, { 256, 3 }, { 1000, 1 } };
+	for (const Case& c : nets) {
+		Grid<glm::vec3> net = Grid<glm::vec3>::fromRows(randomNet(c.size, 453 + unsigned(c.size)));
+		const size_t cells = Chaikin::subdividedSize(c.size, c.iterations) * Chaikin::subdividedSize(c.size, c.iterations);
+		const int calls = int(std::max<size_t>(1, (size_t(1) << 22) / cells));
+
+		double cpuMs = bestTimePerCall(calls, [&] {
+			tensorSurface.subdivide(net, c.iterations, surface);
+		});
+		double cpuUploadMs = bestTimePerCall(calls, [&] {
+			tensorSurface.subdivide(net, c.iterations, surface);
+			uploadToGPU(surface.getCells());
+		});
+		double gpuMs = bestTimePerCall(calls, [&] {
+			computeSubdivision.subdivide(net, c.iterations);
+			glFinish();
+		});
+
+		computeSubdivision.readBack(fromGPU);
+		Log::info(
+			"{:>4} x {:<4} net, {} iterations, {:>4} x {:<4} surface: CPU {:8.2f} ({} threads), CPU + upload {:8.2f}, compute {:8.2f} ({:5.1f}x), {}",
+			c.size, c.size, c.iterations, surface.getRows(), surface.getColumns(), cpuMs, tensorSurface.getThreadCount(),
+			cpuUploadMs, gpuMs, cpuUploadMs / gpuMs, fromGPU == surface.getCells() ? "identical" : "DIFFERENT"
+		);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Headless micro-benchmarks for the curve and surface code.
+//
+// These never open a window, so they can be run on machines without a GPU:
+//
+// Example: 453-skeleton --bench=bezier
+//          453-skeleton --bench=chaikin
+//          453-skeleton --bench=tensor
+//          453-skeleton --bench=picking
+//
+// except for the compute shader one, which needs an OpenGL 4.3 context and
+// gets a hidden window for it (needsContext()):
+//
+// Example: 453-skeleton --bench=compute
+//------------------------------------------------------------------------------
+
+#include <string>
+
+
+namespace Benchmark {
+
+	// Runs the benchmark with the given name. Returns false if there is no such benchmark
+	bool run(const std::string& name);
+
+	// Whether the benchmark has to be run with a current OpenGL context
+	bool needsContext(const std::string& name);
+
+	// Every Bezier evaluation method against the copying de Casteljau the
+	// curve editor used to call, for degrees 3 to 20
+	void bezier();
+
+	// Chaikin::subdivide(), with and without SIMD, against the recursive
+	// version main.cpp used to have, on 1k point curves. Then redoing a
+	// whole curve against Chaikin::Refinement's local update, for dragging
+	// one point of curves up to 100k points long.
+	void chaikin();
+
+	// TensorSurface against the transposing version main.cpp used to have,
+	// from 5 x 5 nets up to 1000 x 1000
+	void tensor();
+
+	// PointIndex picking and edits against the linear scans, for curves and
+	// tensor nets up to a million control points
+	void picking();
+
+	// ComputeSubdivision against Chaikin::subdivide() and TensorSurface,
+	// each followed by the upload the CPU result needs before it can be
+	// drawn, for curves up to 100k points and nets up to 1000 x 1000.
+	// Times are to glFinish().
+	void compute();
+
+}
@@ -0,0 +1,307 @@
+#include "Bezier.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef BEZIER_HAS_SSE
+#include <emmintrin.h>
+#endif
+
+
+namespace {
+
+	// Horner's rule builds up binomial coefficients and powers of u, which
+	// run out of double range past about a thousand control points
+	constexpr size_t HORNER_MAX_POINTS = 1000;
+
+	// Single precision holds the binomials for evaluateMany() up to here
+	constexpr size_t SIMD_MAX_POINTS = 64;
+
+	// forwardDifference() keeps its difference table on the stack
+	constexpr size_t DIFFERENCE_MAX_POINTS = 32;
+
+	// Sum of C(n, i) u^i (1 - u)^(n - i) P_i, in the nested form
+	// ((P_0 s + C(n, 1) u P_1) s + C(n, 2) u^2 P_2) s + ... which needs no
+	// divisions and has no cancellation for u in [0, 1]
+	glm::dvec3 evaluateHorner(const glm::vec3* points, size_t count, double u) {
+		const size_t degree = count - 1;
+		const double s = 1.0 - u;
+		double power = 1.0;
+		double binomial = 1.0;
+		glm::dvec3 sum = glm::dvec3(points[0]) * s;
+		for (size_t i = 1; i < degree; i++) {
+			power *= u;
+			binomial = binomial * double(degree - i + 1) / double(i);
+			sum = (sum + power * binomial * glm::dvec3(points[i])) * s;
+		}
+		return sum + power * u * glm::dvec3(points[degree]);
+	}
+
+	// Weights below this fraction of the largest one don't register in double
+	constexpr double NEGLIGIBLE_WEIGHT = 1.0e-18;
+
+	// The same sum for curves too long for evaluateHorner(). The weights
+	// are a binomial distribution over i, peaked at i = n u and falling off
+	// fast to both sides, so this takes the peak weight in log space and
+	// walks outwards from it, by the ratio between neighbouring weights,
+	// until they stop registering: about sqrt(n) terms rather than n.
+	glm::dvec3 evaluateLog(const glm::vec3* points, size_t count, double u) {
+		const size_t degree = count - 1;
+		const double s = 1.0 - u;
+		const size_t peak = std::min(degree, size_t(double(degree + 1) * u));
+		const double peakWeight = std::exp(
+			std::lgamma(double(degree) + 1.0) - std::lgamma(double(peak) + 1.0) - std::lgamma(double(degree - peak) + 1.0)
+			+ double(peak) * std::log(u) + double(degree - peak) * std::log(s)
+		);
+
+		glm::dvec3 sum = peakWeight * glm::dvec3(points[peak]);
+		double weight = peakWeight;
+		for (size_t i = peak; i < degree && weight >= peakWeight * NEGLIGIBLE_WEIGHT; i++) {
+			weight *= double(degree - i) / double(i + 1) * u / s;
+			sum += weight * glm::dvec3(points[i + 1]);
+		}
+		weight = peakWeight;
+		for (size_t i = peak; i > 0 && weight >= peakWeight * NEGLIGIBLE_WEIGHT; i--) {
+			weight *= double(i) / double(degree - i + 1) * s / u;
+			sum += weight * glm::dvec3(points[i - 1]);
+		}
+		return sum;
+	}
+
+	glm::dvec3 evaluateDouble(const glm::vec3* points, size_t count, double u) {
+		if (count == 1 || u <= 0.0) {
+			return points[0];
+		}
+		if (u >= 1.0) {
+			return points[count - 1];
+		}
+		return count <= HORNER_MAX_POINTS ? evaluateHorner(points, count, u) : evaluateLog(points, count, u);
+	}
+
+	void evaluateManyScalar(const glm::vec3* points, size_t count, const float* us, size_t begin, size_t end, glm::vec3* out) {
+		for (size_t k = begin; k < end; k++) {
+			out[k] = Bezier::evaluate(points, count, us[k]);
+		}
+	}
+
+#ifdef BEZIER_HAS_SSE
+	// evaluateHorner() in single precision, for four parameters at once.
+	// binomials holds C(n, i) for the curve's degree n.
+	size_t evaluateManySSE(const glm::vec3* points, size_t count, const float* binomials, const float* us, size_t n, glm::vec3* out) {
+		const size_t degree = count - 1;
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		size_t k = 0;
+		for (; k + 4 <= n; k += 4) {
+			const __m128 u = _mm_loadu_ps(us + k);
+			const __m128 s = _mm_sub_ps(one, u);
+			__m128 power = one;
+			__m128 x = _mm_mul_ps(_mm_set1_ps(points[0].x), s);
+			__m128 y = _mm_mul_ps(_mm_set1_ps(points[0].y), s);
+			__m128 z = _mm_mul_ps(_mm_set1_ps(points[0].z), s);
+			for (size_t i = 1; i < degree; i++) {
+				power = _mm_mul_ps(power, u);
+				const __m128 weight = _mm_mul_ps(power, _mm_set1_ps(binomials[i]));
+				x = _mm_mul_ps(_mm_add_ps(x, _mm_mul_ps(weight, _mm_set1_ps(points[i].x))), s);
+				y = _mm_mul_ps(_mm_add_ps(y, _mm_mul_ps(weight, _mm_set1_ps(points[i].y))), s);
+				z = _mm_mul_ps(_mm_add_ps(z, _mm_mul_ps(weight, _mm_set1_ps(points[i].z))), s);
+			}
+			const __m128 last = _mm_mul_ps(power, u);
+			x = _mm_add_ps(x, _mm_mul_ps(last, _mm_set1_ps(points[degree].x)));
+			y = _mm_add_ps(y, _mm_mul_ps(last, _mm_set1_ps(points[degree].y)));
+			z = _mm_add_ps(z, _mm_mul_ps(last, _mm_set1_ps(points[degree].z)));
+
+			alignas(16) float xs[4], ys[4], zs[4];
+			_mm_store_ps(xs, x);
+			_mm_store_ps(ys, y);
+			_mm_store_ps(zs, z);
+			for (int lane = 0; lane < 4; lane++) {
+				out[k + lane] = glm::vec3(xs[lane], ys[lane], zs[lane]);
+			}
+		}
+		return k;
+	}
+#endif
+
+}
+
+
+glm::vec3 Bezier::evaluate(const glm::vec3* points, size_t count, float u) {
+	if (count == 0) {
+		return glm::vec3(0.0f);
+	}
+	return glm::vec3(evaluateDouble(points, count, u));
+}
+
+
+void Bezier::evaluateMany(const glm::vec3* points, size_t count, const float* us, size_t n, glm::vec3* out) {
+	size_t done = 0;
+#ifdef BEZIER_HAS_SSE
+	if (count >= 2 && count <= SIMD_MAX_POINTS) {
+		float binomials[SIMD_MAX_POINTS];
+		binomials[0] = 1.0f;
+		double binomial = 1.0;
+		for (size_t i = 1; i < count; i++) {
+			binomial = binomial * double(count - i) / double(i);
+			binomials[i] = float(binomial);
+		}
+		done = evaluateManySSE(points, count, binomials, us, n, out);
+	}
+#endif
+	evaluateManyScalar(points, count, us, done, n, out);
+}
+
+
+void Bezier::forwardDifference(const glm::vec3* points, size_t count, size_t samples, glm::vec3* out) {
+	if (samples == 0) {
+		return;
+	}
+	if (count == 0 || samples == 1 || count > DIFFERENCE_MAX_POINTS) {
+		for (size_t k = 0; k < samples; k++) {
+			out[k] = evaluate(points, count, samples == 1 ? 0.0f : float(k) / float(samples - 1));
+		}
+		return;
+	}
+
+	const size_t degree = count - 1;
+	const double step = 1.0 / double(samples - 1);
+
+	// Power basis coefficients of f(k) = curve(k * step): the m-th is
+	// C(n, m) step^m times the m-th difference of the control points
+	glm::dvec3 coefficients[DIFFERENCE_MAX_POINTS];
+	for (size_t i = 0; i < count; i++) {
+		coefficients[i] = points[i];
+	}
+	for (size_t m = 1; m < count; m++) {
+		for (size_t i = degree; i >= m; i--) {
+			coefficients[i] -= coefficients[i - 1];
+		}
+	}
+	double binomial = 1.0;
+	double stepPower = 1.0;
+	for (size_t m = 1; m < count; m++) {
+		binomial = binomial * double(degree - m + 1) / double(m);
+		stepPower *= step;
+		coefficients[m] *= binomial * stepPower;
+	}
+
+	// Starting differences straight from the coefficients: the k-th
+	// difference of x^m at 0 is k! S(m, k), with S the Stirling numbers of
+	// the second kind. All positive, so unlike differencing sampled values
+	// this adds no cancellation of its own.
+	glm::dvec3 differences[DIFFERENCE_MAX_POINTS];
+	double stirling[DIFFERENCE_MAX_POINTS] = { 1.0 };		// S(m, k) for the current m
+	for (size_t k = 0; k < count; k++) {
+		differences[k] = glm::dvec3(0.0);
+	}
+	for (size_t m = 0; m < count; m++) {
+		if (m > 0) {
+			for (size_t k = m; k >= 1; k--) {
+				stirling[k] = double(k) * stirling[k] + stirling[k - 1];
+			}
+			stirling[0] = 0.0;
+		}
+		for (size_t k = 0; k <= m; k++) {
+			differences[k] += stirling[k] * coefficients[m];
+		}
+	}
+	double factorial = 1.0;
+	for (size_t k = 1; k < count; k++) {
+		factorial *= double(k);
+		differences[k] *= factorial;
+	}
+
+	for (size_t k = 0; k < samples; k++) {
+		out[k] = glm::vec3(differences[0]);
+		for (size_t d = 0; d < degree; d++) {
+			differences[d] += differences[d + 1];
+		}
+	}
+}
+
+
+Bezier::UniformSampler::UniformSampler(size_t samples)
+	: samples(samples)
+{}
+
+
+void Bezier::UniformSampler::evaluate(const glm::vec3* points, size_t count, glm::vec3* out) {
+	if (count == 0 || samples == 0) {
+		return;
+	}
+
+	const float step = samples > 1 ? 1.0f / float(samples - 1) : 0.0f;
+	if (count > MAX_TABLE_POINTS) {
+		// A block of parameters at a time, so there is nothing to allocate
+		float us[64];
+		for (size_t begin = 0; begin < samples; begin += 64) {
+			const size_t n = std::min<size_t>(64, samples - begin);
+			for (size_t k = 0; k < n; k++) {
+				us[k] = float(begin + k) * step;
+			}
+			evaluateMany(points, count, us, n, out + begin);
+		}
+		return;
+	}
+
+	if (count != tableCount) {
+		buildTable(count);
+	}
+
+	const size_t blocks = (samples + 3) / 4;
+	for (size_t block = 0; block < blocks; block++) {
+		const float* w = weights.data() + block * count * 4;
+		const size_t lanes = std::min<size_t>(4, samples - block * 4);
+		glm::vec3* blockOut = out + block * 4;
+
+#ifdef BEZIER_HAS_SSE
+		__m128 x = _mm_setzero_ps();
+		__m128 y = _mm_setzero_ps();
+		__m128 z = _mm_setzero_ps();
+		for (size_t i = 0; i < count; i++) {
+			const __m128 weight = _mm_loadu_ps(w + i * 4);
+			x = _mm_add_ps(x, _mm_mul_ps(weight, _mm_set1_ps(points[i].x)));
+			y = _mm_add_ps(y, _mm_mul_ps(weight, _mm_set1_ps(points[i].y)));
+			z = _mm_add_ps(z, _mm_mul_ps(weight, _mm_set1_ps(points[i].z)));
+		}
+		alignas(16) float xs[4], ys[4], zs[4];
+		_mm_store_ps(xs, x);
+		_mm_store_ps(ys, y);
+		_mm_store_ps(zs, z);
+		for (size_t lane = 0; lane < lanes; lane++) {
+			blockOut[lane] = glm::vec3(xs[lane], ys[lane], zs[lane]);
+		}
+#else
+		for (size_t lane = 0; lane < lanes; lane++) {
+			glm::vec3 sum(0.0f);
+			for (size_t i = 0; i < count; i++) {
+				sum += w[i * 4 + lane] * points[i];
+			}
+			blockOut[lane] = sum;
+		}
+#endif
+	}
+}
+
+
+void Bezier::UniformSampler::buildTable(size_t count) {
+	const size_t blocks = (samples + 3) / 4;
+	weights.assign(blocks * count * 4, 0.0f);
+	tableCount = count;
+
+	// C(n, i) u^i (1 - u)^(n - i), in double so the table is as good as
+	// single precision gets. Only runs when the point count changes.
+	const size_t degree = count - 1;
+	for (size_t k = 0; k < samples; k++) {
+		const double u = samples > 1 ? double(k) / double(samples - 1) : 0.0;
+		const double s = 1.0 - u;
+		double binomial = 1.0;
+		for (size_t i = 0; i < count; i++) {
+			if (i > 0) {
+				binomial = binomial * double(degree - i + 1) / double(i);
+			}
+			double weight = binomial * std::pow(u, double(i)) * std::pow(s, double(degree - i));
+			weights[((k / 4) * count + i) * 4 + k % 4] = float(weight);
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Bezier curve evaluation that never allocates on the heap.
+//
+// There are a few ways in, depending on what is being sampled:
+//
+//   evaluate()          one parameter. Bernstein form Horner's rule in double
+//                       precision, O(n) per point where de Casteljau is O(n^2)
+//                       and needs a scratch copy of the control points.
+//   evaluateMany()      many arbitrary parameters, four at a time with SSE.
+//   forwardDifference() evenly spaced parameters from 0 to 1, n additions per
+//                       point after an O(n^2) setup. Kept in double, since
+//                       forward differencing piles up rounding error fast.
+//   UniformSampler      evenly spaced parameters, for a curve that changes
+//                       every frame: a table of Bernstein weights for the
+//                       samples, built once per control point count, so each
+//                       point is one weighted sum, four samples at a time.
+//
+// Sample counts include both ends, so the curve starts on the first control
+// point and finishes on the last one.
+//
+// Example: Bezier::UniformSampler sampler(101);
+//          std::vector<glm::vec3> curve(sampler.getSampleCount());
+//          sampler.evaluate(controlPoints.data(), controlPoints.size(), curve.data());
+//------------------------------------------------------------------------------
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BEZIER_HAS_SSE
+#endif
+
+
+namespace Bezier {
+
+	// The point at u of the curve with count control points
+	glm::vec3 evaluate(const glm::vec3* points, size_t count, float u);
+
+	// out[i] = evaluate(points, count, us[i]) for i < n
+	void evaluateMany(const glm::vec3* points, size_t count, const float* us, size_t n, glm::vec3* out);
+
+	// samples points at u = 0, 1/(samples - 1), ..., 1
+	void forwardDifference(const glm::vec3* points, size_t count, size_t samples, glm::vec3* out);
+
+
+	class UniformSampler {
+
+	public:
+		// Curves with more control points than this skip the table, which
+		// would be count * samples floats, and use evaluateMany() instead
+		static constexpr size_t MAX_TABLE_POINTS = 64;
+
+		explicit UniformSampler(size_t samples);
+
+		// Writes getSampleCount() points to out. Rebuilds the table if count
+		// changed since the last call, which only allocates if it grew.
+		void evaluate(const glm::vec3* points, size_t count, glm::vec3* out);
+
+		size_t getSampleCount() const { return samples; }
+
+	private:
+		size_t samples;
+		size_t tableCount = 0;		// control point count the table was built for
+
+		// Bernstein weights in blocks of four samples: block b, control
+		// point i, lane l is at (b * tableCount + i) * 4 + l. Lanes past the
+		// last sample are zero.
+		std::vector<float> weights;
+
+		void buildTable(size_t count);
+	};
+
+}
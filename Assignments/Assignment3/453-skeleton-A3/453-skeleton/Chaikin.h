@@ -0,0 +1,297 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Chaikin's corner cutting, for open curves of any point type.
+//
+// Every round replaces each interior leg of the polygon with the points a
+// quarter and three quarters of the way along it, and keeps the two end
+// points, with the legs next to them cut in half instead. The polygon
+// converges to the uniform quadratic B-spline pinned to the end points.
+//
+// The number of points after each round is known up front (n becomes
+// 2n - 2), so both buffers are sized once and the rounds ping-pong between
+// them: no recursion, no push_back, and no copies beyond the rounds
+// themselves. Pass the same out and scratch vectors every time and nothing
+// is allocated once they are big enough.
+//
+// For glm::vec3 the interior masks run four floats at a time with SSE, a
+// point plus the x of the next one. The results are the same to the bit as
+// subdivideScalar(), since both do the same multiplies and adds.
+//
+// Every point depends on only two points of the round before, so moving one
+// control point changes only a short stretch of the result. Refinement keeps
+// every round around to redo just that stretch.
+//
+// Example: std::vector<glm::vec3> curve, scratch;
+//          Chaikin::subdivide(controlPoints.data(), controlPoints.size(), 8, curve, scratch);
+//------------------------------------------------------------------------------
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CHAIKIN_HAS_SSE
+#include <emmintrin.h>
+#endif
+
+
+namespace Chaikin {
+
+	// Points after one round on count points. Two points make four, with
+	// the middle one twice, like the original recursive version did.
+	inline size_t nextSize(size_t count) {
+		return count == 2 ? 4 : 2 * count - 2;
+	}
+
+	// Points after `iterations` rounds
+	inline size_t subdividedSize(size_t count, int iterations) {
+		if (count < 2) {
+			return count;
+		}
+		for (int i = 0; i < iterations; i++) {
+			count = nextSize(count);
+		}
+		return count;
+	}
+
+	namespace detail {
+
+		// The interior masks, points 2 to 2n - 5 of the result
+		template <typename Point>
+		void interiorScalar(const Point* coarse, size_t count, Point* fine) {
+			for (size_t i = 1; i + 2 < count; i++) {
+				fine[2 * i] = 0.75f * coarse[i] + 0.25f * coarse[i + 1];
+				fine[2 * i + 1] = 0.25f * coarse[i] + 0.75f * coarse[i + 1];
+			}
+		}
+
+#ifdef CHAIKIN_HAS_SSE
+		// interiorScalar() for glm::vec3. Each load and store covers a point
+		// and the x after it. The loads stay in bounds because the last leg
+		// is never interior, and the store that spills into the next point
+		// is overwritten by that point's own store, or by the end mask.
+		inline void interiorSSE(const glm::vec3* coarse, size_t count, glm::vec3* fine) {
+			const __m128 threeQuarters = _mm_set1_ps(0.75f);
+			const __m128 quarter = _mm_set1_ps(0.25f);
+			const float* c = &coarse[0].x;
+			float* f = &fine[0].x;
+			for (size_t i = 1; i + 2 < count; i++) {
+				const __m128 p = _mm_loadu_ps(c + 3 * i);
+				const __m128 q = _mm_loadu_ps(c + 3 * i + 3);
+				_mm_storeu_ps(f + 6 * i, _mm_add_ps(_mm_mul_ps(threeQuarters, p), _mm_mul_ps(quarter, q)));
+				_mm_storeu_ps(f + 6 * i + 3, _mm_add_ps(_mm_mul_ps(quarter, p), _mm_mul_ps(threeQuarters, q)));
+			}
+		}
+#endif
+
+		// One round from coarse into fine, which must have room for nextSize(count)
+		template <typename Point, bool UseSIMD>
+		void round(const Point* coarse, size_t count, Point* fine) {
+			const size_t fineCount = nextSize(count);
+
+#ifdef CHAIKIN_HAS_SSE
+			if constexpr (UseSIMD && std::is_same_v<Point, glm::vec3> && sizeof(glm::vec3) == 3 * sizeof(float)) {
+				interiorSSE(coarse, count, fine);
+			}
+			else {
+				interiorScalar(coarse, count, fine);
+			}
+#else
+			interiorScalar(coarse, count, fine);
+#endif
+
+			// The end masks, written last so they win over any spill
+			fine[0] = coarse[0];
+			fine[1] = 0.5f * coarse[0] + 0.5f * coarse[1];
+			fine[fineCount - 2] = 0.5f * coarse[count - 2] + 0.5f * coarse[count - 1];
+			fine[fineCount - 1] = coarse[count - 1];
+		}
+
+		template <typename Point, bool UseSIMD>
+		void subdivide(const Point* coarse, size_t count, int iterations, std::vector<Point>& out, std::vector<Point>& scratch) {
+			const size_t finalCount = subdividedSize(count, iterations);
+			if (count < 2 || iterations <= 0) {
+				out.assign(coarse, coarse + count);
+				return;
+			}
+
+			// Start in whichever buffer makes the last round land in out
+			out.resize(finalCount);
+			scratch.resize(finalCount);
+			Point* fine = iterations % 2 == 1 ? out.data() : scratch.data();
+			Point* other = iterations % 2 == 1 ? scratch.data() : out.data();
+
+			round<Point, UseSIMD>(coarse, count, fine);
+			count = nextSize(count);
+			for (int i = 1; i < iterations; i++) {
+				std::swap(fine, other);
+				round<Point, UseSIMD>(other, count, fine);
+				count = nextSize(count);
+			}
+		}
+
+	}
+
+	// `iterations` rounds on count points into out, using scratch for the
+	// rounds in between. out and scratch must be different vectors, and
+	// neither may hold the input.
+	template <typename Point>
+	void subdivide(const Point* coarse, size_t count, int iterations, std::vector<Point>& out, std::vector<Point>& scratch) {
+		detail::subdivide<Point, true>(coarse, count, iterations, out, scratch);
+	}
+
+	// subdivide() without SIMD, as the reference it must match
+	template <typename Point>
+	void subdivideScalar(const Point* coarse, size_t count, int iterations, std::vector<Point>& out, std::vector<Point>& scratch) {
+		detail::subdivide<Point, false>(coarse, count, iterations, out, scratch);
+	}
+
+	// subdivide() with no second buffer, on anything indexed like an array:
+	// a pointer, or a row or column of a Grid. The first count points are
+	// the input, and there must be room for subdividedSize(count, iterations).
+	//
+	// width > 1 subdivides that many sequences side by side, the ones that
+	// start at &points[0] + 1, &points[0] + 2 and so on: neighbouring columns
+	// of a Grid, say. Going along a row of them at a time reads memory in
+	// order, where one column on its own jumps a whole row every point.
+	//
+	// Each round runs from the back, where point i only lands on 2i or
+	// later, so nothing is overwritten before it is read. Same masks in the
+	// same order as subdivideScalar(), so the same results to the bit.
+	template <typename Points>
+	void subdivideInPlace(Points points, size_t count, int iterations, size_t width = 1) {
+		if (count < 2) {
+			return;
+		}
+		for (int round = 0; round < iterations; round++) {
+			const size_t fineCount = nextSize(count);
+			{
+				auto* coarse = &points[count - 2];
+				auto* coarseLast = &points[count - 1];
+				auto* fine = &points[fineCount - 2];
+				auto* fineLast = &points[fineCount - 1];
+				for (size_t lane = 0; lane < width; lane++) {
+					const auto last = coarseLast[lane];
+					const auto beforeLast = 0.5f * coarse[lane] + 0.5f * coarseLast[lane];
+					fineLast[lane] = last;
+					fine[lane] = beforeLast;
+				}
+			}
+			for (size_t i = count - 2; i-- > 1;) {
+				auto* p = &points[i];
+				auto* q = &points[i + 1];
+				auto* fine = &points[2 * i];
+				auto* fineNext = &points[2 * i + 1];
+				for (size_t lane = 0; lane < width; lane++) {
+					const auto threeQuarters = 0.75f * p[lane] + 0.25f * q[lane];
+					const auto quarter = 0.25f * p[lane] + 0.75f * q[lane];
+					fine[lane] = threeQuarters;
+					fineNext[lane] = quarter;
+				}
+			}
+			auto* first = &points[0];
+			auto* second = &points[1];
+			for (size_t lane = 0; lane < width; lane++) {
+				second[lane] = 0.5f * first[lane] + 0.5f * second[lane];
+			}
+			count = fineCount;
+		}
+	}
+
+	// Point j of a round on coarse's count points, on its own
+	template <typename Point>
+	Point finePoint(const Point* coarse, size_t count, size_t j) {
+		const size_t fineCount = nextSize(count);
+		if (j == 0) {
+			return coarse[0];
+		}
+		if (j == 1) {
+			return 0.5f * coarse[0] + 0.5f * coarse[1];
+		}
+		if (j == fineCount - 1) {
+			return coarse[count - 1];
+		}
+		if (j == fineCount - 2) {
+			return 0.5f * coarse[count - 2] + 0.5f * coarse[count - 1];
+		}
+		const size_t i = j / 2;
+		return j % 2 == 0 ? 0.75f * coarse[i] + 0.25f * coarse[i + 1] : 0.25f * coarse[i] + 0.75f * coarse[i + 1];
+	}
+
+	// The points of the next round that points [first, last) of this one
+	// reach: j depends on j / 2 and the one after, so point i reaches 2i - 2
+	// to 2i + 1. Two points make four that all depend on both.
+	inline std::pair<size_t, size_t> reach(size_t count, size_t first, size_t last) {
+		const size_t fineCount = nextSize(count);
+		if (count == 2) {
+			return { 0, fineCount };
+		}
+		return { first < 1 ? 0 : 2 * first - 2, std::min(fineCount, 2 * last) };
+	}
+
+	// subdivide() that remembers every round, so moving a control point
+	// redoes only the points it reaches: about 4 * 2^iterations of them,
+	// however long the curve. The results are the same to the bit as doing
+	// it all again.
+	//
+	// Example: Chaikin::Refinement<glm::vec3> curve;
+	//          curve.rebuild(points.data(), points.size(), 8);
+	//          auto [first, last] = curve.move(3, newPosition);
+	//          ... upload curve.result()[first, last) ...
+	template <typename Point>
+	class Refinement {
+
+	public:
+		// Subdivides from scratch. The round buffers keep their memory.
+		void rebuild(const Point* coarse, size_t count, int iterations) {
+			const int rounds = count < 2 ? 0 : std::max(iterations, 0);
+			levels.resize(size_t(rounds) + 1);
+			levels[0].assign(coarse, coarse + count);
+			for (int r = 0; r < rounds; r++) {
+				levels[r + 1].resize(nextSize(levels[r].size()));
+				detail::round<Point, true>(levels[r].data(), levels[r].size(), levels[r + 1].data());
+			}
+		}
+
+		// Moves control point index to position and redoes what it reaches.
+		// Returns the stretch [first, last) of result() that was redone.
+		std::pair<size_t, size_t> move(size_t index, const Point& position) {
+			levels[0][index] = position;
+			size_t first = index;
+			size_t last = index + 1;
+			for (size_t r = 0; r + 1 < levels.size(); r++) {
+				const std::vector<Point>& coarse = levels[r];
+				std::vector<Point>& fine = levels[r + 1];
+				std::tie(first, last) = reach(coarse.size(), first, last);
+				for (size_t j = first; j < last; j++) {
+					fine[j] = finePoint(coarse.data(), coarse.size(), j);
+				}
+			}
+			return { first, last };
+		}
+
+		const std::vector<Point>& result() const { return levels.back(); }
+		size_t getControlPointCount() const { return levels.empty() ? 0 : levels[0].size(); }
+		int getIterations() const { return levels.empty() ? 0 : int(levels.size()) - 1; }
+
+	private:
+		// The control points, then every round after them
+		std::vector<std::vector<Point>> levels;
+	};
+
+	// For one-off use, where keeping buffers around isn't worth it
+	template <typename Point>
+	std::vector<Point> subdivide(const std::vector<Point>& coarse, int iterations) {
+		std::vector<Point> out;
+		std::vector<Point> scratch;
+		subdivide(coarse.data(), coarse.size(), iterations, out, scratch);
+		return out;
+	}
+
+}
@@ -0,0 +1,135 @@
+#include "ComputeSubdivision.h"
+
+#include "Chaikin.h"
+#include "RenderStats.h"
+
+#include <algorithm>
+
+
+namespace {
+
+	// Must match local_size_x in chaikin.comp
+	constexpr GLuint GROUP_SIZE = 64;
+
+}
+
+
+ComputeSubdivision::ComputeSubdivision()
+	: program("shaders/chaikin.comp")
+	, triangulator()
+	, vao()
+{}
+
+
+bool ComputeSubdivision::isSupported() {
+	return GLAD_GL_VERSION_4_3 != 0;
+}
+
+
+void ComputeSubdivision::subdivide(const std::vector<glm::vec3>& curve, int iterations) {
+	subdivide(curve.data(), curve.empty() ? 0 : 1, curve.size(), iterations);
+}
+
+
+void ComputeSubdivision::subdivide(const Grid<glm::vec3>& net, int iterations) {
+	subdivide(net.getCells().data(), net.getRows(), net.getColumns(), iterations);
+}
+
+
+void ComputeSubdivision::subdivide(const glm::vec3* points, size_t netRows, size_t netColumns, int iterations) {
+	iterations = std::max(iterations, 0);
+	rows = Chaikin::subdividedSize(netRows, iterations);
+	columns = Chaikin::subdividedSize(netColumns, iterations);
+
+	const GLsizeiptr controlBytes = GLsizeiptr(sizeof(glm::vec3) * netRows * netColumns);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, controlPoints);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, controlBytes, points, GL_DYNAMIC_DRAW);
+	RenderStats::countUpload(controlBytes);
+
+	// Every round's output fits in the last one's
+	if (rows * columns > capacity) {
+		capacity = rows * columns;
+		for (VertexBufferHandle& buffer : pingPong) {
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(sizeof(glm::vec3) * capacity), nullptr, GL_DYNAMIC_COPY);
+		}
+	}
+
+	program.use();
+	GLuint from = controlPoints;
+	int next = 0;
+
+	// Along the rows, each one a line of points one apart
+	size_t count = netColumns;
+	for (int i = 0; i < iterations && count >= 2; i++) {
+		const size_t fineCount = Chaikin::nextSize(count);
+		round(from, pingPong[next], GLuint(count), GLuint(netRows), glm::uvec2(1, count), glm::uvec2(1, fineCount));
+		from = pingPong[next];
+		next = 1 - next;
+		count = fineCount;
+	}
+
+	// Down the columns, each one a line of points a row apart
+	count = netRows;
+	for (int i = 0; i < iterations && count >= 2; i++) {
+		round(from, pingPong[next], GLuint(count), GLuint(columns), glm::uvec2(columns, 1), glm::uvec2(columns, 1));
+		from = pingPong[next];
+		next = 1 - next;
+		count = Chaikin::nextSize(count);
+	}
+	result = from;
+
+	// The positions come from wherever the last round left them, once it is done
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+	vao.bind();
+	glBindBuffer(GL_ARRAY_BUFFER, result);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+	glEnableVertexAttribArray(0);
+}
+
+
+void ComputeSubdivision::round(GLuint from, GLuint to, GLuint count, GLuint lines, glm::uvec2 fromStrides, glm::uvec2 toStrides) {
+	const GLuint fineCount = GLuint(Chaikin::nextSize(count));
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, from);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, to);
+	glUniform1ui(glGetUniformLocation(program, "count"), count);
+	glUniform1ui(glGetUniformLocation(program, "lines"), lines);
+	glUniform2ui(glGetUniformLocation(program, "coarseStrides"), fromStrides.x, fromStrides.y);
+	glUniform2ui(glGetUniformLocation(program, "fineStrides"), toStrides.x, toStrides.y);
+	glDispatchCompute((fineCount + GROUP_SIZE - 1) / GROUP_SIZE, lines, 1);
+
+	// The next round reads what this one wrote
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+
+void ComputeSubdivision::drawLineStrip() {
+	vao.bind();
+	glDrawArrays(GL_LINE_STRIP, 0, GLsizei(rows * columns));
+	RenderStats::countDrawCall();
+}
+
+
+void ComputeSubdivision::drawTriangles() {
+	vao.bind();
+	if (trianglesFor[0] != rows || trianglesFor[1] != columns) {
+		std::vector<GLuint> indices;
+		triangulator.triangulate(rows, columns, indices);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangles);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
+		RenderStats::countUpload(sizeof(GLuint) * indices.size());
+		triangleIndexCount = indices.size();
+		trianglesFor[0] = rows;
+		trianglesFor[1] = columns;
+	}
+	glDrawElements(GL_TRIANGLES, GLsizei(triangleIndexCount), GL_UNSIGNED_INT, 0);
+	RenderStats::countDrawCall();
+}
+
+
+void ComputeSubdivision::readBack(std::vector<glm::vec3>& out) {
+	out.resize(rows * columns);
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, result);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, GLsizeiptr(sizeof(glm::vec3) * out.size()), out.data());
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Chaikin subdivision of curves and tensor product nets in a compute shader
+// (OpenGL 4.3 and up), drawn straight from where the last round leaves it.
+//
+// Only the control points are uploaded. Each round reads one shader storage
+// buffer and writes the other, then they swap, like Chaikin::subdivide's
+// ping-pong between out and scratch; a net goes along its rows first and
+// then down its columns, like TensorSurface. The buffer the last round
+// wrote is then bound as the vertex positions, so the result never comes
+// back to the CPU. Both buffers only ever grow, so redoing a curve of the
+// same size or smaller allocates nothing.
+//
+// The shader does the same multiplies and adds as the CPU code, so the
+// points come out the same to the bit (see --bench=compute).
+//
+// Draw with a program whose positions are at location 0; the colour and
+// normal attributes are left off, at their defaults of zero.
+//
+// Example: ComputeSubdivision subdivision;
+//          subdivision.subdivide(net, 3);
+//          ... use a shader program ...
+//          subdivision.drawTriangles();
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "Grid.h"
+#include "ShaderProgram.h"
+#include "TensorSurface.h"
+#include "VertexArray.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+class ComputeSubdivision {
+
+public:
+	ComputeSubdivision();
+
+	// Whether the current context has compute shaders
+	static bool isSupported();
+
+	// A curve is subdivided as a grid of one row
+	void subdivide(const std::vector<glm::vec3>& curve, int iterations);
+	void subdivide(const Grid<glm::vec3>& net, int iterations);
+
+	void drawLineStrip();
+	void drawTriangles();			// two per grid square, as TensorSurface makes them
+
+	// Copies the result back, for checking it against the CPU
+	void readBack(std::vector<glm::vec3>& out);
+
+	size_t getRows() const { return rows; }
+	size_t getColumns() const { return columns; }
+
+private:
+	ShaderProgram program;
+	TensorSurface triangulator;
+
+	VertexArray vao;
+	VertexBufferHandle controlPoints;
+	VertexBufferHandle pingPong[2];
+	VertexBufferHandle triangles;
+
+	size_t capacity = 0;							// points each ping-pong buffer has room for
+	GLuint result = 0;								// the buffer the last round wrote to
+	size_t rows = 0;
+	size_t columns = 0;
+	size_t triangleIndexCount = 0;
+	size_t trianglesFor[2] = { 0, 0 };
+
+	void subdivide(const glm::vec3* points, size_t netRows, size_t netColumns, int iterations);
+	void round(GLuint from, GLuint to, GLuint count, GLuint lines, glm::uvec2 fromStrides, glm::uvec2 toStrides);
+};
@@ -0,0 +1,122 @@
+#include "CurveFlattener.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+
+
+void CurveFlattener::flattenBezier(const glm::vec3* points, size_t count, const glm::mat4& toPixels, float tolerance, std::vector<glm::vec3>& out) {
+	out.clear();
+	if (count == 0) {
+		return;
+	}
+	out.push_back(points[0]);
+	if (count > 1) {
+		flattenPiece(points, count, toPixels, tolerance, out);
+	}
+}
+
+
+void CurveFlattener::flattenBSpline(const glm::vec3* points, size_t count, const glm::mat4& toPixels, float tolerance, std::vector<glm::vec3>& out) {
+	out.clear();
+	if (count < 3) {
+		out.assign(points, points + count);
+		return;
+	}
+
+	// Span i runs from the middle of the i-th leg of the control polygon to
+	// the middle of the next one, with the corner between them as its
+	// middle control point. The first and last spans reach out to the ends.
+	out.push_back(points[0]);
+	for (size_t i = 0; i + 2 < count; i++) {
+		glm::vec3 span[3] = {
+			i == 0 ? points[0] : 0.5f * (points[i] + points[i + 1]),
+			points[i + 1],
+			i + 3 == count ? points[count - 1] : 0.5f * (points[i + 1] + points[i + 2])
+		};
+		flattenPiece(span, 3, toPixels, tolerance, out);
+	}
+}
+
+
+glm::mat4 CurveFlattener::toPixels(const glm::mat4& viewProjection, int width, int height) {
+	glm::mat4 viewport = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f * width, 0.5f * height, 0.0f));
+	viewport = glm::scale(viewport, glm::vec3(0.5f * width, 0.5f * height, 1.0f));
+	return viewport * viewProjection;
+}
+
+
+void CurveFlattener::flattenPiece(const glm::vec3* points, size_t count, const glm::mat4& toPixels, float tolerance, std::vector<glm::vec3>& out) {
+	// Depth first, left half before right, so the strip comes out in order.
+	// Depth only grows up the stack, so it never holds more than
+	// MAX_DEPTH + 1 pieces.
+	const size_t slots = MAX_DEPTH + 1;
+	if (pieces.size() < slots * count) {
+		pieces.resize(slots * count);
+	}
+	depths.resize(slots);
+
+	std::copy(points, points + count, pieces.begin());
+	depths[0] = 0;
+	int top = 0;
+
+	while (top >= 0) {
+		glm::vec3* piece = pieces.data() + top * count;
+		if (depths[top] >= MAX_DEPTH || isFlat(piece, count, toPixels, tolerance)) {
+			out.push_back(piece[count - 1]);
+			top--;
+			continue;
+		}
+
+		// de Casteljau at 0.5, in place: the piece turns into its right half
+		// while the first point of every level makes up the left half,
+		// which goes on top
+		glm::vec3* left = piece + count;
+		left[0] = piece[0];
+		for (size_t level = 1; level < count; level++) {
+			for (size_t j = 0; j + level < count; j++) {
+				piece[j] = 0.5f * (piece[j] + piece[j + 1]);
+			}
+			left[level] = piece[0];
+		}
+		depths[top]++;
+		depths[top + 1] = depths[top];
+		top++;
+	}
+}
+
+
+bool CurveFlattener::isFlat(const glm::vec3* points, size_t count, const glm::mat4& toPixels, float tolerance) {
+	// Window coordinates, or false for points behind the camera, which
+	// have no place on screen to measure
+	auto project = [&toPixels](const glm::vec3& p, glm::vec2& pixel) {
+		glm::vec4 clip = toPixels * glm::vec4(p, 1.0f);
+		if (clip.w <= 1e-6f) {
+			return false;
+		}
+		pixel = glm::vec2(clip) / clip.w;
+		return true;
+	};
+
+	glm::vec2 start, end;
+	if (!project(points[0], start) || !project(points[count - 1], end)) {
+		return false;
+	}
+	const glm::vec2 chord = end - start;
+	const float chordLengthSquared = glm::dot(chord, chord);
+
+	for (size_t i = 1; i + 1 < count; i++) {
+		glm::vec2 pixel;
+		if (!project(points[i], pixel)) {
+			return false;
+		}
+		// Distance to the chord as a segment, not a line, so a piece that
+		// doubles back on itself isn't mistaken for a flat one
+		float t = chordLengthSquared > 0.0f ? glm::clamp(glm::dot(pixel - start, chord) / chordLengthSquared, 0.0f, 1.0f) : 0.0f;
+		glm::vec2 offset = pixel - (start + t * chord);
+		if (glm::dot(offset, offset) > tolerance * tolerance) {
+			return false;
+		}
+	}
+	return true;
+}
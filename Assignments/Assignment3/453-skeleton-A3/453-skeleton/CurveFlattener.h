@@ -0,0 +1,63 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Turns Bezier and B-spline curves into line strips with only as many
+// vertices as it takes to stay within a tolerance, in pixels.
+//
+// Each curve piece is split in half (de Casteljau at u = 0.5) until it is
+// flat: until every control point lands within the tolerance of the line
+// between the piece's end points, on screen. The curve stays inside the
+// convex hull of its control points, and the hull stays inside the hull on
+// screen, so no point of the curve strays further than that from its line
+// segment either. Straight stretches come out as one segment, tight bends
+// get as many as they need.
+//
+// B-splines are the curve the editor's Chaikin subdivision converges to: a
+// uniform quadratic B-spline pinned to its first and last control points.
+// Every span of it is a quadratic Bezier, flattened the same way.
+//
+// The output buffer is cleared and refilled, so passing the same one every
+// frame keeps its memory. The flattener keeps its own scratch space the same
+// way; neither allocates once they are big enough.
+//
+// Example: CurveFlattener flattener;
+//          std::vector<glm::vec3> strip;
+//          flattener.flattenBezier(points.data(), points.size(), toPixels, 0.5f, strip);
+//          ... draw strip as GL_LINE_STRIP ...
+//------------------------------------------------------------------------------
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+
+class CurveFlattener {
+
+public:
+	// Pieces stop splitting after this many halvings, 65536 segments a piece
+	static constexpr int MAX_DEPTH = 16;
+
+	// Every split of a Bezier curve costs the square of its point count, so
+	// past this many, sample it at fixed steps instead (Bezier.h)
+	static constexpr size_t MAX_BEZIER_POINTS = 256;
+
+	// toPixels takes the points to window coordinates: the view projection
+	// matrix, followed by the viewport transform (see toPixels()). Tolerance
+	// is in pixels.
+	void flattenBezier(const glm::vec3* points, size_t count, const glm::mat4& toPixels, float tolerance, std::vector<glm::vec3>& out);
+	void flattenBSpline(const glm::vec3* points, size_t count, const glm::mat4& toPixels, float tolerance, std::vector<glm::vec3>& out);
+
+	// The viewport transform for a width x height window, after viewProjection
+	static glm::mat4 toPixels(const glm::mat4& viewProjection, int width, int height);
+
+private:
+	// Pieces waiting to be flattened, count control points each, one after
+	// another. The last one is the next to go.
+	std::vector<glm::vec3> pieces;
+	std::vector<int> depths;
+
+	// Appends the piece's strip to out, minus its first point
+	void flattenPiece(const glm::vec3* points, size_t count, const glm::mat4& toPixels, float tolerance, std::vector<glm::vec3>& out);
+	static bool isFlat(const glm::vec3* points, size_t count, const glm::mat4& toPixels, float tolerance);
+};
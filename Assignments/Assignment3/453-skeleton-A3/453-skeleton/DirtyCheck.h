@@ -0,0 +1,43 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Remembers the inputs a cached result was last built from, so it can be
+// rebuilt only when one of them changes.
+//
+// Inputs can be anything with ==: counts, enums, matrices, or a version
+// number that the owner of some bigger input (like a list of control
+// points) bumps whenever it edits it. A stage that rebuilds can bump a
+// version of its own, for the stages that depend on it.
+//
+// Example: DirtyCheck<uint64_t, int> surfaceInputs;
+//          if (surfaceInputs.changed(profileVersion, slices)) {
+//              ... rebuild and upload the surface ...
+//          }
+//------------------------------------------------------------------------------
+
+#include <tuple>
+
+
+template <typename... Inputs>
+class DirtyCheck {
+
+public:
+	// True the first time, and whenever the inputs differ from the last
+	// call's. Either way, remembers them for next time.
+	bool changed(const Inputs&... inputs) {
+		std::tuple<Inputs...> current(inputs...);
+		if (known && current == last) {
+			return false;
+		}
+		last = current;
+		known = true;
+		return true;
+	}
+
+	// Makes the next changed() true, whatever it is given
+	void invalidate() { known = false; }
+
+private:
+	std::tuple<Inputs...> last{};
+	bool known = false;
+};
@@ -1,5 +1,7 @@
 #include "Geometry.h"
 
+#include "RenderStats.h"
+
 #include <utility>
 
 
@@ -16,3 +18,32 @@ void GPU_Geometry::setVerts(const std::vector<glm::vec3>& verts) {
 void GPU_Geometry::setCols(const std::vector<glm::vec3>& cols) {
 	colorsBuffer.uploadData(sizeof(glm::vec3) * cols.size(), cols.data(), GL_STATIC_DRAW);
 }
+
+void GPU_Geometry::updateVerts(size_t first, const glm::vec3* verts, size_t count) {
+	vertBuffer.updateData(sizeof(glm::vec3) * first, sizeof(glm::vec3) * count, verts);
+}
+
+
+// GPU_Geometry's constructor leaves the vao bound, so the normals attribute
+// lands in it too. It stays off until there are normals to read, so meshes
+// without them don't draw from an empty buffer.
+GPU_IndexedGeometry::GPU_IndexedGeometry()
+	: GPU_Geometry()
+	, normalsBuffer(2, 3, GL_FLOAT)
+	, indexBuffer()
+{
+	glDisableVertexAttribArray(2);
+}
+
+void GPU_IndexedGeometry::setNormals(const std::vector<glm::vec3>& norms) {
+	normalsBuffer.uploadData(sizeof(glm::vec3) * norms.size(), norms.data(), GL_STATIC_DRAW);
+	vao.bind();
+	glEnableVertexAttribArray(2);
+}
+
+void GPU_IndexedGeometry::setIndices(const std::vector<GLuint>& indices) {
+	vao.bind();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
+	RenderStats::countUpload(sizeof(GLuint) * indices.size());
+}
@@ -19,6 +19,7 @@
 struct CPU_Geometry {
 	std::vector<glm::vec3> verts;
 	std::vector<glm::vec3> cols;
+	std::vector<glm::vec3> normals;
 };
 
 
@@ -32,6 +33,9 @@ public:
 	}
 	void setVerts(const std::vector<glm::vec3>& verts);
 	void setCols(const std::vector<glm::vec3>& cols);
+
+	// Overwrites count vertices from first on, leaving the rest as they are
+	void updateVerts(size_t first, const glm::vec3* verts, size_t count);
 protected:
 	// note: due to how OpenGL works, vao needs to be
 // defined and initialized before the vertex buffers
@@ -42,3 +46,21 @@ protected:
 private:
 
 };
+
+
+// GPU_Geometry plus normals and an index buffer, for meshes that share their
+// vertices between triangles and are drawn with glDrawElements. The normal
+// attribute (location 2) is turned on by the first setNormals(); until then,
+// and in other geometry, it stays at its default of zero.
+class GPU_IndexedGeometry : public GPU_Geometry {
+public:
+	GPU_IndexedGeometry();
+	// Public interface
+	void setNormals(const std::vector<glm::vec3>& norms);
+
+	// The VAO keeps track of the index buffer, so bind() is all drawing needs
+	void setIndices(const std::vector<GLuint>& indices);
+protected:
+	VertexBuffer normalsBuffer;
+	VertexBufferHandle indexBuffer;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A rows x columns grid in one flat, row-major array, with views of single
+// rows and columns that can be indexed like arrays.
+//
+// A row view steps one cell at a time and a column view a whole row at a
+// time, so code written against views (Chaikin::subdivideInPlace(), say)
+// runs down columns without anything being transposed or copied.
+//
+// Example: Grid<glm::vec3> net = Grid<glm::vec3>::fromRows(rowsOfPoints);
+//          StridedView<glm::vec3> column = net.column(2);
+//          column[1] = net.at(1, 2) + glm::vec3(0.0f, 1.0f, 0.0f);
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <vector>
+
+
+// count elements, stride elements apart
+template <typename T>
+class StridedView {
+
+public:
+	StridedView(T* first, size_t count, size_t stride)
+		: first(first), count(count), stride(stride)
+	{}
+
+	T& operator[](size_t i) const { return first[i * stride]; }
+	size_t size() const { return count; }
+	size_t getStride() const { return stride; }
+
+private:
+	T* first;
+	size_t count;
+	size_t stride;
+};
+
+
+template <typename T>
+class Grid {
+
+public:
+	Grid() = default;
+	Grid(size_t rows, size_t columns)
+		: rows(rows), columns(columns), cells(rows * columns)
+	{}
+
+	// From a vector per row, cut to the shortest row
+	static Grid fromRows(const std::vector<std::vector<T>>& rowVectors) {
+		size_t columns = rowVectors.empty() ? 0 : rowVectors[0].size();
+		for (const std::vector<T>& row : rowVectors) {
+			columns = row.size() < columns ? row.size() : columns;
+		}
+		Grid grid(rowVectors.size(), columns);
+		for (size_t r = 0; r < grid.rows; r++) {
+			for (size_t c = 0; c < columns; c++) {
+				grid.at(r, c) = rowVectors[r][c];
+			}
+		}
+		return grid;
+	}
+
+	// Changes the shape. The cells keep their memory but not their
+	// positions, so treat their contents as lost.
+	void resize(size_t newRows, size_t newColumns) {
+		rows = newRows;
+		columns = newColumns;
+		cells.resize(rows * columns);
+	}
+
+	T& at(size_t row, size_t column) { return cells[row * columns + column]; }
+	const T& at(size_t row, size_t column) const { return cells[row * columns + column]; }
+
+	StridedView<T> row(size_t r) { return StridedView<T>(cells.data() + r * columns, columns, 1); }
+	StridedView<const T> row(size_t r) const { return StridedView<const T>(cells.data() + r * columns, columns, 1); }
+	StridedView<T> column(size_t c) { return StridedView<T>(cells.data() + c, rows, columns); }
+	StridedView<const T> column(size_t c) const { return StridedView<const T>(cells.data() + c, rows, columns); }
+
+	size_t getRows() const { return rows; }
+	size_t getColumns() const { return columns; }
+	bool empty() const { return cells.empty(); }
+
+	// Every cell, row after row, ready for a vertex buffer
+	const std::vector<T>& getCells() const { return cells; }
+
+private:
+	size_t rows = 0;
+	size_t columns = 0;
+	std::vector<T> cells;
+};
@@ -0,0 +1,258 @@
+#include "PointIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+namespace {
+
+	// Cell coordinates are packed 21 bits each into the key
+	constexpr int CELL_LIMIT = (1 << 20) - 1;
+
+}
+
+
+PointIndex::PointIndex(float cellSize)
+	: cellSize(cellSize)
+{}
+
+
+void PointIndex::rebuild(const std::vector<glm::vec3>& points) {
+	clear();
+	positions = points;
+	for (size_t i = 0; i < points.size(); i++) {
+		add(int(i), points[i]);
+	}
+}
+
+
+void PointIndex::clear() {
+	positions.clear();
+	cells.clear();
+	lowest = Cell(0);
+	highest = Cell(-1);
+}
+
+
+void PointIndex::insert(int index, const glm::vec3& position) {
+	if (index < int(positions.size())) {
+		renumber(index, 1);
+	}
+	positions.insert(positions.begin() + index, position);
+	add(index, position);
+}
+
+
+void PointIndex::move(int index, const glm::vec3& position) {
+	const glm::vec3 old = positions[index];
+	positions[index] = position;
+	if (cellOf(old) == cellOf(position)) {
+		for (Entry& entry : cells[key(cellOf(position))]) {
+			if (entry.index == index) {
+				entry.position = position;
+			}
+		}
+		return;
+	}
+	remove(index, old);
+	add(index, position);
+}
+
+
+void PointIndex::erase(int index) {
+	remove(index, positions[index]);
+	positions.erase(positions.begin() + index);
+	if (index < int(positions.size())) {
+		renumber(index + 1, -1);
+	}
+}
+
+
+int PointIndex::findFirstWithin(const glm::vec3& position, float radius) const {
+	const int reach = int(std::ceil(radius / cellSize));
+	const Cell center = cellOf(position);
+
+	int first = -1;
+	for (int x = -reach; x <= reach; x++) {
+		for (int y = -reach; y <= reach; y++) {
+			for (int z = -reach; z <= reach; z++) {
+				const std::vector<Entry>* entries = find(center + Cell(x, y, z));
+				if (entries == nullptr) {
+					continue;
+				}
+				for (const Entry& entry : *entries) {
+					if ((first == -1 || entry.index < first) && glm::length(position - entry.position) <= radius) {
+						first = entry.index;
+					}
+				}
+			}
+		}
+	}
+	return first;
+}
+
+
+int PointIndex::pickRay(const glm::vec3& origin, const glm::vec3& direction, float radius) const {
+	if (positions.empty() || glm::dot(direction, direction) == 0.0f) {
+		return -1;
+	}
+	const glm::vec3 d = glm::normalize(direction);
+	const int reach = int(std::ceil(radius / cellSize));
+
+	// Clip the ray to the used cells, plus reach all around
+	const Cell boxLow = lowest - Cell(reach);
+	const Cell boxHigh = highest + Cell(reach);
+	const float infinity = std::numeric_limits<float>::infinity();
+	float tEnter = 0.0f;
+	float tExit = infinity;
+	for (int axis = 0; axis < 3; axis++) {
+		const float low = boxLow[axis] * cellSize;
+		const float high = (boxHigh[axis] + 1) * cellSize;
+		if (d[axis] == 0.0f) {
+			if (origin[axis] < low || origin[axis] > high) {
+				return -1;
+			}
+			continue;
+		}
+		float t0 = (low - origin[axis]) / d[axis];
+		float t1 = (high - origin[axis]) / d[axis];
+		tEnter = std::max(tEnter, std::min(t0, t1));
+		tExit = std::min(tExit, std::max(t0, t1));
+	}
+	if (tEnter > tExit) {
+		return -1;
+	}
+
+	// Walk the cells along the ray (Amanatides and Woo). Every point within
+	// radius of the ray is within reach of a cell the ray passes through.
+	Cell cell = glm::clamp(cellOf(origin + tEnter * d), boxLow, boxHigh);
+	Cell step;
+	glm::vec3 tNext;
+	glm::vec3 tDelta;
+	for (int axis = 0; axis < 3; axis++) {
+		if (d[axis] == 0.0f) {
+			step[axis] = 0;
+			tNext[axis] = infinity;
+			tDelta[axis] = infinity;
+			continue;
+		}
+		step[axis] = d[axis] > 0.0f ? 1 : -1;
+		const float boundary = (cell[axis] + (d[axis] > 0.0f ? 1 : 0)) * cellSize;
+		tNext[axis] = (boundary - origin[axis]) / d[axis];
+		tDelta[axis] = cellSize / std::abs(d[axis]);
+	}
+
+	int picked = -1;
+	float pickedT = infinity;
+	Cell previous = cell + Cell(2 * reach + 1);		// too far for anything to count as seen
+	float tCell = tEnter;
+	const float radiusSquared = radius * radius;
+	while (tCell <= tExit && tCell <= pickedT) {
+		for (int x = -reach; x <= reach; x++) {
+			for (int y = -reach; y <= reach; y++) {
+				for (int z = -reach; z <= reach; z++) {
+					const Cell neighbour = cell + Cell(x, y, z);
+
+					// Each axis only ever steps one way, so a cell next to
+					// this one that was next to any earlier one was next to
+					// the last one too, and has been looked at
+					const Cell offset = glm::abs(neighbour - previous);
+					if (offset.x <= reach && offset.y <= reach && offset.z <= reach) {
+						continue;
+					}
+
+					const std::vector<Entry>* entries = find(neighbour);
+					if (entries == nullptr) {
+						continue;
+					}
+					for (const Entry& entry : *entries) {
+						const glm::vec3 v = entry.position - origin;
+						const float t = glm::dot(v, d);
+						if (t < 0.0f || glm::dot(v, v) - t * t > radiusSquared) {
+							continue;
+						}
+						if (t < pickedT || (t == pickedT && entry.index < picked)) {
+							picked = entry.index;
+							pickedT = t;
+						}
+					}
+				}
+			}
+		}
+
+		// On to the next cell. Anything not seen yet lies at least as far
+		// along as that cell starts, so the loop ends once that is past the pick.
+		previous = cell;
+		const int axis = tNext.x < tNext.y ? (tNext.x < tNext.z ? 0 : 2) : (tNext.y < tNext.z ? 1 : 2);
+		tCell = tNext[axis];
+		tNext[axis] += tDelta[axis];
+		cell[axis] += step[axis];
+		if (cell[axis] < boxLow[axis] || cell[axis] > boxHigh[axis]) {
+			break;
+		}
+	}
+	return picked;
+}
+
+
+PointIndex::Cell PointIndex::cellOf(const glm::vec3& position) const {
+	const glm::vec3 scaled = glm::floor(position / cellSize);
+	return Cell(glm::clamp(scaled, glm::vec3(-CELL_LIMIT), glm::vec3(CELL_LIMIT)));
+}
+
+
+uint64_t PointIndex::key(const Cell& cell) {
+	const uint64_t mask = (uint64_t(1) << 21) - 1;
+	return (uint64_t(cell.x + CELL_LIMIT + 1) & mask)
+		| ((uint64_t(cell.y + CELL_LIMIT + 1) & mask) << 21)
+		| ((uint64_t(cell.z + CELL_LIMIT + 1) & mask) << 42);
+}
+
+
+const std::vector<PointIndex::Entry>* PointIndex::find(const Cell& cell) const {
+	auto found = cells.find(key(cell));
+	return found == cells.end() ? nullptr : &found->second;
+}
+
+
+void PointIndex::add(int index, const glm::vec3& position) {
+	const Cell cell = cellOf(position);
+	cells[key(cell)].push_back({ index, position });
+	if (highest.x < lowest.x) {
+		lowest = cell;
+		highest = cell;
+	}
+	lowest = glm::min(lowest, cell);
+	highest = glm::max(highest, cell);
+}
+
+
+void PointIndex::remove(int index, const glm::vec3& position) {
+	auto found = cells.find(key(cellOf(position)));
+	if (found == cells.end()) {
+		return;
+	}
+	std::vector<Entry>& entries = found->second;
+	for (size_t i = 0; i < entries.size(); i++) {
+		if (entries[i].index == index) {
+			entries[i] = entries.back();
+			entries.pop_back();
+			break;
+		}
+	}
+	if (entries.empty()) {
+		cells.erase(found);
+	}
+}
+
+
+void PointIndex::renumber(int from, int by) {
+	for (auto& [cellKey, entries] : cells) {
+		for (Entry& entry : entries) {
+			if (entry.index >= from) {
+				entry.index += by;
+			}
+		}
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A uniform grid over a list of points, for picking one out of hundreds of
+// thousands without looking at them all.
+//
+// The index mirrors the list: point i of the index is point i of the list,
+// and every edit to the list is made to the index too. Moves touch only the
+// old and new cells. Inserting or erasing anywhere but the end shifts the
+// indices after it, which costs one pass over the index, about as much as
+// shifting the list itself.
+//
+// Two kinds of query:
+//  - findFirstWithin(): the lowest index within a radius of a position,
+//    the same answer as scanning the list in order. Looks at the cells
+//    around the position only.
+//  - pickRay(): the point closest to a ray's origin among those within a
+//    radius of the ray. Walks the cells the ray passes through, front to
+//    back, and stops once nothing nearer can turn up.
+//
+// Cells should be about the size of the radius: much smaller and queries
+// visit many empty cells, much larger and they test many far points.
+//
+// Example: PointIndex index(0.08f);
+//          index.rebuild(points);
+//          int picked = index.findFirstWithin(cursor, 0.08f);
+//          points[picked] = cursor;
+//          index.move(picked, cursor);
+//------------------------------------------------------------------------------
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+class PointIndex {
+
+public:
+	explicit PointIndex(float cellSize);
+
+	void rebuild(const std::vector<glm::vec3>& points);
+	void clear();
+
+	// Edits made to the list, made to the index too
+	void insert(int index, const glm::vec3& position);
+	void move(int index, const glm::vec3& position);
+	void erase(int index);
+
+	// -1 when no point is close enough
+	int findFirstWithin(const glm::vec3& position, float radius) const;
+	int pickRay(const glm::vec3& origin, const glm::vec3& direction, float radius) const;
+
+	size_t size() const { return positions.size(); }
+	float getCellSize() const { return cellSize; }
+
+private:
+	struct Entry {
+		int index;
+		glm::vec3 position;
+	};
+	using Cell = glm::ivec3;
+
+	float cellSize;
+	std::vector<glm::vec3> positions;					// the list, to find a point's cell
+	std::unordered_map<uint64_t, std::vector<Entry>> cells;
+
+	// Every cell that was ever used lies in here. Only grows, which only
+	// makes pickRay() walk a little further than it has to.
+	Cell lowest = Cell(0);
+	Cell highest = Cell(-1);
+
+	Cell cellOf(const glm::vec3& position) const;
+	static uint64_t key(const Cell& cell);
+	const std::vector<Entry>* find(const Cell& cell) const;
+
+	void add(int index, const glm::vec3& position);
+	void remove(int index, const glm::vec3& position);
+	void renumber(int from, int by);
+};
@@ -5,14 +5,42 @@
 #include <vector>
 
 #include "Log.h"
+#include "RenderStats.h"
 
 ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath)
 	: programID()
-	, vertex(vertexPath, GL_VERTEX_SHADER)
-	, fragment(fragmentPath, GL_FRAGMENT_SHADER)
+	, vertex(std::in_place, vertexPath, GL_VERTEX_SHADER)
+	, fragment(std::in_place, fragmentPath, GL_FRAGMENT_SHADER)
 {
-	attach(*this, vertex);
-	attach(*this, fragment);
+	link();
+}
+
+ShaderProgram::ShaderProgram(
+	const std::string& vertexPath, const std::string& tessControlPath,
+	const std::string& tessEvaluationPath, const std::string& fragmentPath
+)
+	: programID()
+	, vertex(std::in_place, vertexPath, GL_VERTEX_SHADER)
+	, tessControl(std::in_place, tessControlPath, GL_TESS_CONTROL_SHADER)
+	, tessEvaluation(std::in_place, tessEvaluationPath, GL_TESS_EVALUATION_SHADER)
+	, fragment(std::in_place, fragmentPath, GL_FRAGMENT_SHADER)
+{
+	link();
+}
+
+ShaderProgram::ShaderProgram(const std::string& computePath)
+	: programID()
+	, compute(std::in_place, computePath, GL_COMPUTE_SHADER)
+{
+	link();
+}
+
+void ShaderProgram::link() {
+	for (std::optional<Shader>* stage : { &vertex, &tessControl, &tessEvaluation, &fragment, &compute }) {
+		if (*stage) {
+			attach(*this, **stage);
+		}
+	}
 	glLinkProgram(programID);
 
 	if (!checkAndLogLinkSuccess()) {
@@ -25,8 +53,19 @@ bool ShaderProgram::recompile() {
 
 	try {
 		// Try to create a new program
-		ShaderProgram newProgram(vertex.getPath(), fragment.getPath());
-		*this = std::move(newProgram);
+		if (compute) {
+			ShaderProgram newProgram(compute->getPath());
+			*this = std::move(newProgram);
+		}
+		else if (tessControl && tessEvaluation) {
+			ShaderProgram newProgram(vertex->getPath(), tessControl->getPath(), tessEvaluation->getPath(), fragment->getPath());
+			*this = std::move(newProgram);
+		}
+		else {
+			ShaderProgram newProgram(vertex->getPath(), fragment->getPath());
+			*this = std::move(newProgram);
+		}
+		RenderStats::countShaderRecompile();
 		return true;
 	}
 	catch (std::runtime_error &e) {
@@ -52,23 +91,32 @@ bool ShaderProgram::checkAndLogLinkSuccess() const {
 		std::vector<char> log(logLength);
 		glGetProgramInfoLog(programID, logLength, NULL, log.data());
 
-		Log::error("SHADER_PROGRAM linking {} + {}:\n{}",
-			  vertex.getPath()
-			, fragment.getPath()
+		Log::error("SHADER_PROGRAM linking {}:\n{}",
+			  getPaths()
 			, log.data()
 		);
 		return false;
 	}
 	else {
-		Log::info("SHADER_PROGRAM successfully compiled and linked {} + {}",
-			  vertex.getPath()
-			, fragment.getPath()
+		Log::info("SHADER_PROGRAM successfully compiled and linked {}",
+			  getPaths()
 		);
 		return true;
 	}
 }
 
 
+std::string ShaderProgram::getPaths() const {
+	std::string paths;
+	for (const std::optional<Shader>* stage : { &vertex, &tessControl, &tessEvaluation, &fragment, &compute }) {
+		if (*stage) {
+			paths += (paths.empty() ? "" : " + ") + (*stage)->getPath();
+		}
+	}
+	return paths;
+}
+
+
 GLuint ShaderProgram::getProgram() {
 	return programID.value();
 }
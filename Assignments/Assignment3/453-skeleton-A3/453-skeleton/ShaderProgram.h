@@ -14,6 +14,16 @@ class ShaderProgram {
 
 public:
 	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
+
+	// With tessellation control and evaluation shaders between the two
+	// (needs an OpenGL 4.0 context)
+	ShaderProgram(
+		const std::string& vertexPath, const std::string& tessControlPath,
+		const std::string& tessEvaluationPath, const std::string& fragmentPath
+	);
+
+	// A compute shader on its own (needs an OpenGL 4.3 context)
+	explicit ShaderProgram(const std::string& computePath);
 	// Because we're using the ShaderProgramHandle to do RAII for the shader for us
 	// and our other types are trivial or provide their own RAII
 	// we don't have to provide any specialized functions here. Rule of zero
@@ -36,8 +46,14 @@ public:
 private:
 	ShaderProgramHandle programID;
 
-	Shader vertex;
-	Shader fragment;
+	// Whichever stages the program was made with
+	std::optional<Shader> vertex;
+	std::optional<Shader> tessControl;
+	std::optional<Shader> tessEvaluation;
+	std::optional<Shader> fragment;
+	std::optional<Shader> compute;
 
+	void link();
 	bool checkAndLogLinkSuccess() const;
+	std::string getPaths() const;
 };
@@ -0,0 +1,74 @@
+#include "StatsOverlay.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+
+
+namespace {
+
+	// Readable byte counts, e.g. 1.5 MB
+	void textBytes(const char* label, uint64_t bytes) {
+		const char* units[] = { "B", "KB", "MB", "GB" };
+		double value = static_cast<double>(bytes);
+		int unit = 0;
+		while (value >= 1024.0 && unit < 3) {
+			value /= 1024.0;
+			unit++;
+		}
+		ImGui::Text("%s: %.1f %s", label, value, units[unit]);
+	}
+
+}
+
+
+void StatsOverlay::draw(const RenderStats::Recorder& stats, float displayWidth) {
+	const float width = 300.0f;
+	ImGui::SetNextWindowPos(ImVec2(displayWidth - width - 5.0f, 5.0f));
+	ImGui::SetNextWindowSize(ImVec2(width, 0.0f));
+
+	ImGuiWindowFlags flags =
+		ImGuiWindowFlags_NoMove |
+		ImGuiWindowFlags_NoResize |
+		ImGuiWindowFlags_NoCollapse |
+		ImGuiWindowFlags_NoSavedSettings |
+		ImGuiWindowFlags_NoTitleBar;
+	ImGui::SetNextWindowBgAlpha(0.6f);
+	ImGui::Begin("statsOverlay", (bool*)0, flags);
+
+	const RenderStats::Frame& frame = stats.latest();
+
+	ImGui::Text("CPU: %.2f ms  Frame: %.2f ms (%.0f fps)", frame.cpuMs, frame.frameMs, frame.frameMs > 0.0f ? 1000.0f / frame.frameMs : 0.0f);
+
+	// Only the frames recorded so far, which are the first historyCount
+	// entries, so the unfilled part of the ring doesn't show up as 0 ms frames
+	const std::vector<float>& history = stats.getCpuHistory();
+	const size_t historyCount = stats.getHistoryCount();
+	if (historyCount > 0) {
+		const float* first = history.data();
+		const float* last = first + historyCount;
+
+		// Frame times over the last few seconds, oldest on the left
+		const float maxMs = std::max(16.7f, *std::max_element(first, last));
+		ImGui::PlotLines("##cpu", first, static_cast<int>(historyCount), static_cast<int>(stats.getHistoryOffset()),
+			nullptr, 0.0f, maxMs, ImVec2(width - 16.0f, 40.0f));
+
+		// How often each frame time came up, from 0 to maxMs
+		const int bucketCount = 24;
+		float buckets[bucketCount] = {};
+		for (const float* ms = first; ms != last; ms++) {
+			int bucket = std::min(bucketCount - 1, static_cast<int>(*ms / maxMs * bucketCount));
+			buckets[bucket] += 1.0f;
+		}
+		ImGui::PlotHistogram("##histogram", buckets, bucketCount, 0, nullptr, 0.0f, FLT_MAX, ImVec2(width - 16.0f, 40.0f));
+		ImGui::Text("0 ms %*s %.1f ms", 28, "", maxMs);
+	}
+
+	ImGui::Separator();
+	ImGui::Text("Draw calls: %llu", static_cast<unsigned long long>(frame.drawCalls));
+	textBytes("Uploaded this frame", frame.uploadBytes);
+	textBytes("Texture memory", frame.textureBytes);
+	ImGui::Text("Shader recompiles: %llu", static_cast<unsigned long long>(frame.shaderRecompiles));
+
+	ImGui::End();
+}
@@ -0,0 +1,78 @@
+#include "SurfaceOfRevolution.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <cmath>
+
+
+void SurfaceOfRevolution::generate(const std::vector<glm::vec3>& profile, int slices, std::vector<glm::vec3>& verts, std::vector<glm::vec3>& normals, std::vector<GLuint>& indices) {
+	verts.clear();
+	normals.clear();
+	indices.clear();
+
+	const int rings = static_cast<int>(profile.size());
+	if (rings < 2 || slices < 1) {
+		return;
+	}
+
+	// Angle between each slice
+	if (slices != tableSlices) {
+		const float angle_step = 2.0 * glm::pi<double>() / slices;
+		cosines.resize(slices);
+		sines.resize(slices);
+		for (int j = 0; j < slices; j++) {
+			float angle = j * angle_step;
+			cosines[j] = std::cos(angle);
+			sines[j] = std::sin(angle);
+		}
+		tableSlices = slices;
+	}
+
+	verts.resize(size_t(rings) * slices);
+	normals.resize(size_t(rings) * slices);
+	for (int i = 0; i < rings; i++) {
+		const glm::vec3& p = profile[i];
+
+		// Tangent by central differences, one sided at the ends. Chaikin
+		// doubles the middle point of two point profiles, so look further
+		// out when neighbours coincide.
+		int before = i;
+		int after = i;
+		while (before > 0 && profile[before] == p) {
+			before--;
+		}
+		while (after < rings - 1 && profile[after] == p) {
+			after++;
+		}
+		glm::vec2 tangent = glm::vec2(profile[after]) - glm::vec2(profile[before]);
+		glm::vec2 normal2D = glm::dot(tangent, tangent) > 0.0f
+			? glm::normalize(glm::vec2(tangent.y, -tangent.x))
+			: glm::vec2(0.0f, 1.0f);
+
+		glm::vec3* ring = verts.data() + size_t(i) * slices;
+		glm::vec3* ringNormals = normals.data() + size_t(i) * slices;
+		for (int j = 0; j < slices; j++) {
+			ring[j] = glm::vec3(p.x * cosines[j], p.y, p.x * sines[j]);
+			ringNormals[j] = glm::vec3(normal2D.x * cosines[j], normal2D.y, normal2D.x * sines[j]);
+		}
+	}
+
+	// Two triangles per quad, the last slice wrapping around to the first
+	indices.reserve(size_t(rings - 1) * slices * 6);
+	for (int i = 0; i < rings - 1; i++) {
+		for (int j = 0; j < slices; j++) {
+			const int next = (j + 1 == slices) ? 0 : j + 1;
+			GLuint v1 = GLuint(i * slices + j);
+			GLuint v2 = GLuint((i + 1) * slices + j);
+			GLuint v3 = GLuint((i + 1) * slices + next);
+			GLuint v4 = GLuint(i * slices + next);
+
+			indices.push_back(v1);
+			indices.push_back(v2);
+			indices.push_back(v3);
+			indices.push_back(v1);
+			indices.push_back(v3);
+			indices.push_back(v4);
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Builds indexed surfaces of revolution, spun about the y axis.
+//
+// The profile's x is the distance from the axis and y the height. Every
+// profile point becomes one ring of vertices, one per slice, shared by all
+// the triangles around it: P * S vertices where unshared triangles need
+// 6 (P - 1) * S. The triangles are the same ones, in the same order.
+//
+// Sines and cosines come from a table that is only rebuilt when the slice
+// count changes. Normals are exact rather than averaged from faces: the
+// normal of a surface of revolution is the profile's 2D normal, (y', -x'),
+// spun around with it.
+//
+// Example: SurfaceOfRevolution revolution;
+//          revolution.generate(profile, 21, verts, normals, indices);
+//          ... draw indices.size() indices as GL_TRIANGLES ...
+//------------------------------------------------------------------------------
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+class SurfaceOfRevolution {
+
+public:
+	// Replaces the contents of verts, normals and indices. Profiles with
+	// fewer than two points make an empty mesh.
+	void generate(const std::vector<glm::vec3>& profile, int slices, std::vector<glm::vec3>& verts, std::vector<glm::vec3>& normals, std::vector<GLuint>& indices);
+
+private:
+	int tableSlices = 0;
+	std::vector<float> cosines;
+	std::vector<float> sines;
+};
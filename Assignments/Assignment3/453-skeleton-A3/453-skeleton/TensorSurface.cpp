@@ -0,0 +1,115 @@
+#include "TensorSurface.h"
+
+#include "Chaikin.h"
+
+#include <algorithm>
+#include <thread>
+
+
+namespace {
+
+	// Below this many cells per thread, starting threads costs more than it saves
+	constexpr size_t MIN_CELLS_PER_THREAD = 1 << 16;
+
+	// Calls work(begin, end) on consecutive slices of [0, count), on up to
+	// threads threads, the calling one included
+	template <typename Work>
+	void parallelFor(size_t count, unsigned int threads, const Work& work) {
+		const size_t slices = std::max<size_t>(1, std::min<size_t>(threads, count));
+		if (slices == 1) {
+			work(size_t(0), count);
+			return;
+		}
+
+		std::vector<std::thread> workers;
+		workers.reserve(slices - 1);
+		for (size_t s = 1; s < slices; s++) {
+			workers.emplace_back(work, count * s / slices, count * (s + 1) / slices);
+		}
+		work(size_t(0), count / slices);
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+	}
+
+	// How many threads a pass over cells cells is worth
+	unsigned int threadsFor(size_t cells, unsigned int threads) {
+		return unsigned(std::max<size_t>(1, std::min<size_t>(threads, cells / MIN_CELLS_PER_THREAD)));
+	}
+
+}
+
+
+TensorSurface::TensorSurface(unsigned int threads)
+	: threads(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency()))
+{}
+
+
+void TensorSurface::generate(const Grid<glm::vec3>& controlNet, int iterations, Grid<glm::vec3>& surface, std::vector<GLuint>& indices) const {
+	subdivide(controlNet, iterations, surface);
+	triangulate(surface.getRows(), surface.getColumns(), indices);
+}
+
+
+void TensorSurface::subdivide(const Grid<glm::vec3>& controlNet, int iterations, Grid<glm::vec3>& surface) const {
+	const size_t netRows = controlNet.getRows();
+	const size_t netColumns = controlNet.getColumns();
+	if (netRows < 2 || netColumns < 2) {
+		surface.resize(0, 0);
+		return;
+	}
+
+	iterations = std::max(iterations, 0);
+	const size_t rows = Chaikin::subdividedSize(netRows, iterations);
+	const size_t columns = Chaikin::subdividedSize(netColumns, iterations);
+	surface.resize(rows, columns);
+
+	// Rows first, only the net's own, each copied in then spread out to
+	// the full width
+	parallelFor(netRows, threadsFor(netRows * columns, threads), [&](size_t begin, size_t end) {
+		for (size_t r = begin; r < end; r++) {
+			StridedView<glm::vec3> row = surface.row(r);
+			for (size_t c = 0; c < netColumns; c++) {
+				row[c] = controlNet.at(r, c);
+			}
+			Chaikin::subdivideInPlace(row, netColumns, iterations);
+		}
+	});
+
+	// Then every column, down from the net's rows to the full height. Each
+	// thread takes its columns as one band, a row of them at a time.
+	parallelFor(columns, threadsFor(rows * columns, threads), [&](size_t begin, size_t end) {
+		Chaikin::subdivideInPlace(surface.column(begin), netRows, iterations, end - begin);
+	});
+}
+
+
+void TensorSurface::triangulate(size_t rows, size_t columns, std::vector<GLuint>& indices) const {
+	if (rows < 2 || columns < 2) {
+		indices.clear();
+		return;
+	}
+
+	// Six per square, so each square knows where its triangles go
+	const size_t squaresPerRow = columns - 1;
+	indices.resize((rows - 1) * squaresPerRow * 6);
+	parallelFor(rows - 1, threadsFor(rows * columns, threads), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			GLuint* out = indices.data() + i * squaresPerRow * 6;
+			for (size_t j = 0; j < squaresPerRow; j++) {
+				GLuint v1 = GLuint(i * columns + j);
+				GLuint v2 = GLuint((i + 1) * columns + j);
+				GLuint v3 = GLuint((i + 1) * columns + j + 1);
+				GLuint v4 = GLuint(i * columns + j + 1);
+
+				out[0] = v1;
+				out[1] = v2;
+				out[2] = v3;
+				out[3] = v1;
+				out[4] = v3;
+				out[5] = v4;
+				out += 6;
+			}
+		}
+	});
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Builds tensor product surfaces: Chaikin subdivision of a control net along
+// its rows, then along its columns, as an indexed grid of vertices.
+//
+// The net is copied once into the top left corner of a grid already the
+// size of the result. Every row is subdivided in place out to the full
+// width, then every column down to the full height, through strided views,
+// so there are no transposes and no per-row vectors. Rows, then columns,
+// are shared out between threads; each one owns its own cells, so they
+// need no locking.
+//
+// The triangles are the ones the unindexed version made, in the same order,
+// over one shared vertex per grid cell.
+//
+// Example: TensorSurface tensor;
+//          Grid<glm::vec3> surface;
+//          tensor.generate(controlNet, 3, surface, indices);
+//          ... upload surface.getCells() and draw indices as GL_TRIANGLES ...
+//------------------------------------------------------------------------------
+
+#include "Grid.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+class TensorSurface {
+
+public:
+	// threads = 0 uses one per core
+	explicit TensorSurface(unsigned int threads = 0);
+
+	// Replaces the contents of surface and indices. Nets smaller than 2 x 2
+	// make an empty mesh.
+	void generate(const Grid<glm::vec3>& controlNet, int iterations, Grid<glm::vec3>& surface, std::vector<GLuint>& indices) const;
+
+	// Just the subdivision, without the triangles
+	void subdivide(const Grid<glm::vec3>& controlNet, int iterations, Grid<glm::vec3>& surface) const;
+
+	// Two triangles per grid square, for a rows x columns grid
+	void triangulate(size_t rows, size_t columns, std::vector<GLuint>& indices) const;
+
+	unsigned int getThreadCount() const { return threads; }
+
+private:
+	unsigned int threads;
+};
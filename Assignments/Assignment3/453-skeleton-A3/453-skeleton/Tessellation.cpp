@@ -0,0 +1,143 @@
+#include "Tessellation.h"
+
+#include "RenderStats.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+
+bool Tessellation::isSupported() {
+	return GLAD_GL_VERSION_4_0 != 0;
+}
+
+
+TessellatedCurve::TessellatedCurve()
+	: bezierProgram("shaders/tess.vert", "shaders/bezier.tesc", "shaders/curve.tese", "shaders/test.frag")
+	, bsplineProgram("shaders/tess.vert", "shaders/bspline.tesc", "shaders/curve.tese", "shaders/test.frag")
+	, vao()
+	, points(0, 3, GL_FLOAT)
+	, spans()
+{}
+
+
+void TessellatedCurve::setControlPoints(const std::vector<glm::vec3>& controlPoints) {
+	count = controlPoints.size();
+	points.uploadData(sizeof(glm::vec3) * count, controlPoints.data(), GL_DYNAMIC_DRAW);
+}
+
+
+void TessellatedCurve::moveControlPoint(size_t index, const glm::vec3& position) {
+	points.updateData(sizeof(glm::vec3) * index, sizeof(glm::vec3), &position);
+}
+
+
+void TessellatedCurve::drawBezier(const glm::mat4& viewProjection, glm::vec2 viewportSize, float tolerance, glm::vec3 colour) {
+	if (count < 2 || count > MAX_BEZIER_POINTS) {
+		return;
+	}
+	setUniforms(bezierProgram, viewProjection, viewportSize, tolerance, colour);
+	vao.bind();
+	glPatchParameteri(GL_PATCH_VERTICES, GLint(count));
+	glDrawArrays(GL_PATCHES, 0, GLsizei(count));
+	RenderStats::countDrawCall();
+}
+
+
+void TessellatedCurve::drawBSpline(const glm::mat4& viewProjection, glm::vec2 viewportSize, float tolerance, glm::vec3 colour) {
+	// Two points are a line either way
+	if (count < 3) {
+		drawBezier(viewProjection, viewportSize, tolerance, colour);
+		return;
+	}
+	const size_t spanCount = count - 2;
+
+	vao.bind();
+	if (spanIndicesFor != count) {
+		std::vector<GLuint> indices(3 * spanCount);
+		for (size_t i = 0; i < spanCount; i++) {
+			indices[3 * i] = GLuint(i);
+			indices[3 * i + 1] = GLuint(i + 1);
+			indices[3 * i + 2] = GLuint(i + 2);
+		}
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, spans);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
+		RenderStats::countUpload(sizeof(GLuint) * indices.size());
+		spanIndicesFor = count;
+	}
+
+	setUniforms(bsplineProgram, viewProjection, viewportSize, tolerance, colour);
+	glUniform1i(glGetUniformLocation(bsplineProgram, "spanCount"), GLint(spanCount));
+	glPatchParameteri(GL_PATCH_VERTICES, 3);
+	glDrawElements(GL_PATCHES, GLsizei(3 * spanCount), GL_UNSIGNED_INT, 0);
+	RenderStats::countDrawCall();
+}
+
+
+void TessellatedCurve::setUniforms(ShaderProgram& program, const glm::mat4& viewProjection, glm::vec2 viewportSize, float tolerance, glm::vec3 colour) {
+	program.use();
+	glUniformMatrix4fv(glGetUniformLocation(program, "transformationMatrix"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+	glUniform2fv(glGetUniformLocation(program, "viewportSize"), 1, glm::value_ptr(viewportSize));
+	glUniform1f(glGetUniformLocation(program, "tolerance"), tolerance);
+	glUniform3fv(glGetUniformLocation(program, "colour"), 1, glm::value_ptr(colour));
+	glUniform1i(glGetUniformLocation(program, "shaded"), GL_FALSE);
+}
+
+
+TessellatedSurface::TessellatedSurface()
+	: program("shaders/tess.vert", "shaders/patch.tesc", "shaders/patch.tese", "shaders/test.frag")
+	, vao()
+	, points(0, 3, GL_FLOAT)
+	, patches()
+{}
+
+
+void TessellatedSurface::setNet(const Grid<glm::vec3>& net) {
+	rows = net.getRows();
+	columns = net.getColumns();
+	points.uploadData(sizeof(glm::vec3) * net.getCells().size(), net.getCells().data(), GL_DYNAMIC_DRAW);
+}
+
+
+void TessellatedSurface::moveControlPoint(size_t row, size_t column, const glm::vec3& position) {
+	points.updateData(sizeof(glm::vec3) * (row * columns + column), sizeof(glm::vec3), &position);
+}
+
+
+void TessellatedSurface::draw(const glm::mat4& viewProjection, glm::vec2 viewportSize, float tolerance, glm::vec3 colour) {
+	if (rows < 3 || columns < 3) {
+		return;
+	}
+	const size_t spansAcross = columns - 2;
+	const size_t spansDown = rows - 2;
+
+	vao.bind();
+	if (patchIndicesFor[0] != rows || patchIndicesFor[1] != columns) {
+		std::vector<GLuint> indices;
+		indices.reserve(9 * spansAcross * spansDown);
+		for (size_t r = 0; r < spansDown; r++) {
+			for (size_t c = 0; c < spansAcross; c++) {
+				for (size_t i = 0; i < 3; i++) {
+					for (size_t j = 0; j < 3; j++) {
+						indices.push_back(GLuint((r + i) * columns + c + j));
+					}
+				}
+			}
+		}
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, patches);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
+		RenderStats::countUpload(sizeof(GLuint) * indices.size());
+		patchIndicesFor[0] = rows;
+		patchIndicesFor[1] = columns;
+	}
+
+	program.use();
+	glUniformMatrix4fv(glGetUniformLocation(program, "transformationMatrix"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+	glUniform2fv(glGetUniformLocation(program, "viewportSize"), 1, glm::value_ptr(viewportSize));
+	glUniform1f(glGetUniformLocation(program, "tolerance"), tolerance);
+	glUniform2i(glGetUniformLocation(program, "spanCount"), GLint(spansAcross), GLint(spansDown));
+	glUniform3fv(glGetUniformLocation(program, "colour"), 1, glm::value_ptr(colour));
+	glUniform1i(glGetUniformLocation(program, "shaded"), GL_FALSE);
+
+	glPatchParameteri(GL_PATCH_VERTICES, 9);
+	glDrawElements(GL_PATCHES, GLsizei(9 * spansAcross * spansDown), GL_UNSIGNED_INT, 0);
+	RenderStats::countDrawCall();
+}
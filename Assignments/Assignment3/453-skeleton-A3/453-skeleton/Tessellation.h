@@ -0,0 +1,102 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Curves and tensor product surfaces tessellated on the GPU, from their
+// control points alone (OpenGL 4.0 and up).
+//
+// Only the control points are uploaded, once per edit, and dragging a point
+// uploads just that point. The tessellation control shaders decide every
+// frame how finely to cut each curve or patch from its size on screen, so
+// that it stays within a tolerance in pixels like CurveFlattener, and the
+// evaluation shaders place the vertices. Nothing is subdivided on the CPU.
+//
+// What comes out is the curve or surface the CPU path converges to:
+//  - Bezier curves are one patch each, so at most MAX_BEZIER_POINTS control
+//    points (the least GL_MAX_PATCH_VERTICES is allowed to be). Longer ones
+//    are left to the CPU.
+//  - B-splines are the quadratic B-spline Chaikin subdivision converges to,
+//    one patch of three control points per span.
+//  - Tensor surfaces are the biquadratic surface TensorSurface converges
+//    to, one patch of 3 x 3 control points per span. Nets need at least
+//    three rows and three columns.
+//
+// Example: TessellatedCurve curve;
+//          curve.setControlPoints(points);
+//          curve.drawBSpline(viewProjection, glm::vec2(width, height), 0.5f, colour);
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "Grid.h"
+#include "ShaderProgram.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+namespace Tessellation {
+
+	// Whether the current context has tessellation shaders
+	bool isSupported();
+
+}
+
+
+class TessellatedCurve {
+
+public:
+	static constexpr size_t MAX_BEZIER_POINTS = 32;
+
+	TessellatedCurve();
+
+	void setControlPoints(const std::vector<glm::vec3>& points);
+	void moveControlPoint(size_t index, const glm::vec3& position);
+
+	// Tolerance is in pixels, for a viewport of viewportSize
+	void drawBezier(const glm::mat4& viewProjection, glm::vec2 viewportSize, float tolerance, glm::vec3 colour);
+	void drawBSpline(const glm::mat4& viewProjection, glm::vec2 viewportSize, float tolerance, glm::vec3 colour);
+
+	size_t getControlPointCount() const { return count; }
+
+private:
+	ShaderProgram bezierProgram;
+	ShaderProgram bsplineProgram;
+
+	// note: the vao has to be made before the buffers
+	VertexArray vao;
+	VertexBuffer points;
+	VertexBufferHandle spans;			// three indices per span, rebuilt only when the count changes
+
+	size_t count = 0;
+	size_t spanIndicesFor = 0;
+
+	void setUniforms(ShaderProgram& program, const glm::mat4& viewProjection, glm::vec2 viewportSize, float tolerance, glm::vec3 colour);
+};
+
+
+class TessellatedSurface {
+
+public:
+	TessellatedSurface();
+
+	static bool canDraw(const Grid<glm::vec3>& net) { return net.getRows() >= 3 && net.getColumns() >= 3; }
+
+	void setNet(const Grid<glm::vec3>& net);
+	void moveControlPoint(size_t row, size_t column, const glm::vec3& position);
+
+	void draw(const glm::mat4& viewProjection, glm::vec2 viewportSize, float tolerance, glm::vec3 colour);
+
+private:
+	ShaderProgram program;
+
+	VertexArray vao;
+	VertexBuffer points;
+	VertexBufferHandle patches;			// nine indices per span, rebuilt only when the size changes
+
+	size_t rows = 0;
+	size_t columns = 0;
+	size_t patchIndicesFor[2] = { 0, 0 };
+};
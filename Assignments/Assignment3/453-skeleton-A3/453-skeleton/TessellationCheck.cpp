@@ -0,0 +1,262 @@
+#include "TessellationCheck.h"
+
+#include "CurveFlattener.h"
+#include "GLHandles.h"
+#include "Geometry.h"
+#include "Grid.h"
+#include "Log.h"
+#include "ShaderProgram.h"
+#include "Tessellation.h"
+#include "TensorSurface.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+	constexpr int SIZE = 512;
+
+	// Pixels, and how far in front of the camera they are (linear depth)
+	struct Image {
+		std::vector<unsigned char> colour;
+		std::vector<float> depth;
+	};
+
+	// A colour and depth framebuffer to draw the scenes into
+	class Offscreen {
+	public:
+		Offscreen() {
+			glBindRenderbuffer(GL_RENDERBUFFER, colour);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, SIZE, SIZE);
+			glBindRenderbuffer(GL_RENDERBUFFER, depth);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, SIZE, SIZE);
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colour);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+		}
+		~Offscreen() {
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		}
+		Offscreen(const Offscreen&) = delete;
+		Offscreen& operator=(const Offscreen&) = delete;
+
+		// Clears to white, draws, and reads the result back
+		Image capture(const std::function<void()>& draw, float near, float far) {
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			glViewport(0, 0, SIZE, SIZE);
+			glEnable(GL_DEPTH_TEST);
+			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+			glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			draw();
+
+			Image image;
+			image.colour.resize(4 * SIZE * SIZE);
+			image.depth.resize(SIZE * SIZE);
+			glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, image.colour.data());
+			glReadPixels(0, 0, SIZE, SIZE, GL_DEPTH_COMPONENT, GL_FLOAT, image.depth.data());
+			for (float& d : image.depth) {
+				float ndc = 2.0f * d - 1.0f;
+				d = d < 1.0f ? 2.0f * near * far / (far + near - ndc * (far - near)) : INFINITY;
+			}
+			return image;
+		}
+
+	private:
+		FramebufferHandle framebuffer;
+		RenderbufferHandle colour;
+		RenderbufferHandle depth;
+	};
+
+	bool sameColour(const Image& a, int i, const Image& b, int j) {
+		for (int c = 0; c < 3; c++) {
+			if (std::abs(int(a.colour[4 * i + c]) - int(b.colour[4 * j + c])) > 2) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool isBackground(const Image& image, int i) {
+		return image.depth[i] == INFINITY;
+	}
+
+	// Drawn pixels of a with nothing of the same colour within a pixel in b
+	int unmatched(const Image& a, const Image& b) {
+		int count = 0;
+		for (int y = 0; y < SIZE; y++) {
+			for (int x = 0; x < SIZE; x++) {
+				const int i = y * SIZE + x;
+				if (isBackground(a, i)) {
+					continue;
+				}
+				bool matched = false;
+				for (int dy = -1; dy <= 1 && !matched; dy++) {
+					for (int dx = -1; dx <= 1 && !matched; dx++) {
+						const int nx = x + dx;
+						const int ny = y + dy;
+						matched = nx >= 0 && ny >= 0 && nx < SIZE && ny < SIZE && sameColour(a, i, b, ny * SIZE + nx);
+					}
+				}
+				count += matched ? 0 : 1;
+			}
+		}
+		return count;
+	}
+
+	int drawn(const Image& image) {
+		int count = 0;
+		for (int i = 0; i < SIZE * SIZE; i++) {
+			count += isBackground(image, i) ? 0 : 1;
+		}
+		return count;
+	}
+
+	// The 99th percentile of the depth differences where both images are
+	// covered. The odd pixel on an outline or a fold, where either one
+	// may have caught a pixel of something further back, is left out.
+	float depthDifference(const Image& a, const Image& b) {
+		std::vector<float> differences;
+		for (int i = 0; i < SIZE * SIZE; i++) {
+			if (!isBackground(a, i) && !isBackground(b, i)) {
+				differences.push_back(std::abs(a.depth[i] - b.depth[i]));
+			}
+		}
+		if (differences.empty()) {
+			return 0.0f;
+		}
+		auto percentile = differences.begin() + differences.size() * 99 / 100;
+		std::nth_element(differences.begin(), percentile, differences.end());
+		return *percentile;
+	}
+
+	// Reports one scene. Mismatches are a share of the drawn pixels.
+	bool report(const std::string& scene, const Image& cpu, const Image& gpu, float maxMismatch, float maxDepthDifference) {
+		const int drawnPixels = std::max(1, std::max(drawn(cpu), drawn(gpu)));
+		const int mismatched = std::max(unmatched(cpu, gpu), unmatched(gpu, cpu));
+		const float mismatch = float(mismatched) / float(drawnPixels);
+		const float depth = depthDifference(cpu, gpu);
+		const bool pass = mismatch <= maxMismatch && depth <= maxDepthDifference;
+		Log::info("{:<28} {:>7} drawn {:>6} unmatched ({:6.3f}%)   depth p99 {:.5f}   {}",
+			scene, drawnPixels, mismatched, 100.0f * mismatch, depth, pass ? "ok" : "FAILED");
+		return pass;
+	}
+
+	// The scenes' control points. The curve is a tight zig-zag, with the
+	// editor's starting square somewhere in it.
+	const std::vector<glm::vec3> curvePoints = {
+		{ -0.9f, -0.6f, 0.0f }, { -0.5f, -0.5f, 0.0f }, { 0.5f, -0.5f, 0.0f }, { 0.5f, 0.5f, 0.0f },
+		{ -0.5f, 0.5f, 0.0f }, { -0.7f, 0.9f, 0.0f }, { 0.1f, 0.95f, 0.0f }, { 0.85f, 0.2f, 0.0f },
+		{ 0.9f, -0.9f, 0.0f }, { 0.0f, -0.2f, 0.0f }
+	};
+
+	const Grid<glm::vec3> tensorNet = Grid<glm::vec3>::fromRows({
+		{ glm::vec3(-2, 0.3, -2), glm::vec3(-1, 1.2, -2), glm::vec3(0,  0.8, -2), glm::vec3(1, 0.1, -2), glm::vec3(2, 0.6, -2) },
+		{ glm::vec3(-2, 1.0, -1), glm::vec3(-1, 0.5, -1), glm::vec3(0,  1.8, -1), glm::vec3(1, 1.3, -1), glm::vec3(2, 0.4, -1) },
+		{ glm::vec3(-2, 0.2,  0), glm::vec3(-1, 1.6,  0), glm::vec3(0, -0.1,  0), glm::vec3(1, 1.1,  0), glm::vec3(2, 0.7,  0) },
+		{ glm::vec3(-2, 1.5,  1), glm::vec3(-1, 0.9,  1), glm::vec3(0,  1.2,  1), glm::vec3(1, 0.3,  1), glm::vec3(2, 0.1,  1) }
+	});
+
+}
+
+
+bool TessellationCheck::run() {
+	if (!Tessellation::isSupported()) {
+		Log::error("TESSELLATION needs OpenGL 4.0, this context is {}.{}", GLVersion.major, GLVersion.minor);
+		return false;
+	}
+	Log::info("TESSELLATION comparing the CPU path and the tessellation shaders on {}", (const char*)glGetString(GL_RENDERER));
+
+	const float tolerance = 0.25f;
+	const glm::vec2 viewport(SIZE, SIZE);
+	const glm::vec3 black(0.0f);
+	const float near = 0.1f;
+	const float far = 100.0f;
+	const glm::mat4 flat(1.0f);
+	const glm::mat4 orbit = glm::perspective(glm::radians(45.0f), 1.0f, near, far)
+		* glm::lookAt(glm::vec3(3.0f, 4.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	ShaderProgram cpuProgram("shaders/test.vert", "shaders/test.frag");
+	TessellatedCurve tessellatedCurve;
+	TessellatedSurface tessellatedSurface;
+	tessellatedCurve.setControlPoints(curvePoints);
+	tessellatedSurface.setNet(tensorNet);
+
+	Offscreen offscreen;
+	CurveFlattener flattener;
+	GPU_Geometry cpuGeometry;
+	bool pass = true;
+
+	// The CPU path: a line strip from the flattener, as main.cpp draws it
+	auto cpuCurve = [&](bool bezier, const glm::mat4& viewProjection) {
+		std::vector<glm::vec3> strip;
+		const glm::mat4 toPixels = CurveFlattener::toPixels(viewProjection, SIZE, SIZE);
+		if (bezier) {
+			flattener.flattenBezier(curvePoints.data(), curvePoints.size(), toPixels, tolerance, strip);
+		}
+		else {
+			flattener.flattenBSpline(curvePoints.data(), curvePoints.size(), toPixels, tolerance, strip);
+		}
+		cpuGeometry.setVerts(strip);
+		cpuGeometry.setCols(std::vector<glm::vec3>(strip.size(), black));
+		return offscreen.capture([&]() {
+			cpuProgram.use();
+			glUniformMatrix4fv(glGetUniformLocation(cpuProgram, "transformationMatrix"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+			glUniform1i(glGetUniformLocation(cpuProgram, "shaded"), GL_FALSE);
+			cpuGeometry.bind();
+			glDrawArrays(GL_LINE_STRIP, 0, GLsizei(strip.size()));
+		}, near, far);
+	};
+
+	auto gpuCurve = [&](bool bezier, const glm::mat4& viewProjection) {
+		return offscreen.capture([&]() {
+			if (bezier) {
+				tessellatedCurve.drawBezier(viewProjection, viewport, tolerance, black);
+			}
+			else {
+				tessellatedCurve.drawBSpline(viewProjection, viewport, tolerance, black);
+			}
+		}, near, far);
+	};
+
+	pass = report("Bezier, editor", cpuCurve(true, flat), gpuCurve(true, flat), 0.01f, 0.05f) && pass;
+	pass = report("B-spline, editor", cpuCurve(false, flat), gpuCurve(false, flat), 0.01f, 0.05f) && pass;
+	pass = report("Bezier, orbit", cpuCurve(true, orbit), gpuCurve(true, orbit), 0.01f, 0.05f) && pass;
+	pass = report("B-spline, orbit", cpuCurve(false, orbit), gpuCurve(false, orbit), 0.01f, 0.05f) && pass;
+
+	// Tensor surfaces, filled in black so only their outlines are compared
+	// by colour, and the rest by depth
+	TensorSurface tensorSurface;
+	Grid<glm::vec3> surface;
+	std::vector<GLuint> indices;
+	GPU_IndexedGeometry surfaceGeometry;
+	for (int iterations : { 3, 5 }) {
+		tensorSurface.generate(tensorNet, iterations, surface, indices);
+		surfaceGeometry.setVerts(surface.getCells());
+		surfaceGeometry.setCols(std::vector<glm::vec3>(surface.getCells().size(), black));
+		surfaceGeometry.setIndices(indices);
+		Image cpu = offscreen.capture([&]() {
+			cpuProgram.use();
+			glUniformMatrix4fv(glGetUniformLocation(cpuProgram, "transformationMatrix"), 1, GL_FALSE, glm::value_ptr(orbit));
+			glUniform1i(glGetUniformLocation(cpuProgram, "shaded"), GL_FALSE);
+			surfaceGeometry.bind();
+			glDrawElements(GL_TRIANGLES, GLsizei(indices.size()), GL_UNSIGNED_INT, 0);
+		}, near, far);
+		Image gpu = offscreen.capture([&]() {
+			tessellatedSurface.draw(orbit, viewport, tolerance, black);
+		}, near, far);
+
+		pass = report("Tensor surface, " + std::to_string(iterations) + " rounds", cpu, gpu, 0.01f, 0.05f) && pass;
+	}
+
+	return pass;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Draws the same curves and tensor surfaces with the CPU path and with the
+// tessellation shaders (Tessellation.h), off screen, and compares the two
+// images.
+//
+// The two paths cut the curves up differently, so the same pixels are not
+// expected to light up. A pixel only counts as a mismatch if the other
+// image has nothing of the same colour within one pixel of it. Where both
+// images cover a pixel their depths are compared too, which is what tells
+// two surfaces apart inside their outlines: the CPU surface is a few
+// Chaikin rounds short of the limit the patches evaluate, so they may
+// differ by a little, but not by more than a fraction of the net's size.
+//
+// It needs a current OpenGL 4.0 context, but never shows what it draws:
+//
+// Example: 453-skeleton --compare-tessellation
+//------------------------------------------------------------------------------
+
+
+namespace TessellationCheck {
+
+	// Prints how far apart the images are, scene by scene. Returns false if
+	// any scene is past the tolerance, or tessellation is not supported.
+	bool run();
+
+}
@@ -21,6 +21,9 @@ public:
 	void bind() const { glBindBuffer(GL_ARRAY_BUFFER, bufferID); }
 	void uploadData(GLsizeiptr size, const void* data, GLenum usage);
 
+	// Overwrites size bytes from offset, in a buffer uploadData() already sized
+	void updateData(GLintptr offset, GLsizeiptr size, const void* data);
+
 private:
 	VertexBufferHandle bufferID;
 };
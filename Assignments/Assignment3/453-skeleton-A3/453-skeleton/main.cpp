@@ -6,14 +6,30 @@
 #include <vector>
 #include <limits>
 #include <functional>
+#include <algorithm>
+#include <optional>
 #include "cmath"
 #include "corecrt_math_defines.h"
 
+#include "Benchmark.h"
+#include "Bezier.h"
+#include "Chaikin.h"
+#include "ComputeSubdivision.h"
+#include "CurveFlattener.h"
+#include "DirtyCheck.h"
 #include "Geometry.h"
 #include "GLDebug.h"
+#include "Grid.h"
 #include "Log.h"
+#include "PointIndex.h"
+#include "RenderStats.h"
 #include "ShaderProgram.h"
 #include "Shader.h"
+#include "StatsOverlay.h"
+#include "SurfaceOfRevolution.h"
+#include "TensorSurface.h"
+#include "Tessellation.h"
+#include "TessellationCheck.h"
 #include "Texture.h"
 #include "Window.h"
 #include "Panel.h"
@@ -21,11 +37,14 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
+#include <argh.h>
+
 /*-------------------------------- Macros and Enums --------------------------------*/
 #define WINDOW_HEIGHT 1000
 #define WINDOW_WIDTH 1000
 
 #define POINT_PROXIMITY_THRESHOLD 0.08f
+#define TENSOR_PICK_RADIUS 0.1f
 
 enum CURVE_TYPE {
 	BEZIER,
@@ -45,6 +64,13 @@ enum POINT_MODE {
 	DELETE_MODE
 };
 
+// Where curves and tensor surfaces are made
+enum GEOMETRY_PATH {
+	CPU_PATH,
+	TESSELLATION_PATH,		// tessellation shaders, from the control points
+	COMPUTE_PATH			// Chaikin subdivision in a compute shader (B-splines and tensor surfaces)
+};
+
 /*------------------------------------ Structs ------------------------------------*/
 struct CurveEditorCallbackInput
 {
@@ -65,12 +91,22 @@ struct CurveEditorPanelInput
 
 	bool wireframeMode = true;
 
+	// Flatten curves to within curveTolerance pixels, instead of a fixed
+	// 101 Bezier samples or 8 Chaikin iterations
+	bool adaptiveCurves = true;
+	float curveTolerance = 0.5f;
+
+	// The tessellation shaders work to within curveTolerance pixels too
+	enum GEOMETRY_PATH geometryPath = CPU_PATH;
+
 	int tensorMode = 1;
 
 	int sorSlices = 21;
 	int sorIterations = 5;
 
 	int tensorIterations = 3;
+
+	bool showStats = false;
 };
 CurveEditorPanelInput curveEditorPanelInput;
 /*--------------------------------- Global Static ---------------------------------*/
@@ -86,20 +122,20 @@ const glm::mat4 projection = glm::perspective(
 	0.1f, 100.0f
 );
 
-const std::vector<std::vector<glm::vec3>> tensorSurface1 = {
+const Grid<glm::vec3> tensorSurface1 = Grid<glm::vec3>::fromRows({
 	{ glm::vec3(-2, 0, -2), glm::vec3(-1, 0, -2), glm::vec3(0,  0, -2), glm::vec3(1, 0, -2), glm::vec3(2, 0, -2) },
 	{ glm::vec3(-2, 0, -1), glm::vec3(-1, 1, -1), glm::vec3(0,  1, -1), glm::vec3(1, 1, -1), glm::vec3(2, 0, -1) },
 	{ glm::vec3(-2, 0,  0), glm::vec3(-1, 1,  0), glm::vec3(0, -1,  0), glm::vec3(1, 1,  0), glm::vec3(2, 0,  0) },
 	{ glm::vec3(-2, 0,  1), glm::vec3(-1, 1,  1), glm::vec3(0,  1,  1), glm::vec3(1, 1,  1), glm::vec3(2, 0,  1) },
 	{ glm::vec3(-2, 0,  2), glm::vec3(-1, 0,  2), glm::vec3(0,  0,  2), glm::vec3(1, 0,  2), glm::vec3(2, 0,  2) }
-};
+});
 
-const std::vector<std::vector<glm::vec3>> tensorSurface2 = {
+const Grid<glm::vec3> tensorSurface2 = Grid<glm::vec3>::fromRows({
 	{ glm::vec3(-2, 0.3, -2), glm::vec3(-1, 1.2, -2), glm::vec3(0,  0.8, -2), glm::vec3(1, 0.1, -2), glm::vec3(2, 0.6, -2) },
 	{ glm::vec3(-2, 1.0, -1), glm::vec3(-1, 0.5, -1), glm::vec3(0,  1.8, -1), glm::vec3(1, 1.3, -1), glm::vec3(2, 0.4, -1) },
 	{ glm::vec3(-2, 0.2,  0), glm::vec3(-1, 1.6,  0), glm::vec3(0, -0.1,  0), glm::vec3(1, 1.1,  0), glm::vec3(2, 0.7,  0) },
 	{ glm::vec3(-2, 1.5,  1), glm::vec3(-1, 0.9,  1), glm::vec3(0,  1.2,  1), glm::vec3(1, 0.3,  1), glm::vec3(2, 0.1,  1) }
-};
+});
 
 class CurveEditorCallBack : public CallbackInterface {
 public:
@@ -166,7 +202,8 @@ public:
 	virtual void cursorPosCallback(double xpos, double ypos) {
 		glm::vec2 currentCursorPos(xpos, ypos);
 
-		if (dragCamera) {
+		// While a control point is held, the drag moves it, not the camera
+		if (dragCamera && !holdingPoint) {
 			glm::vec2 offset = currentCursorPos - lastCursorPos;
 			offset *= sensitivity;
 
@@ -209,6 +246,19 @@ public:
 		return cameraPosition;
 	}
 
+	// Cursor in window pixels, and whether the left button is down
+	glm::vec2 getCursorPos() const {
+		return lastCursorPos;
+	}
+	bool isMouseDown() const {
+		return dragCamera;
+	}
+
+	// Stops the camera from following drags, while a control point is dragged instead
+	void holdPoint(bool holding) {
+		holdingPoint = holding;
+	}
+
 	void resetCameraPosition() {
 		cameraPosition = glm::vec3(0.0f, 0.0f, 3.0f);
 		lastCursorPos = glm::vec2(0.0f);
@@ -219,6 +269,7 @@ public:
 
 private:
 	bool dragCamera = false;
+	bool holdingPoint = false;
 	float sensitivity;
 
 	float yaw;      // X-axis angle
@@ -283,6 +334,21 @@ public:
 			else {
 				ImGui::Text("Current Type: B-Spline Curve");
 			}
+
+			geometryPathButtons();
+			const bool tessellated = (curveEditorPanelInput.geometryPath == TESSELLATION_PATH);
+			if (!tessellated) {
+				ImGui::Checkbox("Adaptive Curve Flattening", &curveEditorPanelInput.adaptiveCurves);
+			}
+			if (curveEditorPanelInput.adaptiveCurves || tessellated) {
+				ImGui::SliderFloat("Curve Tolerance", &curveEditorPanelInput.curveTolerance, 0.1f, 4.0f, "%.2f pixels");
+			}
+			if (curveVertexCount >= 0) {
+				ImGui::Text("Curve Vertices: %d", curveVertexCount);
+			}
+			else {
+				ImGui::Text("Curve Vertices: made on the GPU");
+			}
 		}
 
 		ImGuiAddSpace();
@@ -326,7 +392,13 @@ public:
 				}
 
 				ImGuiAddSpace();
-				ImGui::SliderInt("Tensor Iterations", &curveEditorPanelInput.tensorIterations, 1, 5, "%d iterations");
+				geometryPathButtons();
+				if (curveEditorPanelInput.geometryPath == TESSELLATION_PATH) {
+					ImGui::SliderFloat("Surface Tolerance", &curveEditorPanelInput.curveTolerance, 0.1f, 4.0f, "%.2f pixels");
+				}
+				else {
+					ImGui::SliderInt("Tensor Iterations", &curveEditorPanelInput.tensorIterations, 1, 5, "%d iterations");
+				}
 			}
 		}
 
@@ -339,8 +411,21 @@ public:
 				resetCamera = true;
 			}
 		}
+
+		// Add spacing ------------------------------
+		ImGuiAddSpace();
+
+		// Performance stats overlay
+		ImGui::Checkbox("Show Performance Stats", &curveEditorPanelInput.showStats);
+		if (curveEditorPanelInput.showStats && renderStats != nullptr) {
+			StatsOverlay::draw(*renderStats, ImGui::GetIO().DisplaySize.x);
+		}
 	}
 
+	void setRenderStats(const RenderStats::Recorder* stats) { renderStats = stats; }
+	// -1 when the curve is tessellated on the GPU
+	void setCurveVertexCount(int count) { curveVertexCount = count; }
+
 	glm::vec3 getColor() const {
 		return glm::vec3(colorValue[0], colorValue[1], colorValue[2]);
 	}
@@ -351,11 +436,32 @@ public:
 		ImGui::Spacing();
 	}
 
+	// One button per path the context has, nothing if it only has the CPU
+	void geometryPathButtons() {
+		if (!Tessellation::isSupported() && !ComputeSubdivision::isSupported()) {
+			return;
+		}
+		ImGui::Text("Made On:");
+		ImGui::SameLine();
+		ImGui::RadioButton("CPU", &geometryPathSelection, CPU_PATH);
+		if (Tessellation::isSupported()) {
+			ImGui::SameLine();
+			ImGui::RadioButton("Tessellation Shaders", &geometryPathSelection, TESSELLATION_PATH);
+		}
+		if (ComputeSubdivision::isSupported()) {
+			ImGui::SameLine();
+			ImGui::RadioButton("Compute Shaders", &geometryPathSelection, COMPUTE_PATH);
+		}
+		curveEditorPanelInput.geometryPath = static_cast<GEOMETRY_PATH>(geometryPathSelection);
+	}
+
 	/*-------------------------------------------------------*/
 	enum CURVE_TYPE getCurveType() { return curveType; }
 
 private:
 	float colorValue[3];  // Array for RGB color values
+	const RenderStats::Recorder* renderStats = nullptr;
+	int curveVertexCount = 0;
 
 	enum CURVE_TYPE curveType;
 
@@ -364,171 +470,54 @@ private:
 
 	const char* pointOptions[3]; // Options for the point combo box
 	int pointComboSelection;
-};
-
-/*------------------------ de Casteljau Algorithm -----------------------*/
-glm::vec3 deCasteljau(std::vector<glm::vec3>& controlPoints, float u) {
-	// Copy of controlPoints to play with
-	std::vector<glm::vec3> P = controlPoints;
-
-	// Degree: n + 1
-	int d = P.size();
-
-	// Create smaller control points
-	for (int i = 1; i < d; ++i) {
-		for (int j = 0; j < (d - i); ++j) {
-			P[j] = (1.0f - u) * P[j] + u * P[j + 1];
-		}
-	}
 
-	// Return curve point 
-	return P[0];
-}
-
-/*----------------- Chaikin Curve Subdivision Algorithm -----------------*/
-std::vector<glm::vec3> chaikinCurveSubdivision(std::vector<glm::vec3>& coarsePoints, int iterations = 8) {
-	// No iterations or not enough points to subdivide
-	int n = coarsePoints.size();
-	if ((iterations == 0) || (n < 2)) {
-		return coarsePoints;
-	}
-
-	std::vector<glm::vec3> C = coarsePoints;
-	std::vector<glm::vec3> F;
-
-	// Special mask at the beginning
-	F.push_back(C[0]);
-	F.push_back(0.5f*C[0] + 0.5f*C[1]);
-
-	// Periodic mask for the interior points
-	for (int i = 1; i < n - 2; ++i) {
-		F.push_back(0.75f * C[i] + 0.25f * C[i + 1]);
-		F.push_back(0.25f * C[i] + 0.75f * C[i + 1]);
-	}
-
-	// Special mask at the end
-	F.push_back(0.5f * C[n - 2] + 0.5f * C[n - 1]);
-	F.push_back(C[n - 1]);
-
-	// Perform subdivision on fine points if there are more iterations
-	return chaikinCurveSubdivision(F, iterations - 1);
-}
-
-/*-------------------- Generate Surface of Revolution -------------------*/
-std::vector<glm::vec3> surfaceOfRevolution(const std::vector<glm::vec3>& curvePoints, int n_slices = 21) {
-	std::vector<glm::vec3> surface_verts;
-
-	// Angle between each curve
-	float angle_step = 2.0f * M_PI / n_slices;
-
-	// For each curve point, create triangles with adjacent curve points
-	for (int i = 0; i < curvePoints.size() - 1; i++) {
-		glm::vec3 p1 = curvePoints[i];
-		glm::vec3 p2 = curvePoints[i + 1];
-
-		for (int j = 0; j < n_slices; j++) {
-			float angle = j * angle_step;
-			float next_angle = (j + 1) * angle_step;
-
-			glm::vec3 v1(p1.x * cos(angle), p1.y, p1.x * sin(angle));
-			glm::vec3 v2(p2.x * cos(angle), p2.y, p2.x * sin(angle));
-			glm::vec3 v3(p2.x * cos(next_angle), p2.y, p2.x * sin(next_angle));
-			glm::vec3 v4(p1.x * cos(next_angle), p1.y, p1.x * sin(next_angle));
-
-			surface_verts.push_back(v1);
-			surface_verts.push_back(v2);
-			surface_verts.push_back(v3);
-			surface_verts.push_back(v1);
-			surface_verts.push_back(v3);
-			surface_verts.push_back(v4);
-		}
-	}
-
-	return surface_verts;
-}
-
-/*------------------ Generate Tensor Product Surface -------------------*/
-std::vector<glm::vec3> tensorProductSurface(std::vector<std::vector<glm::vec3>>& controlPoints, int iterations = 3) {
-
-	// Smooth each row by applying chaikin algorithm
-	std::vector<std::vector<glm::vec3>> smoothedRows;
-	for (const std::vector<glm::vec3>& row : controlPoints) {
-		std::vector<glm::vec3> coarseRow = row;
-		smoothedRows.push_back(chaikinCurveSubdivision(coarseRow, iterations));
-	}
-
-	// Transpose smoothed grid
-	std::vector<std::vector<glm::vec3>> transposedGrid;
-	for (int i = 0; i < smoothedRows[0].size(); i++) {
-		std::vector<glm::vec3> column;
-		for (std::vector<glm::vec3>& row : smoothedRows) {
-			column.push_back(row[i]);
-		}
-		transposedGrid.push_back(column);
-	}
-
-	// Smooth each column (rows in transposed grid)
-	std::vector<std::vector<glm::vec3>> smoothedColumns;
-	for (const std::vector<glm::vec3>& column : transposedGrid) {
-		std::vector<glm::vec3> col = column;
-		smoothedColumns.push_back(chaikinCurveSubdivision(col, iterations));
-	}
-
-	// Transpose grid back to original layout
-	std::vector<std::vector<glm::vec3>> finalGrid;
-	for (int i = 0; i < smoothedColumns[0].size(); i++) {
-		std::vector<glm::vec3> row;
-		for (const auto& col : smoothedColumns) {
-			row.push_back(col[i]);
-		}
-		finalGrid.push_back(row);
-	}
-
-	// Generate triangles
-	std::vector<glm::vec3> surfacePoints;
-	for (int i = 0; i < finalGrid.size() - 1; i++) {
-		for (int j = 0; j < finalGrid[i].size() - 1; j++) {
-			glm::vec3 v1 = finalGrid[i][j];
-			glm::vec3 v2 = finalGrid[i + 1][j];
-			glm::vec3 v3 = finalGrid[i + 1][j + 1];
-			glm::vec3 v4 = finalGrid[i][j + 1];
-
-			surfacePoints.push_back(v1);
-			surfacePoints.push_back(v2);
-			surfacePoints.push_back(v3);
-
-			surfacePoints.push_back(v1);
-			surfacePoints.push_back(v3);
-			surfacePoints.push_back(v4);
-		}
-	}
-
-	return surfacePoints;
-}
+	int geometryPathSelection = CPU_PATH;
+};
 
 /*--------------------------- Extra Functions ---------------------------*/
-int selectControlPoint(std::vector<glm::vec3>& controlPoints, glm::vec3 cursorPos, bool mousePress) {
-	if (!mousePress || controlPoints.empty()) {
+// The first control point near the cursor, through the index of the control points
+int selectControlPoint(const PointIndex& controlPointIndex, glm::vec3 cursorPos, bool mousePress) {
+	if (!mousePress) {
 		return -1;
 	}
+	return controlPointIndex.findFirstWithin(cursorPos, POINT_PROXIMITY_THRESHOLD);
+}
 
-	for (int i = 0; i < controlPoints.size(); i++) {
-		float distance = glm::length(cursorPos - controlPoints[i]);
+// World space ray under the cursor, from the near plane to the far plane
+void cursorRay(const glm::mat4& viewProjection, glm::vec2 cursorPixels, glm::vec3& origin, glm::vec3& direction) {
+	glm::vec2 scaledToZeroOne = (cursorPixels + glm::vec2(0.5f, 0.5f)) / glm::vec2(WINDOW_WIDTH, WINDOW_HEIGHT);
+	glm::vec2 ndc = glm::vec2(scaledToZeroOne.x, 1.0f - scaledToZeroOne.y) * 2.0f - glm::vec2(1.0f, 1.0f);
 
-		if (distance <= POINT_PROXIMITY_THRESHOLD) {
-			return i;
-		}
-	}
-
-	return -1;
+	glm::mat4 inverse = glm::inverse(viewProjection);
+	glm::vec4 nearPoint = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverse * glm::vec4(ndc, 1.0f, 1.0f);
+	origin = glm::vec3(nearPoint) / nearPoint.w;
+	direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
 }
 
-int main() {
+int main(int argc, char** argv) {
 	Log::debug("Starting main");
 
+	// Headless benchmarks, e.g. --bench=bezier. The GPU ones get a hidden window.
+	argh::parser cmdl(argc, argv);
+	std::string benchmark;
+	if ((cmdl("bench") >> benchmark) && !Benchmark::needsContext(benchmark)) {
+		return Benchmark::run(benchmark) ? 0 : 1;
+	}
+
 	// WINDOW
 	glfwInit();
 	glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE); // Make the window non-resizable
+
+	// CPU path against the tessellation shaders, or a GPU benchmark, in a hidden window
+	if (cmdl["compare-tessellation"] || !benchmark.empty()) {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		Window hidden(WINDOW_WIDTH, WINDOW_HEIGHT, "CPSC 453: Assignment 3");
+		const bool pass = benchmark.empty() ? TessellationCheck::run() : Benchmark::run(benchmark);
+		glfwTerminate();
+		return pass ? 0 : 1;
+	}
+
 	Window window(WINDOW_WIDTH, WINDOW_HEIGHT, "CPSC 453: Assignment 3");
 	Panel panel(window.getGLFWwindow());
 
@@ -547,6 +536,14 @@ int main() {
 	//Panel inputs
 	panel.setPanelRenderer(curve_editor_panel_renderer);
 
+	// Performance stats, shown from the panel. --stats-csv=FILE writes every frame to FILE
+	RenderStats::Recorder renderStats;
+	curve_editor_panel_renderer->setRenderStats(&renderStats);
+	std::string statsCsvPath = cmdl("stats-csv").str();
+	if (!statsCsvPath.empty() && !renderStats.openCsv(statsCsvPath)) {
+		Log::error("STATS could not write {}", statsCsvPath);
+	}
+
 	ShaderProgram shader_program_default(
 		"shaders/test.vert",
 		"shaders/test.frag"
@@ -559,6 +556,23 @@ int main() {
 		{-.5f,  .5f, 0.f}
 	};
 
+	// For picking control points out of however many there are
+	PointIndex cp_index(POINT_PROXIMITY_THRESHOLD);
+	cp_index.rebuild(cp_positions_vector);
+
+	// The tensor nets can be edited, so each gets a copy of its own, and
+	// the one on show gets an index for ray picking
+	Grid<glm::vec3> tensor_nets[2] = { tensorSurface1, tensorSurface2 };
+	PointIndex tensor_index(TENSOR_PICK_RADIUS);
+	DirtyCheck<int> tensor_index_inputs;
+	uint64_t tensor_version = 0;											// bumped by every edit to a net
+	int held_tensor_point = -1;
+	bool was_mouse_down = false;
+
+	// The edit that made tensor_version what it is, if it was a drag
+	int dragged_tensor_point = -1;
+	uint64_t dragged_tensor_version = 0;
+
 	glm::vec3 cp_point_colour	= { 1.f,0.f,0.f };
 	glm::vec3 cp_line_colour	= { 0.f,1.f,0.f };
 
@@ -570,17 +584,77 @@ int main() {
 	CPU_Geometry cp_line_cpu;
 	GPU_Geometry cp_line_gpu;
 
+	// Bezier curves are sampled every 0.01, end point included, unless
+	// they are flattened adaptively
+	Bezier::UniformSampler bezier_sampler(101);
+	CurveFlattener curve_flattener;
+
+	// B-splines keep every Chaikin round, so dragging a point redoes and
+	// re-uploads only the stretch of curve it reaches
+	Chaikin::Refinement<glm::vec3> bspline_curve;
+
+	// Kept across frames so they keep their memory
+	std::vector<glm::vec3> sor_profile;
+	std::vector<glm::vec3> chaikin_scratch;
+
+	// The edit that made cp_version what it is, if it was a drag
+	int dragged_point = -1;
+	uint64_t dragged_version = 0;
+
+	// Everything below is rebuilt only when what it was built from changes:
+	// control points -> curve or surface profile -> surface mesh -> GPU
+	// buffers. Edits to the control points bump cp_version, and each stage
+	// that rebuilds bumps its own version for the stages after it.
+	uint64_t cp_version = 0;
+	uint64_t sor_profile_version = 0;
+	uint64_t curve_cp_version = ~uint64_t(0);									// cp_version the curve was last built from
+	DirtyCheck<CURVE_TYPE, bool, float, glm::mat4> curve_settings;				// the rest of what the curve depends on
+	DirtyCheck<uint64_t, int> sor_profile_inputs;
+	DirtyCheck<uint64_t, int> surface_inputs;									// surface and its buffers
+	DirtyCheck<int, int, uint64_t> tensor_inputs;								// tensor surface and its buffers
+	uint64_t cp_geometry_cp_version = ~uint64_t(0);								// cp_version the control point buffers show
+	DirtyCheck<bool, int, uint64_t> cp_geometry_settings;						// the rest of what they show
+
 	// curve geometry
 	CPU_Geometry curve_cpu_geom;
 	GPU_Geometry curve_gpu_geom;	
 
 	// Surface geometry
+	SurfaceOfRevolution surface_of_revolution;
 	CPU_Geometry surface_cpu_geom;
-	GPU_Geometry surface_gpu_geom;
+	std::vector<GLuint> surface_indices;
+	GPU_IndexedGeometry surface_gpu_geom;
 
 	// Tensor geometry
+	TensorSurface tensor_surface;
+	Grid<glm::vec3> tensor_grid;
 	CPU_Geometry tensor_cpu_geom;
-	GPU_Geometry tensor_gpu_geom;
+	std::vector<GLuint> tensor_indices;
+	GPU_IndexedGeometry tensor_gpu_geom;
+
+	// Hardware tessellation, where the context has it. These hold copies of
+	// the control points on the GPU, kept up to date the same way as the
+	// buffers above.
+	std::optional<TessellatedCurve> tessellated_curve;
+	std::optional<TessellatedSurface> tessellated_surface;
+	if (Tessellation::isSupported()) {
+		tessellated_curve.emplace();
+		tessellated_surface.emplace();
+	}
+	uint64_t tessellated_curve_cp_version = ~uint64_t(0);					// cp_version the tessellated curve has
+	int tessellated_net_mode = 0;												// tensorMode and tensor_version the tessellated net has
+	uint64_t tessellated_net_version = ~uint64_t(0);
+
+	// Compute shader subdivision, where the context has it. Its results
+	// stay on the GPU, and are redone there whenever their inputs change.
+	std::optional<ComputeSubdivision> curve_subdivision;
+	std::optional<ComputeSubdivision> tensor_subdivision;
+	if (ComputeSubdivision::isSupported()) {
+		curve_subdivision.emplace();
+		tensor_subdivision.emplace();
+	}
+	uint64_t subdivided_curve_cp_version = ~uint64_t(0);					// cp_version the subdivided curve was made from
+	DirtyCheck<int, int, uint64_t> subdivided_tensor_inputs;
 
 	while (!window.shouldClose()) {
 
@@ -595,6 +669,7 @@ int main() {
 		}
 
 		glfwPollEvents();
+		renderStats.beginFrame();
 		CurveEditorPanelInput panelInput = curveEditorPanelInput;
 		CurveEditorCallbackInput callbackInput = curveEditorInput;
 		glm::vec3 background_colour = curve_editor_panel_renderer->getColor();
@@ -615,6 +690,8 @@ int main() {
 		if (resetPoints) {
 			resetPoints = false;
 			cp_positions_vector.clear();
+			cp_index.clear();
+			cp_version++;
 		}
 
 		// Reset camera
@@ -629,19 +706,11 @@ int main() {
 		// selected Control point initialized to -1
 		int selectedControlPoint =  -1;
 
-		// Curve points
-		std::vector<glm::vec3> curve_points;
-
-		// Surface of revolution verts
-		std::vector<glm::vec3> surface_verts;
-
 		// Tensor Points
-		std::vector<std::vector<glm::vec3>> tensorPoints;
-		if (curveEditorPanelInput.tensorMode == 1) {
-			tensorPoints = tensorSurface1;
-		}
-		else {
-			tensorPoints = tensorSurface2;
+		Grid<glm::vec3>& tensorPoints = tensor_nets[(panelInput.tensorMode == 1) ? 0 : 1];
+		if (tensor_index_inputs.changed(panelInput.tensorMode)) {
+			tensor_index.rebuild(tensorPoints.getCells());
+			held_tensor_point = -1;
 		}
 
 		/*----------------------------------------------------------- 3D View or 2D Point Editor-----------------------------------------------------------*/
@@ -652,23 +721,31 @@ int main() {
 
 			/*------------------------ Control points  ------------------------*/
 			// Select a control point
-			selectedControlPoint = selectControlPoint(cp_positions_vector, callbackInput.cursorPos, callbackInput.mousePress);
+			selectedControlPoint = selectControlPoint(cp_index, callbackInput.cursorPos, callbackInput.mousePress);
 			switch (panelInput.pointMode) {
 			case SELECT_MODE:
-				if (selectedControlPoint != -1) {
+				if (selectedControlPoint != -1 && cp_positions_vector[selectedControlPoint] != callbackInput.cursorPos) {
 					cp_positions_vector[selectedControlPoint] = callbackInput.cursorPos;
+					cp_index.move(selectedControlPoint, callbackInput.cursorPos);
+					cp_version++;
+					dragged_point = selectedControlPoint;
+					dragged_version = cp_version;
 				}
 				break;
 			case INSERT_MODE:
-				if (callbackInput.mousePress && letGo && (cp_positions_vector.size() < 12)) {
+				if (callbackInput.mousePress && letGo) {
 					glm::vec3 newPoint = callbackInput.cursorPos;
 					cp_positions_vector.push_back(newPoint);
+					cp_index.insert(static_cast<int>(cp_positions_vector.size()) - 1, newPoint);
+					cp_version++;
 					letGo = false;
 				}
 				break;
 			case DELETE_MODE:
 				if (selectedControlPoint != -1) {
 					cp_positions_vector.erase(cp_positions_vector.begin() + selectedControlPoint);
+					cp_index.erase(selectedControlPoint);
+					cp_version++;
 				}
 				break;
 			default:
@@ -683,24 +760,79 @@ int main() {
 			break;
 		}
 
+		/*------------------------ Tensor net control points ------------------------*/
+		// Press on a control point to pick it up, drag to move it across the
+		// screen at the depth it was picked at, release to let go
+		const bool mouse_down = turn_table_3D_viewer_callback->isMouseDown();
+		if (panelInput.programMode == TENSOR) {
+			glm::vec3 ray_origin, ray_direction;
+			cursorRay(viewProjection, turn_table_3D_viewer_callback->getCursorPos(), ray_origin, ray_direction);
+
+			if (mouse_down && !was_mouse_down) {
+				held_tensor_point = tensor_index.pickRay(ray_origin, ray_direction, TENSOR_PICK_RADIUS);
+			}
+			else if (!mouse_down) {
+				held_tensor_point = -1;
+			}
+			turn_table_3D_viewer_callback->holdPoint(held_tensor_point != -1);
+
+			if (held_tensor_point != -1) {
+				const size_t row = held_tensor_point / tensorPoints.getColumns();
+				const size_t column = held_tensor_point % tensorPoints.getColumns();
+				glm::vec3& point = tensorPoints.at(row, column);
+
+				// Onto the plane through the point that faces the camera
+				glm::vec3 facing = glm::normalize(turn_table_3D_viewer_callback->getCameraPosition());
+				float along = glm::dot(ray_direction, facing);
+				if (std::abs(along) > 1e-6f) {
+					glm::vec3 moved = ray_origin + (glm::dot(point - ray_origin, facing) / along) * ray_direction;
+					if (moved != point) {
+						point = moved;
+						tensor_index.move(held_tensor_point, moved);
+						tensor_version++;
+						dragged_tensor_point = held_tensor_point;
+						dragged_tensor_version = tensor_version;
+					}
+				}
+			}
+		}
+		else {
+			held_tensor_point = -1;
+			turn_table_3D_viewer_callback->holdPoint(false);
+		}
+		was_mouse_down = mouse_down;
+
 		// Send new-projection matrix to vertex shader
 		glUniformMatrix4fv(
 			glGetUniformLocation(shader_program_default.getProgram(), "transformationMatrix"),
 			1, GL_FALSE, glm::value_ptr(viewProjection)
 		);
 
+		// Lighting for filled surfaces, from the camera. Off unless a surface turns it on.
+		GLint shadedLocation = glGetUniformLocation(shader_program_default.getProgram(), "shaded");
+		glm::vec3 lightDirection = glm::normalize(turn_table_3D_viewer_callback->getCameraPosition());
+		glUniform1i(shadedLocation, GL_FALSE);
+		glUniform3fv(glGetUniformLocation(shader_program_default.getProgram(), "lightDirection"), 1, glm::value_ptr(lightDirection));
+
 		/*----------------------------------------------------------- Scene Type -----------------------------------------------------------*/
 		switch (panelInput.programMode) {
 		case SURFACE_OF_REVOLUTION:
 			// Calculate surface points
-			surface_cpu_geom.verts.clear();
-			surface_cpu_geom.verts = surfaceOfRevolution(chaikinCurveSubdivision(cp_positions_vector, curveEditorPanelInput.sorIterations), curveEditorPanelInput.sorSlices);
-			surface_cpu_geom.cols = std::vector<glm::vec3>(surface_cpu_geom.verts.size(), glm::vec3(0.f, 0.f, 0.f));
+			if (sor_profile_inputs.changed(cp_version, panelInput.sorIterations)) {
+				Chaikin::subdivide(cp_positions_vector.data(), cp_positions_vector.size(), panelInput.sorIterations, sor_profile, chaikin_scratch);
+				sor_profile_version++;
+			}
+			if (surface_inputs.changed(sor_profile_version, panelInput.sorSlices)) {
+				surface_of_revolution.generate(sor_profile, panelInput.sorSlices, surface_cpu_geom.verts, surface_cpu_geom.normals, surface_indices);
+				surface_cpu_geom.cols.assign(surface_cpu_geom.verts.size(), glm::vec3(0.f, 0.f, 0.f));
+
+				surface_gpu_geom.setVerts(surface_cpu_geom.verts);
+				surface_gpu_geom.setCols(surface_cpu_geom.cols);
+				surface_gpu_geom.setNormals(surface_cpu_geom.normals);
+				surface_gpu_geom.setIndices(surface_indices);
+			}
 
 			// Render Surface
-			surface_gpu_geom.setVerts(surface_cpu_geom.verts);
-			surface_gpu_geom.setCols(surface_cpu_geom.cols);
-
 			// Wireframe mode on/off
 			if (panelInput.wireframeMode) {
 				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -709,16 +841,12 @@ int main() {
 				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 			}
 			surface_gpu_geom.bind();
-			glDrawArrays(GL_TRIANGLES, 0, surface_cpu_geom.verts.size());
+			glUniform1i(shadedLocation, panelInput.wireframeMode ? GL_FALSE : GL_TRUE);
+			glDrawElements(GL_TRIANGLES, surface_indices.size(), GL_UNSIGNED_INT, 0);
+			glUniform1i(shadedLocation, GL_FALSE);
+			RenderStats::countDrawCall();
 			break;
 		case TENSOR:
-			tensor_cpu_geom.verts.clear();
-			tensor_cpu_geom.verts = tensorProductSurface(tensorPoints, curveEditorPanelInput.tensorIterations);
-			tensor_cpu_geom.cols = std::vector<glm::vec3>(tensor_cpu_geom.verts.size(), glm::vec3(0.f, 0.f, 0.f));
-
-			tensor_gpu_geom.setVerts(tensor_cpu_geom.verts);
-			tensor_gpu_geom.setCols(tensor_cpu_geom.cols);
-
 			// Wireframe mode on/off
 			if (panelInput.wireframeMode) {
 				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -727,123 +855,222 @@ int main() {
 				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 			}
 
+			if (tessellated_surface && panelInput.geometryPath == TESSELLATION_PATH && TessellatedSurface::canDraw(tensorPoints)) {
+				if (tessellated_net_mode != panelInput.tensorMode || tessellated_net_version != tensor_version) {
+					// Just the point, if one point was dragged since the last upload
+					if (tessellated_net_mode == panelInput.tensorMode && dragged_tensor_version == tensor_version
+						&& tessellated_net_version + 1 == tensor_version) {
+						const size_t row = dragged_tensor_point / tensorPoints.getColumns();
+						const size_t column = dragged_tensor_point % tensorPoints.getColumns();
+						tessellated_surface->moveControlPoint(row, column, tensorPoints.at(row, column));
+					}
+					else {
+						tessellated_surface->setNet(tensorPoints);
+					}
+					tessellated_net_mode = panelInput.tensorMode;
+					tessellated_net_version = tensor_version;
+				}
+				tessellated_surface->draw(viewProjection, glm::vec2(WINDOW_WIDTH, WINDOW_HEIGHT), panelInput.curveTolerance, glm::vec3(0.f, 0.f, 0.f));
+				shader_program_default.use();
+				break;
+			}
+
+			if (tensor_subdivision && panelInput.geometryPath == COMPUTE_PATH) {
+				if (subdivided_tensor_inputs.changed(panelInput.tensorMode, panelInput.tensorIterations, tensor_version)) {
+					tensor_subdivision->subdivide(tensorPoints, panelInput.tensorIterations);
+					shader_program_default.use();
+				}
+				tensor_subdivision->drawTriangles();
+				break;
+			}
+
+			if (tensor_inputs.changed(panelInput.tensorMode, panelInput.tensorIterations, tensor_version)) {
+				tensor_surface.generate(tensorPoints, panelInput.tensorIterations, tensor_grid, tensor_indices);
+				tensor_cpu_geom.cols.assign(tensor_grid.getCells().size(), glm::vec3(0.f, 0.f, 0.f));
+
+				tensor_gpu_geom.setVerts(tensor_grid.getCells());
+				tensor_gpu_geom.setCols(tensor_cpu_geom.cols);
+				tensor_gpu_geom.setIndices(tensor_indices);
+			}
+
 			tensor_gpu_geom.bind();
-			glDrawArrays(GL_TRIANGLES, 0, tensor_cpu_geom.verts.size());
+			glDrawElements(GL_TRIANGLES, tensor_indices.size(), GL_UNSIGNED_INT, 0);
+			RenderStats::countDrawCall();
 			break;
 		default:
-			// Calculate curve points
-			if (!cp_positions_vector.empty()) {
-				switch (panelInput.curveType) {
-				case BEZIER:
-					for (float u = 0.0f; u < 1.0f; u += 0.01f) {
-						glm::vec3 curve_point = deCasteljau(cp_positions_vector, u);
-						curve_points.push_back(curve_point);
+			// Tessellated curves only need the control points on the GPU.
+			// Bezier curves too long for one patch are left to the CPU.
+			if (tessellated_curve && panelInput.geometryPath == TESSELLATION_PATH
+				&& (panelInput.curveType == B_SPLINE || cp_positions_vector.size() <= TessellatedCurve::MAX_BEZIER_POINTS)) {
+				if (tessellated_curve_cp_version != cp_version) {
+					if (dragged_version == cp_version && tessellated_curve_cp_version + 1 == cp_version
+						&& tessellated_curve->getControlPointCount() == cp_positions_vector.size()) {
+						tessellated_curve->moveControlPoint(dragged_point, cp_positions_vector[dragged_point]);
 					}
-					break;
-				case B_SPLINE:
-					curve_points = chaikinCurveSubdivision(cp_positions_vector);
-					break;
+					else {
+						tessellated_curve->setControlPoints(cp_positions_vector);
+					}
+					tessellated_curve_cp_version = cp_version;
+				}
+				const glm::vec2 viewport(WINDOW_WIDTH, WINDOW_HEIGHT);
+				if (panelInput.curveType == BEZIER) {
+					tessellated_curve->drawBezier(viewProjection, viewport, panelInput.curveTolerance, glm::vec3(0.f, 0.f, 0.f));
+				}
+				else {
+					tessellated_curve->drawBSpline(viewProjection, viewport, panelInput.curveTolerance, glm::vec3(0.f, 0.f, 0.f));
 				}
+				shader_program_default.use();
+				curve_editor_panel_renderer->setCurveVertexCount(-1);
+				break;
 			}
 
+			// The compute shaders do the B-spline's 8 Chaikin rounds
+			if (curve_subdivision && panelInput.geometryPath == COMPUTE_PATH && panelInput.curveType == B_SPLINE) {
+				if (subdivided_curve_cp_version != cp_version) {
+					curve_subdivision->subdivide(cp_positions_vector, 8);
+					shader_program_default.use();
+					subdivided_curve_cp_version = cp_version;
+				}
+				curve_subdivision->drawLineStrip();
+				curve_editor_panel_renderer->setCurveVertexCount(static_cast<int>(curve_subdivision->getColumns() * curve_subdivision->getRows()));
+				break;
+			}
+
+			// Calculate curve points, straight into the curve geometry.
+			// Adaptive curves depend on the camera too.
+			glm::mat4 toPixels = panelInput.adaptiveCurves ? CurveFlattener::toPixels(viewProjection, WINDOW_WIDTH, WINDOW_HEIGHT) : glm::mat4(1.0f);
+			const bool curve_settings_changed = curve_settings.changed(panelInput.curveType, panelInput.adaptiveCurves, panelInput.curveTolerance, toPixels);
+			const bool subdivided_bspline = (panelInput.curveType == B_SPLINE && !panelInput.adaptiveCurves);
+
+			// One point dragged since the last build, and nothing else changed
+			const bool local_update = !curve_settings_changed && subdivided_bspline
+				&& dragged_version == cp_version && curve_cp_version + 1 == cp_version
+				&& bspline_curve.getControlPointCount() == cp_positions_vector.size();
+
+			if (local_update) {
+				auto [first, last] = bspline_curve.move(dragged_point, cp_positions_vector[dragged_point]);
+				const std::vector<glm::vec3>& refined = bspline_curve.result();
+				std::copy(refined.begin() + first, refined.begin() + last, curve_cpu_geom.verts.begin() + first);
+				curve_gpu_geom.updateVerts(first, refined.data() + first, last - first);
+				curve_cp_version = cp_version;
+			}
+			else if (curve_settings_changed || curve_cp_version != cp_version) {
+				curve_cp_version = cp_version;
+				std::vector<glm::vec3>& curve_points = curve_cpu_geom.verts;
+				curve_points.clear();
+				// Long Bezier curves cost too much to split, so they are sampled
+				const bool flatten = panelInput.adaptiveCurves
+					&& !(panelInput.curveType == BEZIER && cp_positions_vector.size() > CurveFlattener::MAX_BEZIER_POINTS);
+				if (!cp_positions_vector.empty() && flatten) {
+					switch (panelInput.curveType) {
+					case BEZIER:
+						curve_flattener.flattenBezier(cp_positions_vector.data(), cp_positions_vector.size(), toPixels, panelInput.curveTolerance, curve_points);
+						break;
+					case B_SPLINE:
+						curve_flattener.flattenBSpline(cp_positions_vector.data(), cp_positions_vector.size(), toPixels, panelInput.curveTolerance, curve_points);
+						break;
+					}
+				}
+				else if (!cp_positions_vector.empty()) {
+					switch (panelInput.curveType) {
+					case BEZIER:
+						curve_points.resize(bezier_sampler.getSampleCount());
+						bezier_sampler.evaluate(cp_positions_vector.data(), cp_positions_vector.size(), curve_points.data());
+						break;
+					case B_SPLINE:
+						bspline_curve.rebuild(cp_positions_vector.data(), cp_positions_vector.size(), 8);
+						curve_points = bspline_curve.result();
+						break;
+					}
+				}
+				curve_cpu_geom.cols.assign(curve_points.size(), { 0.0f, 0.0f, 0.0f }); // black curve line
+
+				curve_gpu_geom.setVerts(curve_cpu_geom.verts);
+				curve_gpu_geom.setCols(curve_cpu_geom.cols);
+			}
+			curve_editor_panel_renderer->setCurveVertexCount(static_cast<int>(curve_cpu_geom.verts.size()));
+
 			// Render Curve
-			curve_cpu_geom.verts = curve_points;
-			curve_cpu_geom.cols = std::vector<glm::vec3>(curve_points.size(), { 0.0f, 0.0f, 0.0f }); // black curve line
-			curve_gpu_geom.setVerts(curve_cpu_geom.verts);
-			curve_gpu_geom.setCols(curve_cpu_geom.cols);
 			curve_gpu_geom.bind();
 			glDrawArrays(GL_LINE_STRIP, 0, curve_cpu_geom.verts.size());
-			break;
-
+			RenderStats::countDrawCall();
 			break;
 		}
 
 
 		/*------------------------------------------------------- Control Points and Control Point Lines -------------------------------------------------------*/
-		switch (curveEditorPanelInput.programMode) {
-		case TENSOR:
-			if (panelInput.renderControlPoints) {
-				cp_point_cpu.verts.clear();
-				cp_point_cpu.cols.clear();
-
-				for (auto& row : tensorPoints) {
-					for (auto& point : row) {
-						cp_point_cpu.verts.push_back(point);
-					}
-				}
-
-				cp_point_cpu.cols = std::vector<glm::vec3>(cp_point_cpu.verts.size(), cp_point_colour);
-				cp_point_gpu.setVerts(cp_point_cpu.verts);
-				cp_point_gpu.setCols(cp_point_cpu.cols);
-
-				cp_point_gpu.bind();
-				glPointSize(15.f);
-				glDrawArrays(GL_POINTS, 0, cp_point_cpu.verts.size());
-			}
-
+		// Rebuilt when switching between the tensor net and the editor's
+		// points, or when either changes. Dragging one of the editor's
+		// points only moves its own vertex.
+		const bool showTensorNet = (panelInput.programMode == TENSOR);
+		const bool cp_geometry_settings_changed = cp_geometry_settings.changed(showTensorNet, panelInput.tensorMode, tensor_version);
+		if (!cp_geometry_settings_changed && !showTensorNet
+			&& dragged_version == cp_version && cp_geometry_cp_version + 1 == cp_version) {
+			const glm::vec3& moved = cp_positions_vector[dragged_point];
+			cp_point_cpu.verts[dragged_point] = moved;
+			cp_line_cpu.verts[dragged_point] = moved;
+			cp_point_gpu.updateVerts(dragged_point, &moved, 1);
+			cp_line_gpu.updateVerts(dragged_point, &moved, 1);
+			cp_geometry_cp_version = cp_version;
+		}
+		else if (cp_geometry_settings_changed || cp_geometry_cp_version != cp_version) {
+			cp_geometry_cp_version = cp_version;
+			cp_point_cpu.verts.clear();
+			cp_line_cpu.verts.clear();
 
-			// Tensor Product Surface Control Point Lines
-			if (panelInput.renderControlPointLines) {
-				cp_line_cpu.verts.clear();
-				cp_line_cpu.cols.clear();
+			if (showTensorNet) {
+				cp_point_cpu.verts = tensorPoints.getCells();
 
 				// Draw Horizontal Lines (connect adjacent control points in each row)
-				for (int i = 0; i < tensorPoints.size(); i++) {
-					for (int j = 0; j < tensorPoints[i].size() - 1; j++) {
-						cp_line_cpu.verts.push_back(tensorPoints[i][j]);
-						cp_line_cpu.verts.push_back(tensorPoints[i][j + 1]);
-						cp_line_cpu.cols.push_back(cp_line_colour);
-						cp_line_cpu.cols.push_back(cp_line_colour);
+				for (size_t i = 0; i < tensorPoints.getRows(); i++) {
+					for (size_t j = 0; j + 1 < tensorPoints.getColumns(); j++) {
+						cp_line_cpu.verts.push_back(tensorPoints.at(i, j));
+						cp_line_cpu.verts.push_back(tensorPoints.at(i, j + 1));
 					}
 				}
 
 				// Draw Vertical Lines (connect adjacent control points in each column)
-				for (int j = 0; j < tensorPoints[0].size(); j++) {
-					for (int i = 0; i < tensorPoints.size() - 1; i++) {
-						cp_line_cpu.verts.push_back(tensorPoints[i][j]);
-						cp_line_cpu.verts.push_back(tensorPoints[i + 1][j]);
-						cp_line_cpu.cols.push_back(cp_line_colour);
-						cp_line_cpu.cols.push_back(cp_line_colour);
+				for (size_t j = 0; j < tensorPoints.getColumns(); j++) {
+					for (size_t i = 0; i + 1 < tensorPoints.getRows(); i++) {
+						cp_line_cpu.verts.push_back(tensorPoints.at(i, j));
+						cp_line_cpu.verts.push_back(tensorPoints.at(i + 1, j));
 					}
 				}
-
-				cp_line_gpu.setVerts(cp_line_cpu.verts);
-				cp_line_gpu.setCols(cp_line_cpu.cols);
-				cp_line_gpu.bind();
-				glDrawArrays(GL_LINES, 0, cp_line_cpu.verts.size());
 			}
-			break;
-		default:
-			if (!cp_positions_vector.empty()) {
-				// Control Point ----------------
-				if (panelInput.renderControlPoints) { // Optional: render/unrender cp
-					cp_point_cpu.verts = cp_positions_vector;
-					cp_point_cpu.cols = std::vector<glm::vec3>(cp_point_cpu.verts.size(), cp_point_colour);
-					cp_point_gpu.setVerts(cp_point_cpu.verts);
-					cp_point_gpu.setCols(cp_point_cpu.cols);
-
-					cp_point_gpu.bind();
-					glPointSize(15.f);
-					glDrawArrays(GL_POINTS, 0, cp_point_cpu.verts.size());
-				}
+			else {
+				cp_point_cpu.verts = cp_positions_vector;
+				cp_line_cpu.verts = cp_positions_vector; // We are using GL_LINE_STRIP (change this if you want to use GL_LINES)
+			}
 
-				// Control Point Line ------------
-				if (panelInput.renderControlPointLines) { // Optional: render/unrender cp lines
-					cp_line_cpu.verts = cp_positions_vector; // We are using GL_LINE_STRIP (change this if you want to use GL_LINES)
-					cp_line_cpu.cols = std::vector<glm::vec3>(cp_point_cpu.verts.size(), cp_line_colour);
-					cp_line_gpu.setVerts(cp_line_cpu.verts);
-					cp_line_gpu.setCols(cp_line_cpu.cols);
+			cp_point_cpu.cols.assign(cp_point_cpu.verts.size(), cp_point_colour);
+			cp_line_cpu.cols.assign(cp_line_cpu.verts.size(), cp_line_colour);
+			cp_point_gpu.setVerts(cp_point_cpu.verts);
+			cp_point_gpu.setCols(cp_point_cpu.cols);
+			cp_line_gpu.setVerts(cp_line_cpu.verts);
+			cp_line_gpu.setCols(cp_line_cpu.cols);
+		}
 
-					cp_line_gpu.bind();
-					//glLineWidth(10.f); //May do nothing (like it does on my computer): https://community.khronos.org/t/3-0-wide-lines-deprecated/55426
-					glDrawArrays(GL_LINE_STRIP, 0, cp_line_cpu.verts.size());
-				}
+		if (!cp_point_cpu.verts.empty()) {
+			// Control Point ----------------
+			if (panelInput.renderControlPoints) { // Optional: render/unrender cp
+				cp_point_gpu.bind();
+				glPointSize(15.f);
+				glDrawArrays(GL_POINTS, 0, cp_point_cpu.verts.size());
+				RenderStats::countDrawCall();
+			}
+
+			// Control Point Line ------------
+			if (panelInput.renderControlPointLines) { // Optional: render/unrender cp lines
+				cp_line_gpu.bind();
+				//glLineWidth(10.f); //May do nothing (like it does on my computer): https://community.khronos.org/t/3-0-wide-lines-deprecated/55426
+				glDrawArrays(showTensorNet ? GL_LINES : GL_LINE_STRIP, 0, cp_line_cpu.verts.size());
+				RenderStats::countDrawCall();
 			}
-			break;
 		}
 		//------------------------------------------
 		glDisable(GL_FRAMEBUFFER_SRGB); // disable sRGB for things like imgui
 		panel.render();
+		renderStats.endFrame();
 		//------------------------------------------
 		window.swapBuffers();
 		//------------------------------------------
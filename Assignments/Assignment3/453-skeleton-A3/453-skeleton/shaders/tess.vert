@@ -0,0 +1,10 @@
+#version 410 core
+layout (location = 0) in vec3 pos;
+
+// Control points go through as they are; the evaluation shaders place
+// the tessellated vertices
+out vec3 controlPoint;
+
+void main() {
+	controlPoint = pos;
+}
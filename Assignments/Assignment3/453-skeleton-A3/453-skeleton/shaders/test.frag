@@ -2,7 +2,19 @@
 out vec4 color;
 
 in vec3 fragColor;
+in vec3 fragNormal;
+
+// Filled surfaces are lit from the camera instead of using their colour
+uniform bool shaded;
+uniform vec3 lightDirection;
 
 void main() {
-	color = vec4(fragColor, 1.0);
+	if (shaded) {
+		// Both sides lit, so the inside of a surface shows up too
+		float diffuse = abs(dot(normalize(fragNormal), lightDirection));
+		color = vec4(vec3(0.15 + 0.75 * diffuse), 1.0);
+	}
+	else {
+		color = vec4(fragColor, 1.0);
+	}
 }
@@ -1,12 +1,15 @@
 #version 330 core
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec3 color;
+layout (location = 2) in vec3 normal;
 
 out vec3 fragColor;
+out vec3 fragNormal;
 
 uniform mat4 transformationMatrix;
 
 void main() {
 	gl_Position = transformationMatrix * vec4(pos, 1.0);
 	fragColor = color;
+	fragNormal = normal;
 }
@@ -0,0 +1,241 @@
+#include "Benchmark.h"
+
+#include "BlockCompression.h"
+#include "Log.h"
+#include "SceneGraph.h"
+#include "Texture.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+
+namespace {
+
+	using Clock = std::chrono::steady_clock;
+
+	double millisecondsSince(Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// Peak signal to noise ratio over the first `channels` channels of each pixel
+	double psnr(const unsigned char* a, const unsigned char* b, size_t pixelCount, int components, int firstChannel, int channels) {
+		double squaredError = 0.0;
+		for (size_t i = 0; i < pixelCount; i++) {
+			for (int c = firstChannel; c < firstChannel + channels; c++) {
+				double d = double(a[i * components + c]) - double(b[i * components + c]);
+				squaredError += d * d;
+			}
+		}
+		double meanSquaredError = squaredError / (double(pixelCount) * channels);
+		if (meanSquaredError == 0.0) {
+			return std::numeric_limits<double>::infinity();
+		}
+		return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+	}
+
+	// Runs one format over pixels and logs how fast and how close it was
+	void measure(const std::string& name, const unsigned char* pixels, int width, int height, int components, BlockCompression::Format format) {
+		const size_t pixelCount = size_t(width) * height;
+		std::vector<unsigned char> blocks(BlockCompression::encodedSize(width, height, format));
+		std::vector<unsigned char> decoded(pixelCount * components);
+
+		// Best of a few runs, on one thread, so the number is per core
+		double encodeMs = std::numeric_limits<double>::max();
+		for (int run = 0; run < 3; run++) {
+			Clock::time_point start = Clock::now();
+			BlockCompression::encode(pixels, width, height, components, format, blocks.data());
+			encodeMs = std::min(encodeMs, millisecondsSince(start));
+		}
+
+		Clock::time_point start = Clock::now();
+		BlockCompression::decode(blocks.data(), width, height, components, format, decoded.data());
+		double decodeMs = millisecondsSince(start);
+
+		// Counted the way Texture counts its resident bytes, so the saving matches the stats overlay
+		const size_t uncompressedBytes = pixelCount * components;
+		std::string alpha = components == 4
+			? fmt::format(", alpha {:5.2f} dB", psnr(pixels, decoded.data(), pixelCount, components, 3, 1))
+			: "";
+
+		Log::info(
+			"{:<22} {}: encode {:7.2f} ms ({:6.1f} Mpixel/s per core), decode {:6.2f} ms, PSNR {:5.2f} dB{}, {:5.2f} MB -> {:5.2f} MB ({:.0f}x)",
+			name, BlockCompression::formatName(format), encodeMs, pixelCount / (encodeMs * 1000.0), decodeMs,
+			psnr(pixels, decoded.data(), pixelCount, components, 0, 3), alpha,
+			uncompressedBytes / 1e6, blocks.size() / 1e6, double(uncompressedBytes) / blocks.size()
+		);
+	}
+
+
+	glm::mat4 orbit(float angle, float distance) {
+		return glm::translate(glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(distance, 0.0f, 0.0f));
+	}
+
+	// The usual alternative to SceneGraph: nodes that own their children,
+	// updated recursively, recomputing every world matrix every time
+	struct TreeNode {
+		glm::mat4 local;
+		glm::mat4 world;
+		std::vector<std::unique_ptr<TreeNode>> children;
+	};
+
+	void updateRecursive(TreeNode& node, const glm::mat4& parentWorld) {
+		node.world = parentWorld * node.local;
+		for (std::unique_ptr<TreeNode>& child : node.children) {
+			updateRecursive(*child, node.world);
+		}
+	}
+
+	// Average milliseconds per call of step
+	template <typename Step>
+	double timePerCall(int calls, Step step) {
+		step(); // warm up
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < calls; i++) {
+			step();
+		}
+		return millisecondsSince(start) / calls;
+	}
+
+}
+
+
+bool Benchmark::run(const std::string& name) {
+	if (name == "texture-compression") {
+		textureCompression();
+	}
+	else if (name == "scene-graph") {
+		sceneGraph();
+	}
+	else {
+		Log::error("BENCHMARK unknown benchmark '{}'", name);
+		return false;
+	}
+	return true;
+}
+
+
+void Benchmark::textureCompression() {
+	Log::info("BENCHMARK block compression of the planet textures");
+
+	for (const char* path : { "textures/2k_earth_daymap.jpg", "textures/2k_moon.jpg", "textures/2k_sun.jpg", "textures/2k_stars.jpg" }) {
+		TextureImage image = TextureImage::decode(path);
+		if (!image.valid() || image.components < 3) {
+			Log::error("BENCHMARK couldn't read {} as RGB", path);
+			continue;
+		}
+		const std::string name = std::string(path).substr(std::string(path).find_last_of('/') + 1);
+		measure(name, image.pixels.get(), image.width, image.height, image.components, BlockCompression::formatFor(image.components));
+
+		// BC3 too, with an alpha channel that varies across the image like a cloud layer would
+		if (image.components == 3) {
+			const size_t pixelCount = size_t(image.width) * image.height;
+			std::vector<unsigned char> rgba(pixelCount * 4);
+			for (size_t i = 0; i < pixelCount; i++) {
+				const unsigned char* rgb = image.pixels.get() + i * 3;
+				std::copy(rgb, rgb + 3, rgba.data() + i * 4);
+				rgba[i * 4 + 3] = static_cast<unsigned char>((rgb[0] + 2 * rgb[1] + rgb[2]) / 4);
+			}
+			measure(name, rgba.data(), image.width, image.height, 4, BlockCompression::Format::BC3);
+		}
+	}
+}
+
+
+void Benchmark::sceneGraph() {
+	Log::info("BENCHMARK scene graph updates: a root, stars around it, planets around each star, moons around each planet");
+
+	struct Shape {
+		int stars;
+		int planetsPerStar;
+		int moonsPerPlanet;
+	};
+	for (Shape shape : { Shape{ 10, 10, 99 }, Shape{ 50, 20, 49 }, Shape{ 100, 40, 49 } }) {
+		SceneGraph scene;
+		TreeNode tree{ glm::mat4(1.0f), glm::mat4(1.0f), {} };
+		std::vector<SceneGraph::Node> planets;
+
+		const size_t nodeCount = 1 + size_t(shape.stars) * (1 + size_t(shape.planetsPerStar) * (1 + shape.moonsPerPlanet));
+		scene.reserve(nodeCount);
+		const SceneGraph::Node root = scene.addNode(SceneGraph::NONE);
+		for (int s = 0; s < shape.stars; s++) {
+			const glm::mat4 starLocal = orbit(0.1f * s, 100.0f + s);
+			const SceneGraph::Node star = scene.addNode(root, starLocal);
+			tree.children.push_back(std::make_unique<TreeNode>(TreeNode{ starLocal, glm::mat4(1.0f), {} }));
+			TreeNode& starTree = *tree.children.back();
+
+			for (int p = 0; p < shape.planetsPerStar; p++) {
+				const glm::mat4 planetLocal = orbit(0.3f * p, 5.0f + p);
+				const SceneGraph::Node planet = scene.addNode(star, planetLocal);
+				planets.push_back(planet);
+				starTree.children.push_back(std::make_unique<TreeNode>(TreeNode{ planetLocal, glm::mat4(1.0f), {} }));
+				TreeNode& planetTree = *starTree.children.back();
+
+				for (int m = 0; m < shape.moonsPerPlanet; m++) {
+					const glm::mat4 moonLocal = orbit(0.7f * m, 0.5f + 0.01f * m);
+					scene.addNode(planet, moonLocal);
+					planetTree.children.push_back(std::make_unique<TreeNode>(TreeNode{ moonLocal, glm::mat4(1.0f), {} }));
+				}
+			}
+		}
+		scene.update();
+
+		// What each case recomputed, and a sum of results so none of it can be optimized away
+		size_t recomputed = 0;
+		float checksum = 0.0f;
+		float angle = 0.0f;
+		auto report = [&](const char* what, double ms) {
+			Log::info("{:>7} nodes, {:<28} {:8.3f} ms per update, {:7} world matrices ({:5.1f} ns each)",
+				nodeCount, what, ms, recomputed, recomputed > 0 ? ms * 1e6 / recomputed : 0.0);
+		};
+		const int calls = nodeCount > 100000 ? 20 : 100;
+
+		double ms = timePerCall(calls, [&] {
+			recomputed = scene.update();
+			checksum += scene.getWorld(SceneGraph::Node(nodeCount - 1))[3][0];
+		});
+		report("nothing moved:", ms);
+
+		ms = timePerCall(calls, [&] {
+			angle += 0.01f;
+			scene.setLocal(planets[planets.size() / 2], orbit(angle, 5.0f));
+			recomputed = scene.update();
+			checksum += scene.getWorld(SceneGraph::Node(nodeCount - 1))[3][0];
+		});
+		report("one planet orbiting:", ms);
+
+		ms = timePerCall(calls, [&] {
+			angle += 0.01f;
+			for (SceneGraph::Node planet : planets) {
+				scene.setLocal(planet, orbit(angle, 5.0f));
+			}
+			recomputed = scene.update();
+			checksum += scene.getWorld(SceneGraph::Node(nodeCount - 1))[3][0];
+		});
+		report("every planet orbiting:", ms);
+
+		ms = timePerCall(calls, [&] {
+			angle += 0.01f;
+			scene.setLocal(root, glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+			recomputed = scene.update();
+			checksum += scene.getWorld(SceneGraph::Node(nodeCount - 1))[3][0];
+		});
+		report("root rotating (all dirty):", ms);
+
+		ms = timePerCall(calls, [&] {
+			angle += 0.01f;
+			tree.local = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			updateRecursive(tree, glm::mat4(1.0f));
+			recomputed = nodeCount;
+			checksum += tree.children.back()->children.back()->children.back()->world[3][0];
+		});
+		report("recursive pointer tree:", ms);
+
+		Log::debug("BENCHMARK checksum {}", checksum);
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Headless benchmarks for the texture pipeline and the scene graph.
+//
+// These never open a window, so they can be run on machines without a GPU:
+//
+// Example: 453-skeleton-program --bench=texture-compression
+//          453-skeleton-program --bench=scene-graph
+//------------------------------------------------------------------------------
+
+#include <string>
+
+
+namespace Benchmark {
+
+	// Runs the benchmark with the given name. Returns false if there is no such benchmark
+	bool run(const std::string& name);
+
+	// BC1/BC3 encoder throughput and quality (PSNR) on the planet textures
+	void textureCompression();
+
+	// SceneGraph::update() on tens to hundreds of thousands of nodes, with
+	// more or less of the scene moving, against a recursive pointer tree
+	void sceneGraph();
+
+}
@@ -0,0 +1,336 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+
+namespace {
+
+	using BlockPixels = unsigned char[16][4];
+
+	int blocksAcross(int size) {
+		return (size + 3) / 4;
+	}
+
+	size_t bytesPerBlock(BlockCompression::Format format) {
+		return format == BlockCompression::Format::BC3 ? 16 : 8;
+	}
+
+
+	// A 4x4 block as RGBA. Blocks hanging over the right or bottom edge
+	// repeat the last column or row, and RGB images get an opaque alpha.
+	void gatherBlock(const unsigned char* pixels, int width, int height, int components, int blockX, int blockY, BlockPixels block) {
+		for (int y = 0; y < 4; y++) {
+			const int sourceY = std::min(blockY * 4 + y, height - 1);
+			for (int x = 0; x < 4; x++) {
+				const int sourceX = std::min(blockX * 4 + x, width - 1);
+				const unsigned char* pixel = pixels + (static_cast<size_t>(sourceY) * width + sourceX) * components;
+				unsigned char* target = block[y * 4 + x];
+				target[0] = pixel[0];
+				target[1] = pixel[1];
+				target[2] = pixel[2];
+				target[3] = components == 4 ? pixel[3] : 255;
+			}
+		}
+	}
+
+
+	uint16_t packColor(float r, float g, float b) {
+		auto quantize = [](float value, int maximum) {
+			return static_cast<int>(std::lround(std::clamp(value, 0.0f, 255.0f) * maximum / 255.0f));
+		};
+		return static_cast<uint16_t>((quantize(r, 31) << 11) | (quantize(g, 63) << 5) | quantize(b, 31));
+	}
+
+	// Back to 8 bits per channel the way the hardware does it, by repeating
+	// the top bits into the bottom ones
+	void unpackColor(uint16_t color, int rgb[3]) {
+		const int r = (color >> 11) & 31;
+		const int g = (color >> 5) & 63;
+		const int b = color & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	// The four colours of a colour block. BC1 switches to three colours plus
+	// black when color0 <= color1, BC3 always uses four.
+	void colorPalette(uint16_t color0, uint16_t color1, bool alwaysFourColors, int palette[4][3]) {
+		unpackColor(color0, palette[0]);
+		unpackColor(color1, palette[1]);
+		for (int c = 0; c < 3; c++) {
+			if (alwaysFourColors || color0 > color1) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else {
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+	}
+
+	void alphaPalette(int alpha0, int alpha1, int palette[8]) {
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+		if (alpha0 > alpha1) {
+			for (int i = 1; i < 7; i++) {
+				palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+			}
+		}
+		else {
+			for (int i = 1; i < 5; i++) {
+				palette[i + 1] = ((5 - i) * alpha0 + i * alpha1) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+
+	// 8 bytes: two RGB565 endpoints, then a 2 bit palette index per pixel
+	void encodeColorBlock(const BlockPixels block, unsigned char* out) {
+		// Mean and covariance of the block's colours
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 3; c++) {
+				mean[c] += block[i][c];
+			}
+		}
+		for (int c = 0; c < 3; c++) {
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[3][3] = {};
+		for (int i = 0; i < 16; i++) {
+			float d[3] = { block[i][0] - mean[0], block[i][1] - mean[1], block[i][2] - mean[2] };
+			for (int a = 0; a < 3; a++) {
+				for (int b = 0; b < 3; b++) {
+					covariance[a][b] += d[a] * d[b];
+				}
+			}
+		}
+
+		// The principal axis by power iteration. A handful of steps is plenty
+		// to pick the endpoints, which get rounded to 565 anyway.
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++) {
+			float next[3];
+			for (int a = 0; a < 3; a++) {
+				next[a] = covariance[a][0] * axis[0] + covariance[a][1] * axis[1] + covariance[a][2] * axis[2];
+			}
+			float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+			if (length < 1e-6f) {
+				break;
+			}
+			for (int a = 0; a < 3; a++) {
+				axis[a] = next[a] / length;
+			}
+		}
+
+		// Endpoints at the extremes of the colours along that axis, pulled in
+		// a little since the extremes are rarely worth an exact match
+		float lowest = 0.0f;
+		float highest = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			float t = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2];
+			lowest = std::min(lowest, t);
+			highest = std::max(highest, t);
+		}
+		const float inset = (highest - lowest) / 16.0f;
+		lowest += inset;
+		highest -= inset;
+
+		uint16_t color0 = packColor(mean[0] + axis[0] * highest, mean[1] + axis[1] * highest, mean[2] + axis[2] * highest);
+		uint16_t color1 = packColor(mean[0] + axis[0] * lowest, mean[1] + axis[1] * lowest, mean[2] + axis[2] * lowest);
+		if (color0 < color1) {
+			std::swap(color0, color1);
+		}
+
+		// Equal endpoints means a flat block, where index 0 is all it needs.
+		// Otherwise color0 > color1 keeps BC1 in four colour mode.
+		uint32_t indices = 0;
+		if (color0 != color1) {
+			int palette[4][3];
+			colorPalette(color0, color1, true, palette);
+			for (int i = 0; i < 16; i++) {
+				int bestIndex = 0;
+				int bestError = INT32_MAX;
+				for (int p = 0; p < 4; p++) {
+					int dr = block[i][0] - palette[p][0];
+					int dg = block[i][1] - palette[p][1];
+					int db = block[i][2] - palette[p][2];
+					int error = dr * dr + dg * dg + db * db;
+					if (error < bestError) {
+						bestError = error;
+						bestIndex = p;
+					}
+				}
+				indices |= static_cast<uint32_t>(bestIndex) << (2 * i);
+			}
+		}
+
+		out[0] = static_cast<unsigned char>(color0 & 0xFF);
+		out[1] = static_cast<unsigned char>(color0 >> 8);
+		out[2] = static_cast<unsigned char>(color1 & 0xFF);
+		out[3] = static_cast<unsigned char>(color1 >> 8);
+		for (int i = 0; i < 4; i++) {
+			out[4 + i] = static_cast<unsigned char>(indices >> (8 * i));
+		}
+	}
+
+
+	// 8 bytes: two alpha endpoints, then a 3 bit palette index per pixel
+	void encodeAlphaBlock(const BlockPixels block, unsigned char* out) {
+		int lowest = 255;
+		int highest = 0;
+		for (int i = 0; i < 16; i++) {
+			lowest = std::min<int>(lowest, block[i][3]);
+			highest = std::max<int>(highest, block[i][3]);
+		}
+
+		// alpha0 > alpha1 picks the eight value palette
+		uint64_t indices = 0;
+		if (highest != lowest) {
+			int palette[8];
+			alphaPalette(highest, lowest, palette);
+			for (int i = 0; i < 16; i++) {
+				int bestIndex = 0;
+				int bestError = INT32_MAX;
+				for (int p = 0; p < 8; p++) {
+					int error = std::abs(block[i][3] - palette[p]);
+					if (error < bestError) {
+						bestError = error;
+						bestIndex = p;
+					}
+				}
+				indices |= static_cast<uint64_t>(bestIndex) << (3 * i);
+			}
+		}
+
+		out[0] = static_cast<unsigned char>(highest);
+		out[1] = static_cast<unsigned char>(lowest);
+		for (int i = 0; i < 6; i++) {
+			out[2 + i] = static_cast<unsigned char>(indices >> (8 * i));
+		}
+	}
+
+
+	void decodeColorBlock(const unsigned char* in, bool alwaysFourColors, BlockPixels block) {
+		const uint16_t color0 = static_cast<uint16_t>(in[0] | (in[1] << 8));
+		const uint16_t color1 = static_cast<uint16_t>(in[2] | (in[3] << 8));
+		const uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16) | (static_cast<uint32_t>(in[7]) << 24);
+
+		int palette[4][3];
+		colorPalette(color0, color1, alwaysFourColors, palette);
+		for (int i = 0; i < 16; i++) {
+			const int index = (indices >> (2 * i)) & 3;
+			for (int c = 0; c < 3; c++) {
+				block[i][c] = static_cast<unsigned char>(palette[index][c]);
+			}
+			// Only BC1's three colour mode has transparency, which we never write
+			block[i][3] = 255;
+		}
+	}
+
+	void decodeAlphaBlock(const unsigned char* in, BlockPixels block) {
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; i++) {
+			indices |= static_cast<uint64_t>(in[2 + i]) << (8 * i);
+		}
+
+		int palette[8];
+		alphaPalette(in[0], in[1], palette);
+		for (int i = 0; i < 16; i++) {
+			block[i][3] = static_cast<unsigned char>(palette[(indices >> (3 * i)) & 7]);
+		}
+	}
+
+}
+
+
+const char* BlockCompression::formatName(Format format) {
+	switch (format) {
+	case Format::BC1:
+		return "BC1";
+	case Format::BC3:
+		return "BC3";
+	default:
+		return "uncompressed";
+	}
+}
+
+
+BlockCompression::Format BlockCompression::formatFor(int components) {
+	switch (components) {
+	case 3:
+		return Format::BC1;
+	case 4:
+		return Format::BC3;
+	default:
+		return Format::Uncompressed;
+	}
+}
+
+
+size_t BlockCompression::encodedSize(int width, int height, Format format) {
+	return static_cast<size_t>(blocksAcross(width)) * blocksAcross(height) * bytesPerBlock(format);
+}
+
+
+void BlockCompression::encode(const unsigned char* pixels, int width, int height, int components, Format format,
+	unsigned char* out, int firstBlockRow, int lastBlockRow)
+{
+	const int blockColumns = blocksAcross(width);
+	const size_t blockSize = bytesPerBlock(format);
+
+	BlockPixels block;
+	for (int blockY = firstBlockRow; blockY < lastBlockRow; blockY++) {
+		unsigned char* target = out + static_cast<size_t>(blockY) * blockColumns * blockSize;
+		for (int blockX = 0; blockX < blockColumns; blockX++) {
+			gatherBlock(pixels, width, height, components, blockX, blockY, block);
+			if (format == Format::BC3) {
+				encodeAlphaBlock(block, target);
+				target += 8;
+			}
+			encodeColorBlock(block, target);
+			target += 8;
+		}
+	}
+}
+
+
+void BlockCompression::encode(const unsigned char* pixels, int width, int height, int components, Format format, unsigned char* out) {
+	encode(pixels, width, height, components, format, out, 0, blocksAcross(height));
+}
+
+
+void BlockCompression::decode(const unsigned char* blocks, int width, int height, int components, Format format, unsigned char* out) {
+	const int blockColumns = blocksAcross(width);
+	const int blockRows = blocksAcross(height);
+
+	BlockPixels block;
+	for (int blockY = 0; blockY < blockRows; blockY++) {
+		for (int blockX = 0; blockX < blockColumns; blockX++) {
+			if (format == Format::BC3) {
+				decodeColorBlock(blocks + 8, true, block);
+				decodeAlphaBlock(blocks, block);
+				blocks += 16;
+			}
+			else {
+				decodeColorBlock(blocks, false, block);
+				blocks += 8;
+			}
+
+			// Drop the pixels that hang over the edge of the image
+			for (int y = 0; y < 4 && blockY * 4 + y < height; y++) {
+				for (int x = 0; x < 4 && blockX * 4 + x < width; x++) {
+					unsigned char* target = out + (static_cast<size_t>(blockY * 4 + y) * width + blockX * 4 + x) * components;
+					std::memcpy(target, block[y * 4 + x], components);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A CPU encoder and decoder for the BC1 and BC3 block compressed formats
+// (also known as DXT1 and DXT5, or S3TC).
+//
+// Both formats cut the image into 4x4 blocks and store each block as two
+// endpoint colours plus a 2 bit index per pixel picking one of four colours
+// on the line between them. BC1 is 8 bytes a block, half a byte per pixel.
+// BC3 adds another 8 bytes for alpha, stored the same way with 3 bit indices.
+//
+// The encoder picks endpoints along the principal axis of each block's
+// colours, which is fast and close to what far slower exhaustive encoders
+// manage on photographic images like the planet textures.
+//
+// Example: std::vector<unsigned char> blocks(BlockCompression::encodedSize(w, h, Format::BC1));
+//          BlockCompression::encode(pixels, w, h, 3, Format::BC1, blocks.data());
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+
+
+namespace BlockCompression {
+
+	enum class Format {
+		Uncompressed,
+		BC1,		// RGB, 8 bytes per block
+		BC3,		// RGBA, 16 bytes per block
+	};
+
+	const char* formatName(Format format);
+
+	// The block format for an image with this many components: BC1 for RGB,
+	// BC3 for RGBA, and none for one or two channel images
+	Format formatFor(int components);
+
+	// Bytes for a width x height image, rounded up to whole blocks
+	size_t encodedSize(int width, int height, Format format);
+
+	// Encodes block rows [firstBlockRow, lastBlockRow) of an image with
+	// 3 or 4 components. out points at the start of the whole encoded image.
+	// Separate ranges can be encoded on separate threads.
+	void encode(const unsigned char* pixels, int width, int height, int components, Format format,
+		unsigned char* out, int firstBlockRow, int lastBlockRow);
+
+	// The whole image
+	void encode(const unsigned char* pixels, int width, int height, int components, Format format, unsigned char* out);
+
+	// Back to width x height pixels with the given number of components
+	void decode(const unsigned char* blocks, int width, int height, int components, Format format, unsigned char* out);
+
+}
@@ -0,0 +1,104 @@
+#include "GLStateCache.h"
+
+#include "RenderStats.h"
+
+
+GLStateCache::GLStateCache() {
+	invalidate();
+}
+
+
+void GLStateCache::useProgram(GLuint newProgram) {
+	if (program == newProgram) {
+		RenderStats::countStateChangeSkipped();
+		return;
+	}
+	glUseProgram(newProgram);
+	program = newProgram;
+	RenderStats::countStateChange();
+}
+
+
+void GLStateCache::bindVertexArray(GLuint newVertexArray) {
+	if (vertexArray == newVertexArray) {
+		RenderStats::countStateChangeSkipped();
+		return;
+	}
+	glBindVertexArray(newVertexArray);
+	vertexArray = newVertexArray;
+	RenderStats::countStateChange();
+}
+
+
+void GLStateCache::bindTexture(int unit, GLuint texture) {
+	if (textures[unit] == texture) {
+		RenderStats::countStateChangeSkipped();
+		return;
+	}
+	if (activeUnit != GLuint(unit)) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		activeUnit = unit;
+		RenderStats::countStateChange();
+	}
+	glBindTexture(GL_TEXTURE_2D, texture);
+	textures[unit] = texture;
+	RenderStats::countStateChange();
+}
+
+
+void GLStateCache::setEnabled(GLenum capability, bool enabled) {
+	for (std::pair<GLenum, bool>& known : capabilities) {
+		if (known.first == capability) {
+			if (known.second == enabled) {
+				RenderStats::countStateChangeSkipped();
+				return;
+			}
+			known.second = enabled;
+			enabled ? glEnable(capability) : glDisable(capability);
+			RenderStats::countStateChange();
+			return;
+		}
+	}
+	capabilities.emplace_back(capability, enabled);
+	enabled ? glEnable(capability) : glDisable(capability);
+	RenderStats::countStateChange();
+}
+
+
+void GLStateCache::polygonMode(GLenum newMode) {
+	if (mode == newMode) {
+		RenderStats::countStateChangeSkipped();
+		return;
+	}
+	glPolygonMode(GL_FRONT_AND_BACK, newMode);
+	mode = newMode;
+	RenderStats::countStateChange();
+}
+
+
+void GLStateCache::clearColor(const glm::vec4& newColor) {
+	if (clearColorKnown && color == newColor) {
+		RenderStats::countStateChangeSkipped();
+		return;
+	}
+	glClearColor(newColor.r, newColor.g, newColor.b, newColor.a);
+	clearColorKnown = true;
+	color = newColor;
+	RenderStats::countStateChange();
+}
+
+
+void GLStateCache::invalidateBindings() {
+	program = UNKNOWN;
+	vertexArray = UNKNOWN;
+	activeUnit = UNKNOWN;
+	textures.fill(UNKNOWN);
+}
+
+
+void GLStateCache::invalidate() {
+	invalidateBindings();
+	capabilities.clear();
+	mode = UNKNOWN;
+	clearColorKnown = false;
+}
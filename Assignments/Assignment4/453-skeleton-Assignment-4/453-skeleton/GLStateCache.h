@@ -0,0 +1,66 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A shadow copy of the OpenGL state the render loop touches, so setting
+// something to what it already is costs nothing.
+//
+// Each setter compares against what it last set and only calls OpenGL when
+// the value changes. Both outcomes are counted in RenderStats, as state
+// changes made and state changes skipped.
+//
+// The cache only knows about calls that go through it. Code that binds
+// things behind its back (texture uploads, the virtual texture feedback
+// pass) has to be followed by invalidateBindings(), or invalidate() if it
+// also changed the enables or the polygon mode.
+//
+// Example: GLStateCache state;
+//          state.setEnabled(GL_DEPTH_TEST, true);
+//          state.useProgram(shader);
+//          state.bindTexture(0, earthTex.getId());
+//------------------------------------------------------------------------------
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <utility>
+#include <vector>
+
+
+class GLStateCache {
+
+public:
+	static constexpr int TEXTURE_UNITS = 8;
+
+	GLStateCache();
+
+	void useProgram(GLuint program);
+	void bindVertexArray(GLuint vertexArray);
+	void bindTexture(int unit, GLuint texture);		// GL_TEXTURE_2D
+
+	// glEnable/glDisable
+	void setEnabled(GLenum capability, bool enabled);
+	void polygonMode(GLenum mode);				// GL_FRONT_AND_BACK
+	void clearColor(const glm::vec4& color);
+
+	// Forget the bound program, vertex array and textures
+	void invalidateBindings();
+	// Forget everything
+	void invalidate();
+
+private:
+	// UNKNOWN means "could be anything": the next set always goes through
+	static constexpr GLuint UNKNOWN = ~0u;
+
+	GLuint program;
+	GLuint vertexArray;
+	GLuint activeUnit;
+	std::array<GLuint, TEXTURE_UNITS> textures;
+
+	// The capabilities set so far, and to what. Only a handful are ever
+	// used, so a short list beats a map.
+	std::vector<std::pair<GLenum, bool>> capabilities;
+	GLenum mode;
+	bool clearColorKnown;
+	glm::vec4 color;
+};
@@ -1,5 +1,7 @@
 #include "Geometry.h"
 
+#include "RenderStats.h"
+
 #include <utility>
 
 
@@ -27,6 +29,14 @@ void GPU_Geometry::setNormals(const std::vector<glm::vec3>& norms) {
 
 
 void GPU_Geometry::setTexCoords(const std::vector<glm::vec2>& texCoords) {
-	texCoordBuffer.uploadData(sizeof(glm::vec3) * texCoords.size(), texCoords.data(), GL_STATIC_DRAW);
+	texCoordBuffer.uploadData(sizeof(glm::vec2) * texCoords.size(), texCoords.data(), GL_STATIC_DRAW);
+}
+
+
+void GPU_Geometry::setIndices(const std::vector<GLuint>& indices) {
+	vao.bind();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
+	RenderStats::countUpload(sizeof(GLuint) * indices.size());
 }
 
@@ -26,7 +26,8 @@ struct CPU_Geometry {
 };
 
 
-// VAO and two VBOs for storing vertices and texture coordinates, respectively
+// VAO and VBOs for storing vertices, colours, normals and texture coordinates,
+// plus an optional index buffer
 class GPU_Geometry {
 
 public:
@@ -34,11 +35,16 @@ public:
 
 	// Public interface
 	void bind() { vao.bind(); }
+	GLuint getVertexArray() const { return vao.value(); }
 
 	void setVerts(const std::vector<glm::vec3>& verts);
 	void setCols(const std::vector<glm::vec3>& cols);
 	void setNormals(const std::vector<glm::vec3>& norms);
 	void setTexCoords(const std::vector<glm::vec2>& texCoords);
+
+	// For glDrawElements. The VAO keeps track of the index buffer, so bind()
+	// is all drawing needs.
+	void setIndices(const std::vector<GLuint>& indices);
 		 
 private:
 	// note: due to how OpenGL works, vao needs to be
@@ -49,4 +55,5 @@ private:
 	VertexBuffer colorsBuffer;
 	VertexBuffer normalsBuffer;
 	VertexBuffer texCoordBuffer;
+	VertexBufferHandle indexBuffer;
 };
@@ -0,0 +1,73 @@
+#include "RenderQueue.h"
+
+#include "RenderStats.h"
+#include "VirtualTexture.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+
+void RenderQueue::clear() {
+	draws.clear();
+	order.clear();
+}
+
+
+void RenderQueue::submit(const Draw& draw) {
+	order.emplace_back(sortKey(draw), draws.size());
+	draws.push_back(draw);
+}
+
+
+void RenderQueue::execute(GLStateCache& state) {
+	std::sort(order.begin(), order.end());
+
+	for (const std::pair<uint64_t, size_t>& entry : order) {
+		const Draw& draw = draws[entry.second];
+
+		state.useProgram(draw.program);
+		state.bindTexture(0, draw.textures[0]);
+		if (draw.textures[1] != 0) {
+			state.bindTexture(1, draw.textures[1]);
+		}
+		if (draw.virtualTexture) {
+			draw.virtualTexture->setUniforms(draw.program);
+		}
+		state.bindVertexArray(draw.mesh.vertexArray);
+
+		glUniformMatrix4fv(modelLocation(draw.program), 1, GL_FALSE, glm::value_ptr(draw.model));
+		glDrawElements(GL_TRIANGLES, draw.mesh.indexCount, GL_UNSIGNED_INT, reinterpret_cast<const void*>(draw.mesh.firstIndex * sizeof(GLuint)));
+		RenderStats::countDrawCall();
+	}
+}
+
+
+uint64_t RenderQueue::sortKey(const Draw& draw) {
+	// Program, textures and vertex array by their GL names, which OpenGL
+	// hands out counting up from 1. Names that outgrow their bits only
+	// group less well; the order of draws never affects what they draw here.
+	const uint64_t program = draw.program & 0xFF;
+	const uint64_t texture = (draw.textures[0] & 0xFFF) | ((draw.textures[1] & 0xF) << 12);
+	const uint64_t vertexArray = draw.mesh.vertexArray & 0xFF;
+
+	// Non-negative floats sort the same as their bits. The top 28 are plenty.
+	const float depth = std::max(draw.depth, 0.0f);
+	uint32_t depthBits;
+	std::memcpy(&depthBits, &depth, sizeof(depthBits));
+
+	return (program << 56) | (texture << 40) | (vertexArray << 28) | (depthBits >> 4);
+}
+
+
+GLint RenderQueue::modelLocation(GLuint program) {
+	for (const std::pair<GLuint, GLint>& known : modelLocations) {
+		if (known.first == program) {
+			return known.second;
+		}
+	}
+	GLint location = glGetUniformLocation(program, "M");
+	modelLocations.emplace_back(program, location);
+	return location;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A frame's draws, collected first and drawn in an order that keeps state
+// changes down.
+//
+// submit() packs each draw into a 64 bit sort key: program, then textures,
+// then vertex array, then distance from the camera. Sorting by key groups
+// the draws that share a program and textures, and draws them front to back
+// within a group, so the depth test can throw away hidden fragments early.
+// execute() then goes through a GLStateCache, which drops the binds that
+// don't change anything.
+//
+// The programs must already have their view and projection uniforms set.
+//
+// Example: queue.clear();
+//          queue.submit(draw);
+//          queue.execute(state);
+//------------------------------------------------------------------------------
+
+#include "GLStateCache.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class VirtualTexture;
+
+
+class RenderQueue {
+
+public:
+	// A range of an indexed mesh, drawn as GL_TRIANGLES
+	struct Mesh {
+		GLuint vertexArray;
+		size_t firstIndex;
+		GLsizei indexCount;
+	};
+
+	struct Draw {
+		GLuint program;
+		GLuint textures[2];					// for units 0 and 1, 0 for none
+		const VirtualTexture* virtualTexture;	// sets its uniforms first, if not null
+		Mesh mesh;
+		glm::mat4 model;					// as the "M" uniform
+		float depth;						// distance from the camera
+	};
+
+	void clear();
+	void submit(const Draw& draw);
+
+	// Sorts the draws and issues them
+	void execute(GLStateCache& state);
+
+	size_t size() const { return draws.size(); }
+
+private:
+	std::vector<Draw> draws;
+	std::vector<std::pair<uint64_t, size_t>> order;		// sort key, index into draws
+
+	// Where each program keeps its "M" uniform
+	std::vector<std::pair<GLuint, GLint>> modelLocations;
+
+	static uint64_t sortKey(const Draw& draw);
+	GLint modelLocation(GLuint program);
+};
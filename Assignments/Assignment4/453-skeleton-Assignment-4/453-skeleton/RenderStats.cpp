@@ -0,0 +1,149 @@
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <atomic>
+
+
+namespace {
+	std::atomic<uint64_t> drawCalls{ 0 };
+	std::atomic<uint64_t> uploadBytes{ 0 };
+	std::atomic<uint64_t> shaderRecompiles{ 0 };
+	std::atomic<uint64_t> textureBytes{ 0 };
+	std::atomic<uint64_t> stateChanges{ 0 };
+	std::atomic<uint64_t> stateChangesSkipped{ 0 };
+}
+
+
+void RenderStats::countDrawCall() {
+	drawCalls.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void RenderStats::countUpload(size_t bytes) {
+	uploadBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+
+void RenderStats::countShaderRecompile() {
+	shaderRecompiles.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void RenderStats::countStateChange() {
+	stateChanges.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void RenderStats::countStateChangeSkipped() {
+	stateChangesSkipped.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+RenderStats::TextureBytes::TextureBytes()
+	: bytes(0)
+{}
+
+
+RenderStats::TextureBytes::TextureBytes(size_t bytes)
+	: bytes(0)
+{
+	set(bytes);
+}
+
+
+RenderStats::TextureBytes::~TextureBytes() {
+	set(0);
+}
+
+
+RenderStats::TextureBytes::TextureBytes(TextureBytes&& other) noexcept
+	: bytes(other.bytes)
+{
+	other.bytes = 0;
+}
+
+
+RenderStats::TextureBytes& RenderStats::TextureBytes::operator=(TextureBytes&& other) noexcept {
+	if (this != &other) {
+		set(0);
+		bytes = other.bytes;
+		other.bytes = 0;
+	}
+	return *this;
+}
+
+
+void RenderStats::TextureBytes::set(size_t newBytes) {
+	// Unsigned wraparound makes shrinking work with the same add
+	textureBytes.fetch_add(static_cast<uint64_t>(newBytes) - static_cast<uint64_t>(bytes), std::memory_order_relaxed);
+	bytes = newBytes;
+}
+
+
+RenderStats::Totals RenderStats::totals() {
+	Totals t;
+	t.drawCalls = drawCalls.load(std::memory_order_relaxed);
+	t.uploadBytes = uploadBytes.load(std::memory_order_relaxed);
+	t.shaderRecompiles = shaderRecompiles.load(std::memory_order_relaxed);
+	t.textureBytes = textureBytes.load(std::memory_order_relaxed);
+	t.stateChanges = stateChanges.load(std::memory_order_relaxed);
+	t.stateChangesSkipped = stateChangesSkipped.load(std::memory_order_relaxed);
+	return t;
+}
+
+
+RenderStats::Recorder::Recorder(size_t historyLength)
+	: frameStart(Clock::now())
+	, previousFrameEnd(frameStart)
+	, previousTotals(totals())
+	, cpuHistory(historyLength, 0.0f)
+	, historyOffset(0)
+	, historyCount(0)
+{}
+
+
+void RenderStats::Recorder::beginFrame() {
+	frameStart = Clock::now();
+}
+
+
+void RenderStats::Recorder::endFrame() {
+	const Clock::time_point now = Clock::now();
+	const Totals current = totals();
+
+	last.index++;
+	last.cpuMs = std::chrono::duration<float, std::milli>(now - frameStart).count();
+	last.frameMs = std::chrono::duration<float, std::milli>(now - previousFrameEnd).count();
+	last.drawCalls = current.drawCalls - previousTotals.drawCalls;
+	last.uploadBytes = current.uploadBytes - previousTotals.uploadBytes;
+	last.textureBytes = current.textureBytes;
+	last.shaderRecompiles = current.shaderRecompiles;
+	last.stateChanges = current.stateChanges - previousTotals.stateChanges;
+	last.stateChangesSkipped = current.stateChangesSkipped - previousTotals.stateChangesSkipped;
+
+	previousFrameEnd = now;
+	previousTotals = current;
+
+	if (!cpuHistory.empty()) {
+		cpuHistory[historyOffset] = last.cpuMs;
+		historyOffset = (historyOffset + 1) % cpuHistory.size();
+		historyCount = std::min(historyCount + 1, cpuHistory.size());
+	}
+
+	if (csv.is_open()) {
+		csv << last.index << ',' << last.cpuMs << ',' << last.frameMs << ','
+			<< last.drawCalls << ',' << last.uploadBytes << ','
+			<< last.textureBytes << ',' << last.shaderRecompiles << ','
+			<< last.stateChanges << ',' << last.stateChangesSkipped << '\n';
+	}
+}
+
+
+bool RenderStats::Recorder::openCsv(const std::string& path) {
+	csv.open(path);
+	if (!csv) {
+		return false;
+	}
+	csv << "frame,cpu_ms,frame_ms,draw_calls,upload_bytes,texture_bytes,shader_recompiles,state_changes,state_changes_skipped\n";
+	return true;
+}
@@ -0,0 +1,98 @@
+#include "SceneGraph.h"
+
+#include <algorithm>
+
+
+SceneGraph::Node SceneGraph::addNode(Node parent, const glm::mat4& local) {
+	const Node node = static_cast<Node>(size());
+
+	// Still depth first if the parent's subtree ends right here, in which case
+	// the new node extends the subtrees of the parent and all its ancestors
+	if (parent != NONE && subtreeEnds[parent] != node) {
+		depthFirst = false;
+	}
+	if (depthFirst) {
+		for (Node ancestor = parent; ancestor != NONE; ancestor = parents[ancestor]) {
+			subtreeEnds[ancestor] = node + 1;
+		}
+	}
+
+	parents.push_back(parent);
+	locals.push_back(local);
+	worlds.push_back(glm::mat4(1.0f));
+	subtreeEnds.push_back(node + 1);
+	dirty.push_back(1);
+	dirtyNodes.push_back(node);
+	return node;
+}
+
+
+void SceneGraph::setLocal(Node node, const glm::mat4& local) {
+	locals[node] = local;
+	if (!dirty[node]) {
+		dirty[node] = 1;
+		dirtyNodes.push_back(node);
+	}
+}
+
+
+size_t SceneGraph::update() {
+	if (dirtyNodes.empty()) {
+		return 0;
+	}
+
+	std::sort(dirtyNodes.begin(), dirtyNodes.end());
+	size_t recomputed = 0;
+
+	if (depthFirst) {
+		// Each dirty subtree is one contiguous run of nodes. A dirty node
+		// inside a run that was already done needs nothing more.
+		Node doneUntil = 0;
+		for (Node node : dirtyNodes) {
+			if (node < doneUntil) {
+				continue;
+			}
+			worlds[node] = parents[node] == NONE ? locals[node] : worlds[parents[node]] * locals[node];
+			for (Node i = node + 1; i < subtreeEnds[node]; i++) {
+				worlds[i] = worlds[parents[i]] * locals[i];
+			}
+			recomputed += subtreeEnds[node] - node;
+			doneUntil = subtreeEnds[node];
+		}
+		for (Node node : dirtyNodes) {
+			dirty[node] = 0;
+		}
+	}
+	else {
+		// Subtrees are scattered, so walk everything after the first dirty
+		// node, passing dirty flags down as we go
+		const size_t first = dirtyNodes.front();
+		for (size_t i = first; i < size(); i++) {
+			const Node parent = parents[i];
+			if (parent == NONE) {
+				if (dirty[i]) {
+					worlds[i] = locals[i];
+					recomputed++;
+				}
+			}
+			else if (dirty[i] || dirty[parent]) {
+				dirty[i] = 1;
+				worlds[i] = worlds[parent] * locals[i];
+				recomputed++;
+			}
+		}
+		std::fill(dirty.begin() + first, dirty.end(), 0);
+	}
+
+	dirtyNodes.clear();
+	return recomputed;
+}
+
+
+void SceneGraph::reserve(size_t nodeCount) {
+	parents.reserve(nodeCount);
+	locals.reserve(nodeCount);
+	worlds.reserve(nodeCount);
+	subtreeEnds.reserve(nodeCount);
+	dirty.reserve(nodeCount);
+}
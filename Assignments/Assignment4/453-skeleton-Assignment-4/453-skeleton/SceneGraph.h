@@ -0,0 +1,72 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A scene graph of transforms: each node has a local transform relative to
+// its parent, and a world transform that is the product of every local
+// transform up to the root.
+//
+// Nodes are stored flat, in the order they were added, and a parent always
+// has to exist before its children. That makes the arrays a valid traversal
+// order on their own: walking them front to back, every parent's world
+// matrix is ready before its children need it. No recursion, no pointers,
+// and the world matrices end up side by side for rendering.
+//
+// setLocal() only marks the node dirty. update() recomputes the world
+// matrices of dirty nodes and everything below them, and leaves the rest
+// alone. Add nodes depth first (each node's children, and their children,
+// before its next sibling) and every subtree is one contiguous run of the
+// arrays, so a dirty subtree is all update() touches. Otherwise it has to
+// walk everything after the first dirty node.
+//
+// Example: SceneGraph scene;
+//          SceneGraph::Node orbit = scene.addNode(SceneGraph::NONE);
+//          SceneGraph::Node earth = scene.addNode(orbit, glm::scale(glm::mat4(1.0f), glm::vec3(2.0f)));
+//          scene.setLocal(orbit, glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+//          scene.update();
+//          ... draw with scene.getWorld(earth) ...
+//------------------------------------------------------------------------------
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+
+class SceneGraph {
+
+public:
+	using Node = int;
+	static constexpr Node NONE = -1;
+
+	// Adds a node under parent, or a new root for NONE
+	Node addNode(Node parent, const glm::mat4& local = glm::mat4(1.0f));
+
+	void setLocal(Node node, const glm::mat4& local);
+	const glm::mat4& getLocal(Node node) const { return locals[node]; }
+	Node getParent(Node node) const { return parents[node]; }
+
+	// As of the last update()
+	const glm::mat4& getWorld(Node node) const { return worlds[node]; }
+	const std::vector<glm::mat4>& getWorldMatrices() const { return worlds; }
+
+	// Brings the world matrices of dirty subtrees up to date. Returns how
+	// many were recomputed.
+	size_t update();
+
+	size_t size() const { return parents.size(); }
+	void reserve(size_t nodeCount);
+
+private:
+	// One entry per node, indexed by Node
+	std::vector<Node> parents;
+	std::vector<glm::mat4> locals;
+	std::vector<glm::mat4> worlds;
+	std::vector<Node> subtreeEnds;		// one past the node's last descendant, while depthFirst
+	std::vector<unsigned char> dirty;
+
+	// Nodes whose local transform changed since the last update
+	std::vector<Node> dirtyNodes;
+
+	// Whether the nodes were added depth first, so far
+	bool depthFirst = true;
+};
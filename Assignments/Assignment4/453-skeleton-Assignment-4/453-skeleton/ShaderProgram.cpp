@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "Log.h"
+#include "RenderStats.h"
 
 
 ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath)
@@ -28,6 +29,7 @@ bool ShaderProgram::recompile() {
 		// Try to create a new program
 		ShaderProgram newProgram(vertex.getPath(), fragment.getPath());
 		*this = std::move(newProgram);
+		RenderStats::countShaderRecompile();
 		return true;
 	}
 	catch (std::runtime_error &e) {
@@ -0,0 +1,18 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// ImGui overlay for RenderStats: frame times with a plot and a histogram,
+// draw calls, bytes uploaded, texture memory and shader recompiles.
+//
+// Call between ImGui::NewFrame() and ImGui::Render().
+//------------------------------------------------------------------------------
+
+#include "RenderStats.h"
+
+
+namespace StatsOverlay {
+
+	// Draws the overlay in the top right corner of a window displayWidth wide
+	void draw(const RenderStats::Recorder& stats, float displayWidth);
+
+}
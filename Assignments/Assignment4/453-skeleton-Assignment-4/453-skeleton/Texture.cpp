@@ -1,57 +1,204 @@
 #include "Texture.h"
+
+#include "TextureCache.h"
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
+#include <cstring>
 #include <iostream>
 
+// From GL_EXT_texture_compression_s3tc, which our glad wasn't generated with
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+
+void TextureImage::PixelDeleter::operator()(unsigned char* pixels) const {
+	stbi_image_free(pixels);
+}
+
+
+TextureImage TextureImage::decode(const std::string& path) {
+	TextureImage image;
+	image.path = path;
+
+	// The thread-local version, so decoders on different threads don't race on the setting
+	stbi_set_flip_vertically_on_load_thread(true);
+	image.pixels.reset(stbi_load(path.c_str(), &image.width, &image.height, &image.components, 0));
+	return image;
+}
+
+
 Texture::Texture(std::string path, GLint interpolation)
-	: textureID(), path(path), interpolation(interpolation)
+	: textureID(), path(path), interpolation(interpolation), loaded(false), width(0), height(0)
 {
-	int numComponents;
-	stbi_set_flip_vertically_on_load(true);
-	const char* pathData = path.c_str();
-	unsigned char* data = stbi_load(pathData, &width, &height, &numComponents, 0);
-	if (data != nullptr)
-	{
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);		//Set alignment to be 1
-
-		bind();
-
-		//Set number of components by format of the texture
-		GLuint format = GL_RGB;
-		switch (numComponents)
-		{
-		case 4:
-			format = GL_RGBA;
-			break;
-		case 3:
-			format = GL_RGB;
-			break;
-		case 2:
-			format = GL_RG;
-			break;
-		case 1:
-			format = GL_RED;
-			break;
-		default:
-			std::cout << "Invalid Texture Format" << std::endl;
-			break;
-		};
-		//Loads texture data into bound texture
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, interpolation);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, interpolation);
-
-		// Clean up
-		unbind();
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);	//Return to default alignment
-		stbi_image_free(data);
-
-	}
-	else {
+	CookedTexture cooked = CookedTexture::load(path);
+	if (!cooked.valid()) {
 		throw std::runtime_error("Failed to read texture data from file!");
 	}
+	upload(cooked);
+}
+
+
+Texture::Texture(GLint interpolation)
+	: textureID(), path(), interpolation(interpolation), loaded(false), width(0), height(0)
+{
+	TextureImage placeholder;
+	placeholder.width = 2;
+	placeholder.height = 2;
+	placeholder.components = 3;
+	placeholder.pixels.reset(static_cast<unsigned char*>(STBI_MALLOC(placeholder.size())));
+	std::memset(placeholder.pixels.get(), 128, placeholder.size());
+
+	upload(placeholder);
+	loaded = false;
+}
+
+
+void Texture::upload(const TextureImage& image, GLuint pixelBuffer) {
+	path = image.path;
+	uploadLevels({ { image.width, image.height, 0, image.size() } }, image.components, BlockCompression::Format::Uncompressed,
+		image.pixels.get(), image.size(), pixelBuffer);
+}
+
+
+void Texture::upload(const CookedTexture& cooked, GLuint pixelBuffer) {
+	path = cooked.getPath();
+
+	const BlockCompression::Format format = cooked.getFormat();
+	const int components = cooked.getComponents();
+
+	std::vector<Level> levels;
+	for (const CookedTexture::Level& level : cooked.getLevels()) {
+		levels.push_back({ level.width, level.height, level.offset, level.size });
+	}
+
+	if (format == BlockCompression::Format::Uncompressed || supportsBlockCompression()) {
+		uploadLevels(levels, components, format, cooked.data(), cooked.size(), pixelBuffer);
+		return;
+	}
+
+	// No S3TC, so decode every level back to plain pixels
+	std::vector<unsigned char> decoded;
+	for (Level& level : levels) {
+		const size_t decodedSize = static_cast<size_t>(level.width) * level.height * components;
+		decoded.resize(decoded.size() + decodedSize);
+		BlockCompression::decode(cooked.data() + level.offset, level.width, level.height, components, format,
+			decoded.data() + decoded.size() - decodedSize);
+		level.offset = decoded.size() - decodedSize;
+		level.size = decodedSize;
+	}
+	uploadLevels(levels, components, BlockCompression::Format::Uncompressed, decoded.data(), decoded.size(), pixelBuffer);
+}
+
+
+bool Texture::supportsBlockCompression() {
+	// Core profiles only list extensions one at a time
+	static const bool supported = [] {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; i++) {
+			const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			if (name != nullptr && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) {
+				return true;
+			}
+		}
+		return false;
+	}();
+	return supported;
+}
+
+
+void Texture::uploadLevels(const std::vector<Level>& levels, int components, BlockCompression::Format format,
+	const unsigned char* pixels, size_t size, GLuint pixelBuffer)
+{
+	width = levels[0].width;
+	height = levels[0].height;
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);		//Set alignment to be 1
+
+	bind();
+
+	//Set number of components by format of the texture
+	GLuint pixelFormat = GL_RGB;
+	switch (components)
+	{
+	case 4:
+		pixelFormat = GL_RGBA;
+		break;
+	case 3:
+		pixelFormat = GL_RGB;
+		break;
+	case 2:
+		pixelFormat = GL_RG;
+		break;
+	case 1:
+		pixelFormat = GL_RED;
+		break;
+	default:
+		std::cout << "Invalid Texture Format" << std::endl;
+		break;
+	};
+
+	GLenum compressedFormat = 0;
+	if (format == BlockCompression::Format::BC1) {
+		compressedFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	}
+	else if (format == BlockCompression::Format::BC3) {
+		compressedFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	}
+
+	// With a pixel buffer, copy every level into it in one go. glTexImage2D
+	// then reads from it (the last argument becomes an offset) instead of
+	// from our memory.
+	bool fromPixelBuffer = false;
+	if (pixelBuffer != 0) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (mapped != nullptr) {
+			std::memcpy(mapped, pixels, size);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			fromPixelBuffer = true;
+		}
+		else {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+	}
+
+	//Loads texture data into bound texture
+	for (size_t i = 0; i < levels.size(); i++) {
+		const Level& level = levels[i];
+		const void* levelPixels = fromPixelBuffer ? reinterpret_cast<const void*>(level.offset) : pixels + level.offset;
+		if (compressedFormat != 0) {
+			glCompressedTexImage2D(GL_TEXTURE_2D, GLint(i), compressedFormat, level.width, level.height, 0, GLsizei(level.size), levelPixels);
+		}
+		else {
+			glTexImage2D(GL_TEXTURE_2D, GLint(i), pixelFormat, level.width, level.height, 0, pixelFormat, GL_UNSIGNED_BYTE, levelPixels);
+		}
+	}
+	if (fromPixelBuffer) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	residentBytes.set(size);
+	RenderStats::countUpload(size);
+
+	// Only sample from the mip levels we actually have
+	GLint minFilter = interpolation;
+	if (levels.size() > 1) {
+		minFilter = interpolation == GL_NEAREST ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR;
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(levels.size()) - 1);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, interpolation);
+
+	// Clean up
+	unbind();
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);	//Return to default alignment
+	loaded = true;
 }
@@ -1,18 +1,51 @@
 #pragma once
 
+#include "BlockCompression.h"
 #include "GLHandles.h"
+#include "RenderStats.h"
 //#include <GL/glew.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 
+class CookedTexture;
+
+// Pixels decoded from an image file, ready to be uploaded to a Texture.
+// Decoding touches no OpenGL state, so it can run on any thread.
+struct TextureImage {
+	struct PixelDeleter {
+		void operator()(unsigned char* pixels) const;
+	};
+
+	std::string path;
+	int width = 0;
+	int height = 0;
+	int components = 0;
+	std::unique_ptr<unsigned char, PixelDeleter> pixels;
+
+	bool valid() const { return pixels != nullptr; }
+	size_t size() const { return static_cast<size_t>(width) * height * components; }
+
+	// Flipped vertically to match OpenGL's texture coordinates. Returns an
+	// invalid image if the file couldn't be read.
+	static TextureImage decode(const std::string& path);
+};
+
 
 class Texture {
 public:
+	// Loads through the texture cache (see TextureCache.h), so the texture
+	// gets a full mip chain. Throws if the image can't be read.
 	Texture(std::string path, GLint interpolation);
 
+	// A tiny grey placeholder, until upload() is handed the real image.
+	// See TextureLoader for filling these in the background.
+	explicit Texture(GLint interpolation);
+
 	// Because we're using the TextureHandle to do RAII for the texture for us
 	// and our other types are trivial or provide their own RAII
 	// we don't have to provide any specialized functions here. Rule of zero
@@ -20,21 +53,48 @@ public:
 	// https://en.cppreference.com/w/cpp/language/rule_of_three
 	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
 
+	// Replaces the contents of the texture with image. Must be called on the
+	// GL thread. With a pixelBuffer the pixels go through that pixel buffer
+	// object, so the driver can copy them to the GPU asynchronously.
+	void upload(const TextureImage& image, GLuint pixelBuffer = 0);
+
+	// Same, with every mip level in cooked. Minification then blends
+	// between levels instead of skipping texels. Block compressed levels
+	// stay compressed on the GPU if the context supports S3TC, and are
+	// decoded here first if it doesn't.
+	void upload(const CookedTexture& cooked, GLuint pixelBuffer = 0);
+
+	// Whether the current context can sample BC1/BC3 textures. GL thread only.
+	static bool supportsBlockCompression();
+
 	// Public interface
 	std::string getPath() const { return path; }
 	GLenum getInterpolation() const { return interpolation; }
+	bool isLoaded() const { return loaded; }
 
 	// Although uint (i.e. uvec2) might make more sense here, went with int (i.e. ivec2) under
 	// the assumption that most students will want to work with ints, not uints, in main.cpp
 	glm::ivec2 getDimensions() const { return glm::uvec2(width, height); }
 
 	void bind() { glBindTexture(GL_TEXTURE_2D, textureID); }
-	void unbind() { glBindTexture(GL_TEXTURE_2D, textureID); }
+	void unbind() { glBindTexture(GL_TEXTURE_2D, 0); }
+	GLuint getId() const { return textureID; }
 
 private:
 	TextureHandle textureID;
 	std::string path;
 	GLint interpolation;
+	RenderStats::TextureBytes residentBytes;
+	bool loaded;
+
+	struct Level {
+		int width;
+		int height;
+		size_t offset;
+		size_t size;
+	};
+	void uploadLevels(const std::vector<Level>& levels, int components, BlockCompression::Format format,
+		const unsigned char* pixels, size_t size, GLuint pixelBuffer);
 
 
 	// Although uint might make more sense here, went with int under the assumption
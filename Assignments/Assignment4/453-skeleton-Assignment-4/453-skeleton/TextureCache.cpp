@@ -0,0 +1,396 @@
+#include "TextureCache.h"
+
+#include "Log.h"
+#include "Texture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: bytes(other.bytes)
+	, length(other.length)
+{
+	other.bytes = nullptr;
+	other.length = 0;
+}
+
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		close();
+		std::swap(bytes, other.bytes);
+		std::swap(length, other.length);
+	}
+	return *this;
+}
+
+
+MappedFile MappedFile::open(const std::string& path) {
+	MappedFile file;
+
+	// The view keeps the file alive by itself, so every handle can be closed
+	// straight away and only the view needs cleaning up later
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return file;
+	}
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(handle, &fileSize) && fileSize.QuadPart > 0) {
+		HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr) {
+			void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (view != nullptr) {
+				file.bytes = static_cast<const unsigned char*>(view);
+				file.length = static_cast<size_t>(fileSize.QuadPart);
+			}
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(handle);
+#else
+	int descriptor = ::open(path.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		return file;
+	}
+	struct stat status;
+	if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+		void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (view != MAP_FAILED) {
+			file.bytes = static_cast<const unsigned char*>(view);
+			file.length = static_cast<size_t>(status.st_size);
+		}
+	}
+	::close(descriptor);
+#endif
+	return file;
+}
+
+
+void MappedFile::close() {
+	if (bytes == nullptr) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(bytes);
+#else
+	munmap(const_cast<unsigned char*>(bytes), length);
+#endif
+	bytes = nullptr;
+	length = 0;
+}
+
+
+namespace {
+
+	// What a cooked file starts with. Fixed size types, written as is, so a
+	// cooked file only loads on a machine with the same byte order. Bump
+	// the version whenever the layout or the filter changes.
+	const char cookedMagic[4] = { 'T', 'X', '4', '5' };
+	const uint32_t cookedVersion = 2;
+
+	struct FileHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t components;
+		uint32_t format;
+		uint32_t levelCount;
+	};
+
+	struct FileLevel {
+		uint32_t width;
+		uint32_t height;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	// Pixel data starts on a 16 byte boundary after the level table
+	size_t dataOffsetFor(size_t levelCount) {
+		size_t headerSize = sizeof(FileHeader) + levelCount * sizeof(FileLevel);
+		return (headerSize + 15) & ~size_t(15);
+	}
+
+
+	// Runs task(firstRow, lastRow) over [0, rows), split across up to
+	// threadCount threads. Small levels aren't worth starting a thread for.
+	template <typename RowTask>
+	void forEachRowBand(int rows, int rowWidth, unsigned threadCount, RowTask task) {
+		const int minPixelsPerThread = 64 * 1024;
+		int bands = std::min<int>(threadCount, std::max(1, rows * rowWidth / minPixelsPerThread));
+		bands = std::max(1, std::min(bands, rows));
+
+		std::vector<std::thread> threads;
+		for (int band = 1; band < bands; band++) {
+			threads.emplace_back(task, rows * band / bands, rows * (band + 1) / bands);
+		}
+		task(0, rows / bands);
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+	}
+
+
+	// One 2x box filter step. Odd edges reuse the last row or column, so
+	// every level is max(1, size / 2) of the one above it.
+	void downsample(const unsigned char* source, int sourceWidth, int sourceHeight,
+		unsigned char* target, int targetWidth, int targetHeight, int components, unsigned threadCount)
+	{
+		forEachRowBand(targetHeight, targetWidth, threadCount, [=](int firstRow, int lastRow) {
+			for (int y = firstRow; y < lastRow; y++) {
+				const int y0 = std::min(2 * y, sourceHeight - 1);
+				const int y1 = std::min(2 * y + 1, sourceHeight - 1);
+				const unsigned char* row0 = source + static_cast<size_t>(y0) * sourceWidth * components;
+				const unsigned char* row1 = source + static_cast<size_t>(y1) * sourceWidth * components;
+				unsigned char* out = target + static_cast<size_t>(y) * targetWidth * components;
+
+				for (int x = 0; x < targetWidth; x++) {
+					const int x0 = std::min(2 * x, sourceWidth - 1) * components;
+					const int x1 = std::min(2 * x + 1, sourceWidth - 1) * components;
+					for (int c = 0; c < components; c++) {
+						int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+						out[x * components + c] = static_cast<unsigned char>((sum + 2) / 4);
+					}
+				}
+			}
+		});
+	}
+}
+
+
+CookedTexture CookedTexture::load(const std::string& sourcePath, unsigned threadCount, bool compress) {
+	using BlockCompression::Format;
+
+	const std::string cookedFile = cookedPath(sourcePath);
+	if (isUpToDate(sourcePath, cookedFile)) {
+		CookedTexture texture = map(sourcePath, cookedFile);
+		const Format wanted = compress ? BlockCompression::formatFor(texture.components) : Format::Uncompressed;
+		if (texture.valid() && texture.format == wanted) {
+			return texture;
+		}
+		if (!texture.valid()) {
+			Log::warning("TEXTURE_CACHE {} is damaged, cooking it again", cookedFile);
+		}
+	}
+
+	CookedTexture texture = cook(sourcePath, threadCount, compress);
+	if (texture.valid() && !texture.write(cookedFile)) {
+		// Still perfectly usable, it just gets cooked again next time
+		Log::warning("TEXTURE_CACHE couldn't write {}", cookedFile);
+	}
+	return texture;
+}
+
+
+std::string CookedTexture::cookedPath(const std::string& sourcePath) {
+	return sourcePath + ".cooked";
+}
+
+
+bool CookedTexture::isUpToDate(const std::string& sourcePath, const std::string& cookedPath) {
+	namespace fs = std::filesystem;
+	std::error_code error;
+	fs::file_time_type cookedTime = fs::last_write_time(cookedPath, error);
+	if (error) {
+		return false;
+	}
+	fs::file_time_type sourceTime = fs::last_write_time(sourcePath, error);
+	// Without the source there is nothing newer to cook from
+	return error || cookedTime >= sourceTime;
+}
+
+
+const unsigned char* CookedTexture::data() const {
+	return isMapped() ? mapping.data() + dataOffset : cooked.data();
+}
+
+
+size_t CookedTexture::size() const {
+	return levels.empty() ? 0 : levels.back().offset + levels.back().size;
+}
+
+
+CookedTexture CookedTexture::cook(const std::string& sourcePath, unsigned threadCount, bool compress) {
+	CookedTexture texture;
+	texture.path = sourcePath;
+
+	TextureImage image = TextureImage::decode(sourcePath);
+	if (!image.valid()) {
+		return texture;
+	}
+	if (threadCount == 0) {
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// Lay out every level first, so the whole chain is one allocation
+	const int components = image.components;
+	int width = image.width;
+	int height = image.height;
+	size_t offset = 0;
+	while (true) {
+		size_t size = static_cast<size_t>(width) * height * components;
+		texture.levels.push_back({ width, height, offset, size });
+		offset += size;
+		if (width == 1 && height == 1) {
+			break;
+		}
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+
+	texture.components = components;
+	texture.cooked.resize(offset);
+	std::memcpy(texture.cooked.data(), image.pixels.get(), image.size());
+
+	// Each level is filtered from the one above, which is closer than the
+	// original and only a quarter of the work
+	for (size_t i = 1; i < texture.levels.size(); i++) {
+		const Level& source = texture.levels[i - 1];
+		const Level& target = texture.levels[i];
+		downsample(texture.cooked.data() + source.offset, source.width, source.height,
+			texture.cooked.data() + target.offset, target.width, target.height, components, threadCount);
+	}
+
+	texture.format = compress ? BlockCompression::formatFor(components) : BlockCompression::Format::Uncompressed;
+	if (texture.format == BlockCompression::Format::Uncompressed) {
+		return texture;
+	}
+
+	// Compress every level into a second buffer, a band of block rows per thread
+	std::vector<Level> encodedLevels;
+	size_t encodedOffset = 0;
+	for (const Level& level : texture.levels) {
+		size_t size = BlockCompression::encodedSize(level.width, level.height, texture.format);
+		encodedLevels.push_back({ level.width, level.height, encodedOffset, size });
+		encodedOffset += size;
+	}
+
+	std::vector<unsigned char> encoded(encodedOffset);
+	for (size_t i = 0; i < texture.levels.size(); i++) {
+		const Level& source = texture.levels[i];
+		const Level& target = encodedLevels[i];
+		const int blockRows = (source.height + 3) / 4;
+		const int blockColumns = (source.width + 3) / 4;
+
+		// Encoding a block costs about as much as filtering 16 pixels
+		forEachRowBand(blockRows, blockColumns * 16, threadCount, [&](int firstBlockRow, int lastBlockRow) {
+			BlockCompression::encode(texture.cooked.data() + source.offset, source.width, source.height, components,
+				texture.format, encoded.data() + target.offset, firstBlockRow, lastBlockRow);
+		});
+	}
+
+	texture.levels = std::move(encodedLevels);
+	texture.cooked = std::move(encoded);
+	return texture;
+}
+
+
+CookedTexture CookedTexture::map(const std::string& sourcePath, const std::string& cookedPath) {
+	CookedTexture texture;
+	texture.path = sourcePath;
+
+	MappedFile file = MappedFile::open(cookedPath);
+	if (!file.valid() || file.size() < sizeof(FileHeader)) {
+		return texture;
+	}
+
+	FileHeader header;
+	std::memcpy(&header, file.data(), sizeof(header));
+	if (std::memcmp(header.magic, cookedMagic, sizeof(cookedMagic)) != 0 || header.version != cookedVersion
+		|| header.components < 1 || header.components > 4 || header.levelCount < 1 || header.levelCount > 32
+		|| header.format > uint32_t(BlockCompression::Format::BC3))
+	{
+		return texture;
+	}
+	const BlockCompression::Format format = BlockCompression::Format(header.format);
+
+	const size_t dataOffset = dataOffsetFor(header.levelCount);
+	if (file.size() < dataOffset) {
+		return texture;
+	}
+
+	// Check every level really is inside the file before trusting any of it
+	std::vector<Level> levels;
+	for (uint32_t i = 0; i < header.levelCount; i++) {
+		FileLevel level;
+		std::memcpy(&level, file.data() + sizeof(FileHeader) + i * sizeof(FileLevel), sizeof(level));
+		const uint64_t expectedSize = format == BlockCompression::Format::Uncompressed
+			? uint64_t(level.width) * level.height * header.components
+			: BlockCompression::encodedSize(int(level.width), int(level.height), format);
+		if (level.width == 0 || level.height == 0 || level.width > 65536 || level.height > 65536
+			|| level.size != expectedSize
+			|| level.offset + level.size > file.size() - dataOffset)
+		{
+			return texture;
+		}
+		levels.push_back({ int(level.width), int(level.height), size_t(level.offset), size_t(level.size) });
+	}
+
+	texture.components = int(header.components);
+	texture.format = format;
+	texture.levels = std::move(levels);
+	texture.mapping = std::move(file);
+	texture.dataOffset = dataOffset;
+	return texture;
+}
+
+
+bool CookedTexture::write(const std::string& cookedPath) const {
+	// Write to the side and rename over the old one, so another copy of the
+	// program never maps a half written file
+	const std::string temporaryPath = cookedPath + ".tmp";
+	{
+		std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!out) {
+			return false;
+		}
+
+		FileHeader header;
+		std::memcpy(header.magic, cookedMagic, sizeof(cookedMagic));
+		header.version = cookedVersion;
+		header.components = uint32_t(components);
+		header.format = uint32_t(format);
+		header.levelCount = uint32_t(levels.size());
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		for (const Level& level : levels) {
+			FileLevel fileLevel = { uint32_t(level.width), uint32_t(level.height), uint64_t(level.offset), uint64_t(level.size) };
+			out.write(reinterpret_cast<const char*>(&fileLevel), sizeof(fileLevel));
+		}
+
+		const char padding[16] = {};
+		const size_t headerSize = sizeof(FileHeader) + levels.size() * sizeof(FileLevel);
+		out.write(padding, dataOffsetFor(levels.size()) - headerSize);
+		out.write(reinterpret_cast<const char*>(data()), size());
+		if (!out) {
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, cookedPath, error);
+	if (error) {
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Cooked textures: decoded once, with a full mip chain, and kept on disk.
+//
+// The first time an image is loaded it is decoded with stb_image, filtered
+// down to a 1x1 mip chain, block compressed (see BlockCompression.h) and
+// written next to the source as <source>.cooked.
+// From then on, as long as the cooked file is newer than the source, it is
+// memory mapped instead, so loading costs little more than the page faults
+// for the levels that get uploaded.
+//
+// Nothing here touches OpenGL, so loads can run on any thread. The pixels are
+// uploaded with Texture::upload().
+//
+// Example: CookedTexture cooked = CookedTexture::load("textures/2k_moon.jpg");
+//          if (cooked.valid()) moonTex.upload(cooked);
+//------------------------------------------------------------------------------
+
+#include "BlockCompression.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// A read-only view of a whole file, mapped into memory. Move only.
+class MappedFile {
+
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	// Returns an empty mapping if the file can't be opened or is empty
+	static MappedFile open(const std::string& path);
+
+	bool valid() const { return bytes != nullptr; }
+	const unsigned char* data() const { return bytes; }
+	size_t size() const { return length; }
+
+private:
+	const unsigned char* bytes = nullptr;
+	size_t length = 0;
+
+	void close();
+};
+
+
+class CookedTexture {
+
+public:
+	struct Level {
+		int width;
+		int height;
+		size_t offset;		// from the start of data()
+		size_t size;
+	};
+
+	// The cooked version of sourcePath: mapped if it is up to date, otherwise
+	// cooked now and written out for next time. Invalid if the source couldn't
+	// be read. threadCount threads filter and compress the mip chain, 0 for
+	// one per core. Without compress the levels are kept as plain pixels.
+	static CookedTexture load(const std::string& sourcePath, unsigned threadCount = 0, bool compress = true);
+
+	// Decodes and filters sourcePath without going near the cache on disk
+	static CookedTexture cook(const std::string& sourcePath, unsigned threadCount, bool compress);
+
+	// Where the cooked version of sourcePath lives
+	static std::string cookedPath(const std::string& sourcePath);
+
+	// Whether the file cookedPath was made from sourcePath since it last changed
+	static bool isUpToDate(const std::string& sourcePath, const std::string& cookedPath);
+
+	bool valid() const { return !levels.empty(); }
+	bool isMapped() const { return mapping.valid(); }
+
+	const std::string& getPath() const { return path; }
+	int getComponents() const { return components; }
+	BlockCompression::Format getFormat() const { return format; }
+	const std::vector<Level>& getLevels() const { return levels; }
+
+	// Every level back to back, largest first
+	const unsigned char* data() const;
+	size_t size() const;
+
+private:
+	std::string path;
+	int components = 0;
+	BlockCompression::Format format = BlockCompression::Format::Uncompressed;
+	std::vector<Level> levels;
+
+	// The pixels live in one of these: the mapped file, or a freshly cooked buffer
+	MappedFile mapping;
+	size_t dataOffset = 0;
+	std::vector<unsigned char> cooked;
+
+	static CookedTexture map(const std::string& sourcePath, const std::string& cookedPath);
+	bool write(const std::string& cookedPath) const;
+};
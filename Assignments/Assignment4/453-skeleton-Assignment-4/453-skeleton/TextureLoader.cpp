@@ -0,0 +1,120 @@
+#include "TextureLoader.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstdint>
+
+
+TextureLoader::TextureLoader(unsigned threadCount, bool usePixelBuffers, bool compress)
+	: running(true)
+	, inFlight(0)
+	, usePixelBuffers(usePixelBuffers)
+	, compress(compress)
+	, pixelBuffer()
+{
+	if (threadCount == 0) {
+		// Decoding is the bottleneck, but there are only a handful of textures
+		threadCount = std::min(4u, std::max(1u, std::thread::hardware_concurrency()));
+	}
+	filterThreads = std::max(1u, std::thread::hardware_concurrency() / threadCount);
+	for (unsigned i = 0; i < threadCount; i++) {
+		workers.emplace_back(&TextureLoader::workerLoop, this);
+	}
+}
+
+
+TextureLoader::~TextureLoader() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	requestReady.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+
+void TextureLoader::load(Texture& texture, const std::string& path) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		requests.push_back({ &texture, path });
+		inFlight++;
+	}
+	requestReady.notify_one();
+}
+
+
+void TextureLoader::update(size_t uploadBudget) {
+	size_t uploaded = 0;
+	while (uploaded == 0 || uploaded < uploadBudget) {
+		Decoded result;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (decoded.empty()) {
+				return;
+			}
+			result = std::move(decoded.front());
+			decoded.pop_front();
+		}
+		uploaded += std::max<size_t>(1, result.image.size());
+		uploadOne(result);
+	}
+}
+
+
+void TextureLoader::finish() {
+	while (pending() > 0) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			imageReady.wait(lock, [this] { return !decoded.empty() || inFlight == 0; });
+		}
+		update(SIZE_MAX);
+	}
+}
+
+
+size_t TextureLoader::pending() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return inFlight;
+}
+
+
+void TextureLoader::workerLoop() {
+	while (true) {
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			requestReady.wait(lock, [this] { return !requests.empty() || !running; });
+			if (!running) {
+				return;
+			}
+			request = std::move(requests.front());
+			requests.pop_front();
+		}
+
+		// Share the cores between workers for filtering mip levels
+		CookedTexture image = CookedTexture::load(request.path, filterThreads, compress);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			decoded.push_back({ request.texture, std::move(image) });
+		}
+		imageReady.notify_all();
+	}
+}
+
+
+void TextureLoader::uploadOne(Decoded& result) {
+	if (result.image.valid()) {
+		result.texture->upload(result.image, usePixelBuffers ? pixelBuffer.value() : 0);
+	}
+	else {
+		// Keep the placeholder rather than taking the whole program down
+		Log::error("TEXTURE_LOADER failed to read {}", result.image.getPath());
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	inFlight--;
+}
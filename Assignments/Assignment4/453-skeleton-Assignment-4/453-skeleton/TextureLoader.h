@@ -0,0 +1,87 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Loads textures in the background.
+//
+// Images are loaded on a small pool of worker threads through the texture
+// cache, so a JPEG is only decoded and filtered into mip levels the first
+// time, and mapped straight from disk after that. Loaded images queue up until
+// update() is called on the GL thread, which uploads them into their Texture.
+// Until then each texture shows a grey placeholder, so the first frame can be
+// drawn straight away no matter how many or how large the textures are.
+//
+// Example: Texture earthTex(GL_NEAREST);
+//          TextureLoader loader;
+//          loader.load(earthTex, "textures/2k_earth_daymap.jpg");
+//          while (...) { loader.update(); ... draw ... }
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "Texture.h"
+#include "TextureCache.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+class TextureLoader {
+
+public:
+	// threadCount decoding threads, or one per core (up to 4) for 0. With
+	// usePixelBuffers, uploads go through a pixel buffer object. Textures
+	// are block compressed unless compress is false.
+	explicit TextureLoader(unsigned threadCount = 0, bool usePixelBuffers = false, bool compress = true);
+	~TextureLoader();
+
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	// Starts decoding path in the background. The texture is filled in by a
+	// later update(), so it must stay where it is until then.
+	void load(Texture& texture, const std::string& path);
+
+	// GL thread, once a frame: uploads finished images. Stops once
+	// uploadBudget bytes have gone up, but always uploads at least one
+	// image, so a frame never has to absorb every texture at once.
+	void update(size_t uploadBudget = 16 * 1024 * 1024);
+
+	// GL thread: waits for every load so far and uploads them
+	void finish();
+
+	// Loads that haven't been uploaded yet
+	size_t pending() const;
+
+private:
+	struct Request {
+		Texture* texture;
+		std::string path;
+	};
+
+	struct Decoded {
+		Texture* texture;
+		CookedTexture image;
+	};
+
+	std::vector<std::thread> workers;
+	unsigned filterThreads;
+	bool running;
+
+	mutable std::mutex mutex;
+	std::condition_variable requestReady;
+	std::condition_variable imageReady;
+	std::deque<Request> requests;
+	std::deque<Decoded> decoded;
+	size_t inFlight;
+
+	bool usePixelBuffers;
+	bool compress;
+	VertexBufferHandle pixelBuffer;
+
+	void workerLoop();
+	void uploadOne(Decoded& result);
+};
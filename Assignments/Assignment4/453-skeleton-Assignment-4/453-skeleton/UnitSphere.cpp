@@ -1,179 +1,119 @@
 #include "UnitSphere.h"
-#include <glm/gtx/transform.hpp>
 
-#include "cmath"
-#include "corecrt_math_defines.h"
-
-// Defines
-#define HALF_CIRCLE_CONTROL_POINTS 11
-#define B_SPLINE_SUBDIVISION_ITERATIONS 3
-#define SURFACE_OF_REVOLUTION_SLICES 30
-
-// Definitions
-std::vector<glm::vec3> generateHalfCircleControlPoints(float radius, int segments);
-std::vector<glm::vec3> chaikinCurveSubdivision(const std::vector<glm::vec3>& coarsePoints, int iterations);
-std::pair<std::vector<glm::vec3>, std::vector<glm::vec2>> surfaceOfRevolution(std::vector<glm::vec3>& curvePoints, int n_slices, float radius);
-std::vector<glm::vec2> generateTextureCoordinates(const std::vector<glm::vec3>& verts, int n_slices, int n_stacks);
-std::vector<glm::vec3> computeNormals(const std::vector<glm::vec3>& verts);
+#include "RenderStats.h"
 
+#include <cmath>
 
-void UnitSphere::generateGeometry(float radius) {
-	// Generate the Half circle control points
-	std::vector<glm::vec3> controlPoints = generateHalfCircleControlPoints(radius, HALF_CIRCLE_CONTROL_POINTS);
+#include <glm/gtc/constants.hpp>
 
-	// Chaikin's subdivision for smoothing
-	std::vector<glm::vec3> smoothCurve = chaikinCurveSubdivision(controlPoints, B_SPLINE_SUBDIVISION_ITERATIONS);
+// Defines
+#define FINEST_SLICES 128				// slices of LOD 0; stacks are always half the slices
+#define MAX_SILHOUETTE_ERROR 0.5f		// pixels between the true outline and the mesh's
+
+
+void UnitSphere::generateGeometry() {
+	m_cpu_geom = CPU_Geometry();
+	m_indices.clear();
+
+	for (int lod = 0; lod < LOD_COUNT; lod++) {
+		const int slices = FINEST_SLICES >> lod;
+		const int stacks = slices / 2;
+		const GLuint firstVertex = static_cast<GLuint>(m_cpu_geom.verts.size());
+
+		// One sin/cos per column and per row, rather than per vertex
+		std::vector<float> cosLongitude(slices + 1);
+		std::vector<float> sinLongitude(slices + 1);
+		for (int j = 0; j < slices; j++) {
+			float angle = 2.0f * glm::pi<float>() * j / slices;
+			cosLongitude[j] = std::cos(angle);
+			sinLongitude[j] = std::sin(angle);
+		}
+		// The seam column sits exactly on the first one, so the two never crack apart
+		cosLongitude[slices] = cosLongitude[0];
+		sinLongitude[slices] = sinLongitude[0];
+
+		// Rows run from the north pole (v = 1) to the south pole (v = 0), with
+		// v linear in latitude to match equirectangular maps. The seam and
+		// pole vertices are duplicated so every vertex has a single UV: u
+		// runs 0 to 1 around the seam, and each pole vertex takes the u of the
+		// middle of the triangle it belongs to.
+		for (int i = 0; i <= stacks; i++) {
+			float polar = glm::pi<float>() * i / stacks;
+			float ringRadius = (i == 0 || i == stacks) ? 0.0f : std::sin(polar);
+			float y = i == 0 ? 1.0f : (i == stacks ? -1.0f : std::cos(polar));
+			float v = 1.0f - static_cast<float>(i) / stacks;
+			bool pole = i == 0 || i == stacks;
+
+			for (int j = 0; j <= slices; j++) {
+				glm::vec3 position(ringRadius * cosLongitude[j], y, ringRadius * sinLongitude[j]);
+				float u = (pole ? j + 0.5f : static_cast<float>(j)) / slices;
+				m_cpu_geom.verts.push_back(position);
+				m_cpu_geom.normals.push_back(position);
+				m_cpu_geom.texCoords.push_back(glm::vec2(u, v));
+			}
+		}
 
-	// Generate sphere from smooth half circle curve
-	auto [surface, texCoord] = surfaceOfRevolution(smoothCurve, SURFACE_OF_REVOLUTION_SLICES, radius);  // Generate the surface verts and texCoords
+		// Two counter-clockwise (seen from outside) triangles per quad, except
+		// next to the poles where half of each quad collapses to nothing
+		m_lods[lod].slices = slices;
+		m_lods[lod].stacks = stacks;
+		m_lods[lod].firstIndex = m_indices.size();
+		for (int i = 0; i < stacks; i++) {
+			for (int j = 0; j < slices; j++) {
+				GLuint a = firstVertex + i * (slices + 1) + j;
+				GLuint b = a + (slices + 1);
+				GLuint c = b + 1;
+				GLuint d = a + 1;
+				if (i != stacks - 1) {
+					m_indices.insert(m_indices.end(), { a, c, b });
+				}
+				if (i != 0) {
+					m_indices.insert(m_indices.end(), { a, d, c });
+				}
+			}
+		}
+		m_lods[lod].indexCount = static_cast<GLsizei>(m_indices.size() - m_lods[lod].firstIndex);
+	}
 
-	// CPU Geometry: set the vertices and texture coordinates
-	m_cpu_geom.verts = surface;        
-	m_cpu_geom.cols = std::vector<glm::vec3>(m_cpu_geom.verts.size(), glm::vec3(0.f, 0.f, 0.f)); // Set default color (black)
-	m_cpu_geom.texCoords = texCoord; // Set texture coordinates 
+	// The shaders ignore the colours, but the attribute still needs data
+	m_cpu_geom.cols = std::vector<glm::vec3>(m_cpu_geom.verts.size(), glm::vec3(0.f, 0.f, 0.f));
 
-	// GPU Geometry: bind and send the data to the GPU
 	m_gpu_geom.bind();
 	m_gpu_geom.setVerts(m_cpu_geom.verts);
 	m_gpu_geom.setCols(m_cpu_geom.cols);
-	m_gpu_geom.setTexCoords(m_cpu_geom.texCoords);  // Assuming setTexCoords method exists in m_gpu_geom
-
-	// GLSize: the number of vertices
-	m_size = m_cpu_geom.verts.size();
-
-	// Compute normals for the vertices - TODO
-	// std::vector<glm::vec3> normals = computeNormals(surface);
-	// m_cpu_geom.normals = std::vector<glm::vec3>(m_cpu_geom.verts.size(), glm::vec3(0.f, 0.f, 0.f));
-	// m_gpu_geom.setNormals(m_cpu_geom.normals);
+	m_gpu_geom.setNormals(m_cpu_geom.normals);
+	m_gpu_geom.setTexCoords(m_cpu_geom.texCoords);
+	m_gpu_geom.setIndices(m_indices);
 }
 
-/*----------------- Chaikin Curve Subdivision Algorithm -----------------*/
-std::vector<glm::vec3> chaikinCurveSubdivision(const std::vector<glm::vec3>& coarsePoints, int iterations) {
-	// No iterations or not enough points to subdivide
-	int n = coarsePoints.size();
-	if ((iterations == 0) || (n < 2)) {
-		return coarsePoints;
-	}
-
-	std::vector<glm::vec3> C = coarsePoints;
-	std::vector<glm::vec3> F;
-
-	// Special mask at the beginning
-	F.push_back(C[0]);
-	F.push_back(0.5f * C[0] + 0.5f * C[1]);
-
-	// Periodic mask for the interior points
-	for (int i = 1; i < n - 2; ++i) {
-		F.push_back(0.75f * C[i] + 0.25f * C[i + 1]);
-		F.push_back(0.25f * C[i] + 0.75f * C[i + 1]);
-	}
-
-	// Special mask at the end
-	F.push_back(0.5f * C[n - 2] + 0.5f * C[n - 1]);
-	F.push_back(C[n - 1]);
-
-	// Perform subdivision on fine points if there are more iterations
-	return chaikinCurveSubdivision(F, iterations - 1);
-}
 
-/*-------------------- Generate Surface of Revolution -------------------*/
-std::pair<std::vector<glm::vec3>, std::vector<glm::vec2>> surfaceOfRevolution(std::vector<glm::vec3>& curvePoints, int n_slices, float radius) {
-	// Vectors to hold the 3D vertices and texture coordinates
-	std::vector<glm::vec3> surface_verts;
-	std::vector<glm::vec2> surface_uvs;
-
-	// Angle between each slice
-	float angle_step = 2.0f * M_PI / n_slices;
-
-	// For each curve point, generate vertices and their texture coordinates
-	for (int i = 0; i < curvePoints.size() - 1; i++) {
-		glm::vec3 p1 = curvePoints[i];
-		glm::vec3 p2 = curvePoints[i + 1];
-
-		for (int j = 0; j < n_slices; j++) {
-			float angle = j * angle_step;
-			float next_angle = (j + 1) * angle_step;
-
-			// Generate 3D vertices
-			glm::vec3 v1(p1.x * cos(angle), p1.y, p1.x * sin(angle));
-			glm::vec3 v2(p2.x * cos(angle), p2.y, p2.x * sin(angle));
-			glm::vec3 v3(p2.x * cos(next_angle), p2.y, p2.x * sin(next_angle));
-			glm::vec3 v4(p1.x * cos(next_angle), p1.y, p1.x * sin(next_angle));
-
-			// Add the vertices to the surface_verts vector
-			surface_verts.push_back(v1);
-			surface_verts.push_back(v2);
-			surface_verts.push_back(v3);
-			surface_verts.push_back(v1);
-			surface_verts.push_back(v3);
-			surface_verts.push_back(v4);
-
-			// Calculate texture coordinates
-			float u1 = angle / (2 * M_PI);   // Normalize angle to [0, 1]
-			float u2 = next_angle / (2 * M_PI);
-
-			// Assuming y_min = -radius and y_max = radius for the half-sphere
-			float v1_coord = (p1.y + radius) / (2 * radius); // Normalize y to [0, 1]
-			float v2_coord = (p2.y + radius) / (2 * radius);
-
-			// Add the UV coordinates to the surface_uvs vector
-			surface_uvs.push_back(glm::vec2(u1, v1_coord));
-			surface_uvs.push_back(glm::vec2(u1, v2_coord));
-			surface_uvs.push_back(glm::vec2(u2, v2_coord));
-			surface_uvs.push_back(glm::vec2(u1, v1_coord));
-			surface_uvs.push_back(glm::vec2(u2, v2_coord));
-			surface_uvs.push_back(glm::vec2(u2, v1_coord));
-		}
-	}
-
-	// Return both vertices and texture coordinates as a pair
-	return std::make_pair(surface_verts, surface_uvs);
+void UnitSphere::draw(int lod) {
+	m_gpu_geom.bind();
+	const Lod& level = m_lods[lod];
+	glDrawElements(GL_TRIANGLES, level.indexCount, GL_UNSIGNED_INT, reinterpret_cast<const void*>(level.firstIndex * sizeof(GLuint)));
 }
 
 
-/*-------------------- Generate Sphere Control Points -------------------*/
-std::vector<glm::vec3> generateHalfCircleControlPoints(float radius, int segments) {
-	std::vector<glm::vec3> controlPoints;
-
-	// Generate points for a half-circle in the X-Y plane
-	for (int i = 0; i <= segments; ++i) {
-		float angle = M_PI * i / segments; // Angle from -π/2 to π/2
-		float x = radius * sin(angle);    // X-coordinate
-		float y = radius * cos(angle);    // Y-coordinate
-		controlPoints.push_back(glm::vec3(x, y, 0.0f)); // z = 0 for the Z-axis revolution
+int UnitSphere::lodFor(const glm::mat4& model, const glm::vec3& eye, float fovY, int viewportHeight) const {
+	const glm::vec3 centre(model[3]);
+	const float radius = glm::length(glm::vec3(model[0]));
+	const float distance = glm::length(centre - eye);
+	if (distance <= radius) {
+		return 0; // inside it, like the stars
 	}
 
-	return controlPoints;
-}
-
-/*-------------------- Texture Coordinates -------------------*/
-std::vector<glm::vec2> generateTextureCoordinates(const std::vector<glm::vec3>& verts, int n_slices, int n_stacks) {
-	std::vector<glm::vec2> tex_coords;
-
-	// Loop through vertices and assign u, v coordinates
-	for (int stack = 0; stack <= n_stacks; ++stack) {
-		float v = static_cast<float>(stack) / n_stacks; // Latitude (normalized)
-
-		for (int slice = 0; slice < n_slices; ++slice) {
-			float u = static_cast<float>(slice) / n_slices; // Longitude (normalized)
-			tex_coords.push_back(glm::vec2(u, v));
+	// Radius of the outline on screen, in pixels: the sphere's silhouette is
+	// at asin(radius / distance) from its centre
+	const float tangent = radius / std::sqrt(distance * distance - radius * radius);
+	const float projectedRadius = tangent / std::tan(fovY / 2.0f) * (viewportHeight / 2.0f);
+
+	// A slice spans 2 pi / slices radians (as does a stack), and its flat edge
+	// falls short of the true outline by radius * (1 - cos(pi / slices))
+	for (int lod = LOD_COUNT - 1; lod > 0; lod--) {
+		float error = projectedRadius * (1.0f - std::cos(glm::pi<float>() / m_lods[lod].slices));
+		if (error <= MAX_SILHOUETTE_ERROR) {
+			return lod;
 		}
 	}
-
-	return tex_coords;
-}
-
-
-/*-------------------- Generate Sphere Control Points -------------------*/
-std::vector<glm::vec3> computeNormals(const std::vector<glm::vec3>& verts) {
-	std::vector<glm::vec3> normals(verts.size());
-
-	for (size_t i = 0; i < verts.size(); i++) {
-		// Normalize the vertex position to compute the normal
-		glm::vec3 normal = glm::normalize(verts[i]);
-		normals[i] = normal;
-	}
-
-	return normals;
+	return 0;
 }
-
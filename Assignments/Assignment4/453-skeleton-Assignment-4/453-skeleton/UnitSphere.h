@@ -1,12 +1,46 @@
 #pragma once
 
+//------------------------------------------------------------------------------
+// One sphere mesh shared by everything round in the scene: radius 1, centred
+// on the origin, and scaled and placed by the model matrix.
+//
+// generateGeometry() builds it once at LOD_COUNT levels of detail, all in one
+// indexed vertex buffer. Level 0 is the finest, each level after it has half
+// the slices and stacks. lodFor() picks the level for a sphere from how big
+// it is on screen, and draw() draws it.
+//
+// Example: UnitSphere sphere;
+//          sphere.generateGeometry();
+//          sphere.draw(sphere.lodFor(earthModel, camera.getPos(), fovY, height));
+//------------------------------------------------------------------------------
+
 #include "Geometry.h"
 #include <glm/gtx/transform.hpp>
 
 struct UnitSphere {
+	static constexpr int LOD_COUNT = 4;
+
+	struct Lod {
+		int slices;				// around the y axis
+		int stacks;				// from pole to pole
+		size_t firstIndex;		// into m_indices
+		GLsizei indexCount;
+	};
+
 	CPU_Geometry m_cpu_geom;
 	GPU_Geometry m_gpu_geom;
-	glm::mat4 m_model;
-	GLsizei m_size;
-	void generateGeometry(float radius);
+	std::vector<GLuint> m_indices;
+	Lod m_lods[LOD_COUNT];
+
+	void generateGeometry();
+
+	// Binds the mesh and draws one level of detail
+	void draw(int lod);
+
+	// The coarsest level whose outline on screen strays at most
+	// MAX_SILHOUETTE_ERROR pixels (half a pixel) from the true sphere's, for
+	// a sphere placed by model (a uniform scale, rotation and translation)
+	// seen from eye with a vertical field of view of fovY. The finest level
+	// when even that is too coarse, or when eye is inside the sphere.
+	int lodFor(const glm::mat4& model, const glm::vec3& eye, float fovY, int viewportHeight) const;
 };
@@ -21,6 +21,7 @@ public:
 
 	// Public interface
 	void bind() const { glBindVertexArray(arrayID); }
+	GLuint value() const { return arrayID; }
 
 private:
 	VertexArrayHandle arrayID;
@@ -0,0 +1,503 @@
+#include "VirtualTexture.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+
+namespace {
+
+	// Same conventions as the cooked texture files: fixed size types written
+	// as is, and a version to bump whenever the layout changes
+	const char tilesMagic[4] = { 'V', 'T', '4', '5' };
+	const uint32_t tilesVersion = 1;
+
+	struct TileFileHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t components;
+		uint32_t levelCount;
+		uint32_t tileSize;
+		uint32_t tileBorder;
+	};
+
+	struct TileFileLevel {
+		uint32_t width;
+		uint32_t height;
+		uint32_t tilesX;
+		uint32_t tilesY;
+		uint64_t firstTile;
+	};
+
+	// Tiles start on a page boundary, so reading one touches as few pages as possible
+	size_t tileDataOffsetFor(size_t levelCount) {
+		const size_t pageSize = 4096;
+		size_t headerSize = sizeof(TileFileHeader) + levelCount * sizeof(TileFileLevel);
+		return (headerSize + pageSize - 1) / pageSize * pageSize;
+	}
+
+	int tilesAcross(int size) {
+		const int content = VirtualTexture::TILE_CONTENT;
+		return (size + content - 1) / content;
+	}
+
+	// The slot holding the last level is never evicted, so every tile
+	// always has something to fall back on
+	const int pinnedSlot = 0;
+
+	// Loads beyond this wait for a later frame to ask again
+	const size_t maxLoadsInFlight = 64;
+
+	GLenum pixelFormatFor(int components) {
+		return components == 4 ? GL_RGBA : GL_RGB;
+	}
+}
+
+
+VirtualTexture::VirtualTexture(const std::string& sourcePath, int slotsAcross)
+	: path(sourcePath)
+	, components(0)
+	, tileDataOffset(0)
+	, slotsAcross(slotsAcross)
+	, frame(0)
+	, pageTableHeight(0)
+	, pageTableDirty(false)
+	, running(true)
+{
+	const std::string tilesFile = tilePath(sourcePath);
+	if (!CookedTexture::isUpToDate(sourcePath, tilesFile) || !map(tilesFile)) {
+		Log::info("VIRTUAL_TEXTURE cooking tiles for {}", sourcePath);
+		if (!cook(sourcePath, tilesFile) || !map(tilesFile)) {
+			Log::error("VIRTUAL_TEXTURE couldn't cook {}", sourcePath);
+			return;
+		}
+	}
+
+	const int physicalSize = slotsAcross * TILE_SIZE;
+	const int slotCount = slotsAcross * slotsAcross;
+	stats.slotCount = static_cast<size_t>(slotCount);
+
+	glBindTexture(GL_TEXTURE_2D, physical);
+	glTexImage2D(GL_TEXTURE_2D, 0, pixelFormatFor(components), physicalSize, physicalSize, 0, pixelFormatFor(components), GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// The page table holds every level, one below the other
+	for (const Level& level : levels) {
+		pageTableHeight += level.tilesY;
+	}
+	pageEntries.assign(static_cast<size_t>(levels[0].tilesX) * pageTableHeight * 4, 0);
+
+	glBindTexture(GL_TEXTURE_2D, pageTable);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, levels[0].tilesX, pageTableHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	const size_t physicalBytes = static_cast<size_t>(physicalSize) * physicalSize * components;
+	residentBytes.set(physicalBytes + pageEntries.size());
+
+	// The last level is a single tile, loaded up front and kept for good
+	slots.resize(slotCount, { 0, 0, recent.end() });
+	for (int slot = slotCount - 1; slot > pinnedSlot; slot--) {
+		freeSlots.push_back(slot);
+	}
+	const uint32_t lastTile = tileKey(getLevelCount() - 1, 0, 0);
+	uploadTile(pinnedSlot, tileData(lastTile));
+	slots[pinnedSlot].key = lastTile;
+	resident[lastTile] = pinnedSlot;
+	stats.residentTiles = resident.size();
+	rebuildPageTable();
+
+	loader = std::thread(&VirtualTexture::loaderLoop, this);
+}
+
+
+VirtualTexture::~VirtualTexture() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	loadReady.notify_all();
+	if (loader.joinable()) {
+		loader.join();
+	}
+}
+
+
+void VirtualTexture::request(const std::vector<uint32_t>& tiles) {
+	if (!valid()) {
+		return;
+	}
+	frame++;
+
+	std::vector<uint32_t> faults;
+	for (uint32_t key : tiles) {
+		if (!validKey(key)) {
+			continue;
+		}
+
+		auto found = resident.find(key);
+		if (found != resident.end()) {
+			stats.cacheHits++;
+			Slot& slot = slots[found->second];
+			slot.lastUsed = frame;
+			if (found->second != pinnedSlot) {
+				recent.splice(recent.begin(), recent, slot.recent);
+			}
+		}
+		else if (loading.count(key) == 0 && loading.size() < maxLoadsInFlight) {
+			stats.pageFaults++;
+			loading.insert(key);
+			faults.push_back(key);
+		}
+	}
+
+	if (!faults.empty()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			loadQueue.insert(loadQueue.end(), faults.begin(), faults.end());
+		}
+		loadReady.notify_one();
+	}
+}
+
+
+void VirtualTexture::update(int uploadBudget) {
+	if (!valid()) {
+		return;
+	}
+
+	std::vector<LoadedTile> ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		while (!loaded.empty() && static_cast<int>(ready.size()) < uploadBudget) {
+			ready.push_back(std::move(loaded.front()));
+			loaded.pop_front();
+		}
+	}
+
+	for (LoadedTile& tile : ready) {
+		loading.erase(tile.key);
+		if (resident.count(tile.key) > 0) {
+			continue;
+		}
+
+		// A free slot, or the least recently used tile's. If even that was
+		// on screen this frame the cache is too small for the view, and it's
+		// better to keep what we have than to swap visible tiles around.
+		int slot;
+		if (!freeSlots.empty()) {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else if (!recent.empty() && slots[recent.back()].lastUsed < frame) {
+			slot = recent.back();
+			recent.pop_back();
+			resident.erase(slots[slot].key);
+			stats.evictions++;
+		}
+		else {
+			continue;
+		}
+
+		uploadTile(slot, tile.pixels.data());
+		recent.push_front(slot);
+		slots[slot] = { tile.key, frame, recent.begin() };
+		resident[tile.key] = slot;
+		stats.tilesUploaded++;
+		pageTableDirty = true;
+	}
+
+	stats.residentTiles = resident.size();
+	if (pageTableDirty) {
+		rebuildPageTable();
+	}
+}
+
+
+void VirtualTexture::bind(GLuint program) const {
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, pageTable);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, physical);
+	setUniforms(program);
+}
+
+
+void VirtualTexture::setUniforms(GLuint program) const {
+	// Per level: size in texels, first page table row, and tiles across
+	glm::vec4 levelUniforms[MAX_LEVELS] = {};
+	for (size_t i = 0; i < levels.size(); i++) {
+		levelUniforms[i] = glm::vec4(levels[i].width, levels[i].height, levels[i].pageRow, levels[i].tilesX);
+	}
+	glUniform4fv(glGetUniformLocation(program, "vtLevels"), MAX_LEVELS, &levelUniforms[0].x);
+	glUniform1i(glGetUniformLocation(program, "vtLevelCount"), getLevelCount());
+	glUniform1f(glGetUniformLocation(program, "vtSlotsAcross"), static_cast<float>(slotsAcross));
+	glUniform1i(glGetUniformLocation(program, "physicalTexture"), 0);
+	glUniform1i(glGetUniformLocation(program, "pageTable"), 1);
+}
+
+
+glm::ivec2 VirtualTexture::getDimensions() const {
+	return valid() ? glm::ivec2(levels[0].width, levels[0].height) : glm::ivec2(0);
+}
+
+
+bool VirtualTexture::verifyResidentTiles() const {
+	const int physicalSize = slotsAcross * TILE_SIZE;
+	std::vector<unsigned char> pixels(static_cast<size_t>(physicalSize) * physicalSize * components);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glBindTexture(GL_TEXTURE_2D, physical);
+	glGetTexImage(GL_TEXTURE_2D, 0, pixelFormatFor(components), GL_UNSIGNED_BYTE, pixels.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	const size_t rowBytes = static_cast<size_t>(TILE_SIZE) * components;
+	bool allMatch = true;
+	for (const auto& [key, slot] : resident) {
+		const unsigned char* expected = tileData(key);
+		const int slotX = slot % slotsAcross;
+		const int slotY = slot / slotsAcross;
+		for (int y = 0; y < TILE_SIZE; y++) {
+			const unsigned char* actual = pixels.data() + (static_cast<size_t>(slotY * TILE_SIZE + y) * physicalSize + slotX * TILE_SIZE) * components;
+			if (std::memcmp(actual, expected + y * rowBytes, rowBytes) != 0) {
+				Log::error("VIRTUAL_TEXTURE tile {}:{},{} in slot {} doesn't match the tile file", key >> 28, key & 0x3FFF, (key >> 14) & 0x3FFF, slot);
+				allMatch = false;
+				break;
+			}
+		}
+	}
+	return allMatch;
+}
+
+
+std::string VirtualTexture::tilePath(const std::string& sourcePath) {
+	return sourcePath + ".tiles";
+}
+
+
+bool VirtualTexture::cook(const std::string& sourcePath, const std::string& tilesPath) {
+	// The mip chain comes from the texture cooker, kept as plain pixels
+	CookedTexture cooked = CookedTexture::cook(sourcePath, 0, false);
+	if (!cooked.valid() || cooked.getComponents() < 3) {
+		return false;
+	}
+	const int components = cooked.getComponents();
+
+	// Every level down to the first that fits in one tile
+	std::vector<TileFileLevel> fileLevels;
+	uint64_t tileCount = 0;
+	for (const CookedTexture::Level& level : cooked.getLevels()) {
+		TileFileLevel fileLevel = { uint32_t(level.width), uint32_t(level.height),
+			uint32_t(tilesAcross(level.width)), uint32_t(tilesAcross(level.height)), tileCount };
+		fileLevels.push_back(fileLevel);
+		tileCount += uint64_t(fileLevel.tilesX) * fileLevel.tilesY;
+		if ((level.width <= TILE_CONTENT && level.height <= TILE_CONTENT) || fileLevels.size() == MAX_LEVELS) {
+			break;
+		}
+	}
+
+	// Written to the side and renamed into place, like the cooked textures
+	const std::string temporaryPath = tilesPath + ".tmp";
+	{
+		std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!out) {
+			return false;
+		}
+
+		TileFileHeader header;
+		std::memcpy(header.magic, tilesMagic, sizeof(tilesMagic));
+		header.version = tilesVersion;
+		header.components = uint32_t(components);
+		header.levelCount = uint32_t(fileLevels.size());
+		header.tileSize = TILE_SIZE;
+		header.tileBorder = TILE_BORDER;
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(fileLevels.data()), fileLevels.size() * sizeof(TileFileLevel));
+
+		const size_t headerSize = sizeof(TileFileHeader) + fileLevels.size() * sizeof(TileFileLevel);
+		out.write(std::vector<char>(tileDataOffsetFor(fileLevels.size()) - headerSize).data(), tileDataOffsetFor(fileLevels.size()) - headerSize);
+
+		// Each tile is its content plus a border copied from its neighbours,
+		// clamped at the edges of the level
+		std::vector<unsigned char> tile(static_cast<size_t>(TILE_SIZE) * TILE_SIZE * components);
+		for (size_t i = 0; i < fileLevels.size(); i++) {
+			const CookedTexture::Level& level = cooked.getLevels()[i];
+			const unsigned char* pixels = cooked.data() + level.offset;
+
+			for (uint32_t tileY = 0; tileY < fileLevels[i].tilesY; tileY++) {
+				for (uint32_t tileX = 0; tileX < fileLevels[i].tilesX; tileX++) {
+					for (int y = 0; y < TILE_SIZE; y++) {
+						const int sourceY = std::clamp(int(tileY) * TILE_CONTENT - TILE_BORDER + y, 0, level.height - 1);
+						for (int x = 0; x < TILE_SIZE; x++) {
+							const int sourceX = std::clamp(int(tileX) * TILE_CONTENT - TILE_BORDER + x, 0, level.width - 1);
+							std::memcpy(tile.data() + (static_cast<size_t>(y) * TILE_SIZE + x) * components,
+								pixels + (static_cast<size_t>(sourceY) * level.width + sourceX) * components, components);
+						}
+					}
+					out.write(reinterpret_cast<const char*>(tile.data()), tile.size());
+				}
+			}
+		}
+		if (!out) {
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, tilesPath, error);
+	if (error) {
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+	return true;
+}
+
+
+bool VirtualTexture::map(const std::string& tilesPath) {
+	MappedFile file = MappedFile::open(tilesPath);
+	if (!file.valid() || file.size() < sizeof(TileFileHeader)) {
+		return false;
+	}
+
+	TileFileHeader header;
+	std::memcpy(&header, file.data(), sizeof(header));
+	if (std::memcmp(header.magic, tilesMagic, sizeof(tilesMagic)) != 0 || header.version != tilesVersion
+		|| (header.components != 3 && header.components != 4) || header.levelCount < 1 || header.levelCount > MAX_LEVELS
+		|| header.tileSize != TILE_SIZE || header.tileBorder != TILE_BORDER)
+	{
+		return false;
+	}
+
+	const size_t dataOffset = tileDataOffsetFor(header.levelCount);
+	const size_t tileBytes = static_cast<size_t>(TILE_SIZE) * TILE_SIZE * header.components;
+	if (file.size() < dataOffset) {
+		return false;
+	}
+
+	// Every tile has to really be in the file before any of them is trusted
+	std::vector<Level> fileLevels;
+	uint64_t tileCount = 0;
+	int pageRow = 0;
+	for (uint32_t i = 0; i < header.levelCount; i++) {
+		TileFileLevel level;
+		std::memcpy(&level, file.data() + sizeof(TileFileHeader) + i * sizeof(TileFileLevel), sizeof(level));
+		if (level.width == 0 || level.height == 0 || level.width > (1u << 20) || level.height > (1u << 20)
+			|| level.tilesX != uint32_t(tilesAcross(level.width)) || level.tilesY != uint32_t(tilesAcross(level.height))
+			|| level.firstTile != tileCount)
+		{
+			return false;
+		}
+		fileLevels.push_back({ int(level.width), int(level.height), int(level.tilesX), int(level.tilesY), size_t(level.firstTile), pageRow });
+		tileCount += uint64_t(level.tilesX) * level.tilesY;
+		pageRow += int(level.tilesY);
+	}
+	if (fileLevels.back().tilesX != 1 || fileLevels.back().tilesY != 1 || (file.size() - dataOffset) / tileBytes < tileCount) {
+		return false;
+	}
+
+	components = int(header.components);
+	levels = std::move(fileLevels);
+	tiles = std::move(file);
+	tileDataOffset = dataOffset;
+	return true;
+}
+
+
+bool VirtualTexture::validKey(uint32_t key) const {
+	const uint32_t level = key >> 28;
+	const uint32_t y = (key >> 14) & 0x3FFF;
+	const uint32_t x = key & 0x3FFF;
+	return level < levels.size() && x < uint32_t(levels[level].tilesX) && y < uint32_t(levels[level].tilesY);
+}
+
+
+const unsigned char* VirtualTexture::tileData(uint32_t key) const {
+	const Level& level = levels[key >> 28];
+	const size_t index = level.firstTile + size_t((key >> 14) & 0x3FFF) * level.tilesX + (key & 0x3FFF);
+	return tiles.data() + tileDataOffset + index * TILE_SIZE * TILE_SIZE * components;
+}
+
+
+void VirtualTexture::uploadTile(int slot, const unsigned char* pixels) {
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glBindTexture(GL_TEXTURE_2D, physical);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % slotsAcross) * TILE_SIZE, (slot / slotsAcross) * TILE_SIZE,
+		TILE_SIZE, TILE_SIZE, pixelFormatFor(components), GL_UNSIGNED_BYTE, pixels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	RenderStats::countUpload(static_cast<size_t>(TILE_SIZE) * TILE_SIZE * components);
+}
+
+
+void VirtualTexture::rebuildPageTable() {
+	// Each tile points at its own slot if resident, otherwise at its closest
+	// resident ancestor. The shader works out ancestors the same way, from
+	// the texture coordinate at the coarser level.
+	const int tableWidth = levels[0].tilesX;
+	const int levelCount = getLevelCount();
+	for (int level = 0; level < levelCount; level++) {
+		for (int y = 0; y < levels[level].tilesY; y++) {
+			for (int x = 0; x < levels[level].tilesX; x++) {
+				int slot = pinnedSlot;
+				int mappedLevel = levelCount - 1;
+				for (int ancestor = level; ancestor < levelCount; ancestor++) {
+					const int shift = ancestor - level;
+					const int ancestorX = std::min(x >> shift, levels[ancestor].tilesX - 1);
+					const int ancestorY = std::min(y >> shift, levels[ancestor].tilesY - 1);
+					auto found = resident.find(tileKey(ancestor, ancestorX, ancestorY));
+					if (found != resident.end()) {
+						slot = found->second;
+						mappedLevel = ancestor;
+						break;
+					}
+				}
+
+				unsigned char* entry = pageEntries.data() + (static_cast<size_t>(levels[level].pageRow + y) * tableWidth + x) * 4;
+				entry[0] = static_cast<unsigned char>(slot % slotsAcross);
+				entry[1] = static_cast<unsigned char>(slot / slotsAcross);
+				entry[2] = static_cast<unsigned char>(mappedLevel);
+				entry[3] = 255;
+			}
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, pageTable);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tableWidth, pageTableHeight, GL_RGBA, GL_UNSIGNED_BYTE, pageEntries.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+	RenderStats::countUpload(pageEntries.size());
+	pageTableDirty = false;
+}
+
+
+void VirtualTexture::loaderLoop() {
+	const size_t tileBytes = static_cast<size_t>(TILE_SIZE) * TILE_SIZE * components;
+	while (true) {
+		uint32_t key;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			loadReady.wait(lock, [this] { return !loadQueue.empty() || !running; });
+			if (!running) {
+				return;
+			}
+			key = loadQueue.front();
+			loadQueue.pop_front();
+		}
+
+		// Copying out of the mapping is what pulls the tile in from disk,
+		// so it happens here rather than on the GL thread
+		const unsigned char* source = tileData(key);
+		LoadedTile tile = { key, std::vector<unsigned char>(source, source + tileBytes) };
+
+		std::lock_guard<std::mutex> lock(mutex);
+		loaded.push_back(std::move(tile));
+	}
+}
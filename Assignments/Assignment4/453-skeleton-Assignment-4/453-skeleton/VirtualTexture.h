@@ -0,0 +1,168 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A virtual texture: a texture far larger than what is kept on the GPU.
+//
+// The source image and its mip levels are cut into 128x128 tiles (120 texels
+// of content plus a 4 texel border for filtering) and cooked into
+// <source>.tiles. Only the tiles that are actually on screen get uploaded,
+// into slots of one physical texture, with a page table texture telling the
+// shader which slot holds which tile. A tile that isn't resident yet is drawn
+// from the closest coarser level that is, down to the last level, which
+// always is.
+//
+// Which tiles are on screen comes from a feedback pass (see
+// VirtualTextureFeedback). Missing tiles are read from the memory mapped tile
+// file on a background thread, and update() uploads them between frames,
+// evicting whichever resident tile has gone unused the longest.
+//
+// Example: VirtualTexture earth("textures/16k_earth_daymap.jpg");
+//          earth.request(feedback.getRequests(1));
+//          earth.update();
+//          earth.bind(shader);
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "RenderStats.h"
+#include "TextureCache.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+
+class VirtualTexture {
+
+public:
+	static constexpr int TILE_SIZE = 128;
+	static constexpr int TILE_BORDER = 4;
+	static constexpr int TILE_CONTENT = TILE_SIZE - 2 * TILE_BORDER;
+	static constexpr int MAX_LEVELS = 16;
+
+	struct Stats {
+		uint64_t pageFaults = 0;		// tile requests that weren't resident, and started a load
+		uint64_t cacheHits = 0;			// tile requests that were already resident
+		uint64_t evictions = 0;
+		uint64_t tilesUploaded = 0;
+		size_t residentTiles = 0;
+		size_t slotCount = 0;
+	};
+
+	// Cooks the tiles if they are missing or older than sourcePath. The
+	// physical texture holds slotsAcross x slotsAcross tiles.
+	explicit VirtualTexture(const std::string& sourcePath, int slotsAcross = 16);
+	~VirtualTexture();
+
+	VirtualTexture(const VirtualTexture&) = delete;
+	VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+	// False if the source couldn't be read
+	bool valid() const { return !levels.empty(); }
+
+	// Tiles seen on screen this frame, as made by tileKey(). Resident tiles
+	// are marked as used, missing ones start loading.
+	void request(const std::vector<uint32_t>& tiles);
+
+	// GL thread: uploads up to uploadBudget loaded tiles and brings the page
+	// table up to date
+	void update(int uploadBudget = 16);
+
+	// Binds the physical texture to unit 0 and the page table to unit 1 and
+	// sets the vt* uniforms of the currently used program
+	void bind(GLuint program) const;
+
+	// Sets only the uniforms, for the feedback pass, or after binding the
+	// textures some other way
+	void setUniforms(GLuint program) const;
+	GLuint getPhysicalTexture() const { return physical; }
+	GLuint getPageTable() const { return pageTable; }
+
+	const Stats& getStats() const { return stats; }
+	glm::ivec2 getDimensions() const;
+	int getLevelCount() const { return static_cast<int>(levels.size()); }
+
+	// GL thread: reads the physical texture back and compares every
+	// resident tile against the tile file. For testing.
+	bool verifyResidentTiles() const;
+
+	static uint32_t tileKey(int level, int x, int y) {
+		return (uint32_t(level) << 28) | (uint32_t(y) << 14) | uint32_t(x);
+	}
+
+private:
+	struct Level {
+		int width;
+		int height;
+		int tilesX;
+		int tilesY;
+		size_t firstTile;		// index of this level's first tile in the file
+		int pageRow;			// first row of this level in the page table
+	};
+
+	struct Slot {
+		uint32_t key;
+		uint64_t lastUsed;		// frame it was last requested
+		std::list<int>::iterator recent;
+	};
+
+	struct LoadedTile {
+		uint32_t key;
+		std::vector<unsigned char> pixels;
+	};
+
+	std::string path;
+	int components;
+	std::vector<Level> levels;
+	MappedFile tiles;
+	size_t tileDataOffset;
+
+	// The physical texture, its slots, and which tile is in which slot.
+	// recent is ordered from most to least recently used.
+	TextureHandle physical;
+	int slotsAcross;
+	std::vector<Slot> slots;
+	std::vector<int> freeSlots;
+	std::list<int> recent;
+	std::unordered_map<uint32_t, int> resident;
+	uint64_t frame;
+	RenderStats::TextureBytes residentBytes;
+
+	// One RGBA8 texel per tile of every level: slot x, slot y, and the level
+	// actually resident for it
+	TextureHandle pageTable;
+	std::vector<unsigned char> pageEntries;
+	int pageTableHeight;
+	bool pageTableDirty;
+
+	// Loads run on one background thread. loading is only touched on the
+	// GL thread, everything behind mutex is shared with the loader.
+	std::unordered_set<uint32_t> loading;
+	std::thread loader;
+	bool running;
+	std::mutex mutex;
+	std::condition_variable loadReady;
+	std::deque<uint32_t> loadQueue;
+	std::deque<LoadedTile> loaded;
+
+	Stats stats;
+
+	static std::string tilePath(const std::string& sourcePath);
+	static bool cook(const std::string& sourcePath, const std::string& tilesPath);
+	bool map(const std::string& tilesPath);
+
+	bool validKey(uint32_t key) const;
+	const unsigned char* tileData(uint32_t key) const;
+	void uploadTile(int slot, const unsigned char* pixels);
+	void rebuildPageTable();
+	void loaderLoop();
+};
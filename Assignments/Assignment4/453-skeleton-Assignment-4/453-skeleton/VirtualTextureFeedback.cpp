@@ -0,0 +1,125 @@
+#include "VirtualTextureFeedback.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+VirtualTextureFeedback::VirtualTextureFeedback(int downscale)
+	: downscale(std::max(1, downscale))
+	, size(0, 0)
+	, shader("shaders/test.vert", "shaders/feedback.frag")
+	, readbackPending{ false, false }
+	, writeIndex(0)
+{}
+
+
+void VirtualTextureFeedback::begin(glm::ivec2 windowSize) {
+	glm::ivec2 feedbackSize = glm::max(windowSize / downscale, glm::ivec2(1));
+	if (feedbackSize != size) {
+		resize(feedbackSize);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, size.x, size.y);
+
+	// Zero means no virtual texture
+	const GLuint clearColor[4] = { 0, 0, 0, 0 };
+	glClearBufferuiv(GL_COLOR, 0, clearColor);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	shader.use();
+
+	// The derivatives are downscale times bigger down here than on screen,
+	// which would ask for a level log2(downscale) too coarse
+	glUniform1f(glGetUniformLocation(shader, "vtLodBias"), -std::log2(static_cast<float>(downscale)));
+}
+
+
+void VirtualTextureFeedback::setTexture(int id, const VirtualTexture* texture) {
+	glUniform1ui(glGetUniformLocation(shader, "vtId"), static_cast<GLuint>(id));
+	if (texture != nullptr) {
+		texture->setUniforms(shader);
+	}
+}
+
+
+void VirtualTextureFeedback::end(glm::ivec2 windowSize) {
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback[writeIndex]);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glReadPixels(0, 0, size.x, size.y, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	readbackPending[writeIndex] = true;
+
+	// Last frame's readback has had a whole frame to finish by now
+	writeIndex = 1 - writeIndex;
+	if (readbackPending[writeIndex]) {
+		collect(writeIndex);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, windowSize.x, windowSize.y);
+}
+
+
+const std::vector<uint32_t>& VirtualTextureFeedback::getRequests(int id) const {
+	static const std::vector<uint32_t> none;
+	return id >= 0 && id < static_cast<int>(requests.size()) ? requests[id] : none;
+}
+
+
+void VirtualTextureFeedback::resize(glm::ivec2 newSize) {
+	size = newSize;
+
+	glBindRenderbuffer(GL_RENDERBUFFER, color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA16UI, size.x, size.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.x, size.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// Four 16 bit channels per pixel. Anything in flight was for the old size.
+	for (int i = 0; i < 2; i++) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size.x) * size.y * 4 * sizeof(uint16_t), nullptr, GL_STREAM_READ);
+		readbackPending[i] = false;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+
+void VirtualTextureFeedback::collect(int index) {
+	readbackPending[index] = false;
+	for (std::vector<uint32_t>& tiles : requests) {
+		tiles.clear();
+	}
+
+	const size_t pixelCount = static_cast<size_t>(size.x) * size.y;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback[index]);
+	const uint16_t* pixels = static_cast<const uint16_t*>(
+		glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pixelCount * 4 * sizeof(uint16_t), GL_MAP_READ_BIT));
+	if (pixels != nullptr) {
+		// Each pixel is tile x, tile y, level, texture id
+		for (size_t i = 0; i < pixelCount; i++) {
+			const uint16_t* pixel = pixels + i * 4;
+			const int id = pixel[3];
+			if (id == 0) {
+				continue;
+			}
+			if (id >= static_cast<int>(requests.size())) {
+				requests.resize(id + 1);
+			}
+			requests[id].push_back(VirtualTexture::tileKey(pixel[2], pixel[0], pixel[1]));
+		}
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	for (std::vector<uint32_t>& tiles : requests) {
+		std::sort(tiles.begin(), tiles.end());
+		tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// The feedback pass for virtual textures.
+//
+// Draws the scene again into a small integer framebuffer, where each pixel
+// records which tile, at which mip level, of which virtual texture it would
+// sample. The buffer is read back through a pair of pixel buffers, so the
+// results arrive a frame late instead of stalling the pipeline.
+//
+// Example: feedback.begin(window.getSize());
+//          feedback.setTexture(1, &earth);
+//          ... draw the earth with feedback.getShader() ...
+//          feedback.end(window.getSize());
+//          earth.request(feedback.getRequests(1));
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "ShaderProgram.h"
+#include "VirtualTexture.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+
+class VirtualTextureFeedback {
+
+public:
+	// The feedback buffer is the window size divided by downscale
+	explicit VirtualTextureFeedback(int downscale = 8);
+
+	// Binds the feedback framebuffer and program. Everything drawn from
+	// here to end() should use getShader().
+	void begin(glm::ivec2 windowSize);
+
+	// Call before drawing each object: id (from 1) and texture for objects
+	// with a virtual texture, or 0 and nullptr for ones that only hide others
+	void setTexture(int id, const VirtualTexture* texture);
+
+	// Starts reading this frame back, collects the previous frame's requests
+	// and returns to the default framebuffer
+	void end(glm::ivec2 windowSize);
+
+	ShaderProgram& getShader() { return shader; }
+
+	// Tiles seen for virtual texture id in the latest readback, without repeats
+	const std::vector<uint32_t>& getRequests(int id) const;
+
+private:
+	int downscale;
+	glm::ivec2 size;
+
+	ShaderProgram shader;
+	FramebufferHandle framebuffer;
+	RenderbufferHandle color;
+	RenderbufferHandle depth;
+
+	// Ping-ponged: one is being written this frame, the other read
+	VertexBufferHandle readback[2];
+	bool readbackPending[2];
+	int writeIndex;
+
+	std::vector<std::vector<uint32_t>> requests;
+
+	void resize(glm::ivec2 newSize);
+	void collect(int index);
+};
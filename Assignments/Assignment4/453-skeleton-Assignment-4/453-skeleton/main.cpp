@@ -2,25 +2,43 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <list>
 #include <vector>
 #include <limits>
 #include <functional>
+#include <chrono>
 
+#include "Benchmark.h"
 #include "Geometry.h"
 #include "GLDebug.h"
+#include "GLStateCache.h"
 #include "Log.h"
+#include "RenderQueue.h"
+#include "RenderStats.h"
+#include "SceneGraph.h"
 #include "ShaderProgram.h"
 #include "Shader.h"
+#include "StatsOverlay.h"
 #include "Texture.h"
+#include "TextureLoader.h"
+#include "VirtualTexture.h"
+#include "VirtualTextureFeedback.h"
 #include "Window.h"
 #include "Camera.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
+#include "imgui/imgui.h"
+#include "imgui/imgui_impl_glfw.h"
+#include "imgui/imgui_impl_opengl3.h"
+
+#include <argh.h>
+
 #include "UnitCube.h"
 #include "UnitSphere.h"
 
@@ -30,13 +48,18 @@ class Assignment4 : public CallbackInterface {
 public:
 	Assignment4()
 		: camera(glm::radians(45.f), glm::radians(45.f), 3.0)
+		, paused(false)
 		, aspect(1.0f)
 		, rightMouseDown(false)
 		, mouseOldX(0.0)
 		, mouseOldY(0.0)
 	{}
 
-	virtual void keyCallback(int key, int scancode, int action, int mods) {}
+	virtual void keyCallback(int key, int scancode, int action, int mods) {
+		if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) {
+			paused = !paused;
+		}
+	}
 	virtual void mouseButtonCallback(int button, int action, int mods) {
 		if (button == GLFW_MOUSE_BUTTON_RIGHT) {
 			if (action == GLFW_PRESS)			rightMouseDown = true;
@@ -75,6 +98,7 @@ public:
 		glUniformMatrix4fv(uniMat, 1, GL_FALSE, glm::value_ptr(P));
 	}
 	Camera camera;
+	bool paused;	// stops the orbits
 private:
 	bool rightMouseDown;
 	float aspect;
@@ -82,11 +106,33 @@ private:
 	double mouseOldY;
 };
 
-int main() {
+int main(int argc, char** argv) {
 	Log::debug("Starting main");
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	auto millisecondsSinceStart = [startTime] {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	};
+
+	argh::parser cmdl(argc, argv);
+
+	// Headless benchmarks, e.g. --bench=texture-compression
+	std::string benchmark;
+	if (cmdl("bench") >> benchmark) {
+		return Benchmark::run(benchmark) ? 0 : 1;
+	}
+
+	// --vt-check flies the camera in towards the earth by itself, streaming
+	// virtual textures into a deliberately small cache, then checks every
+	// resident tile against its tile file. It opens a hidden window and works
+	// under Mesa's software renderer (LIBGL_ALWAYS_SOFTWARE=1) too.
+	const bool vtCheck = cmdl["vt-check"];
+	const int vtCheckFrames = 300;
 
 	// WINDOW
 	glfwInit();
+	if (vtCheck) {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
 	Window window(800, 800, "CPSC 453 - Assignment 3");
 
 	GLDebug::enable();
@@ -100,76 +146,290 @@ int main() {
 	UnitCube cube;
 	cube.generateGeometry();
 
-	UnitSphere earth;
-	earth.generateGeometry(1.0f);
+	// One sphere for the earth, moon, stars and sun, sized by their model
+	// matrices, at a level of detail to suit how big each is on screen
+	UnitSphere sphere;
+	sphere.generateGeometry();
+
+	// TEXTURES
+	// Decoded in the background and uploaded between frames, showing a grey
+	// placeholder until then. --pbo uploads through a pixel buffer object,
+	// --sync-textures waits for all of them before the first frame instead,
+	// --uncompressed-textures skips block compression.
+	// --earth and --moon swap in other (larger) maps
+	const std::string earthPath = cmdl("earth", "textures/2k_earth_daymap.jpg").str();
+	const std::string moonPath = cmdl("moon", "textures/2k_moon.jpg").str();
 
-	UnitSphere moon;
-	moon.generateGeometry(0.50f);
+	Texture earthTex(GL_NEAREST);
+	Texture startsTex(GL_NEAREST);
+	Texture sunTex(GL_NEAREST);
+	Texture moonTex(GL_NEAREST);
 
-	UnitSphere stars;
-	stars.generateGeometry(50.0f);
+	TextureLoader textureLoader(0, cmdl["pbo"], !cmdl["uncompressed-textures"]);
+	textureLoader.load(startsTex, "textures/2k_stars.jpg");
+	textureLoader.load(sunTex, "textures/2k_sun.jpg");
+	bool firstFrame = true;
+	bool texturesLoaded = false;
 
-	UnitSphere sun;
-	sun.generateGeometry(3.0f);
+	// VIRTUAL TEXTURES
+	// --virtual-texture streams the earth and moon in tiles instead, so only
+	// what is on screen takes up GPU memory. --vt-slots=N sets the cache to
+	// N x N tiles.
+	const bool useVirtualTextures = vtCheck || cmdl["virtual-texture"];
+	int vtSlots = vtCheck ? 4 : 16;
+	cmdl("vt-slots", vtSlots) >> vtSlots;
+
+	std::unique_ptr<VirtualTexture> earthVirtual;
+	std::unique_ptr<VirtualTexture> moonVirtual;
+	std::unique_ptr<VirtualTextureFeedback> feedback;
+	std::unique_ptr<ShaderProgram> virtualShader;
+	if (useVirtualTextures) {
+		earthVirtual = std::make_unique<VirtualTexture>(earthPath, vtSlots);
+		moonVirtual = std::make_unique<VirtualTexture>(moonPath, vtSlots);
+		feedback = std::make_unique<VirtualTextureFeedback>();
+		virtualShader = std::make_unique<ShaderProgram>("shaders/test.vert", "shaders/virtual.frag");
+	}
+	else {
+		textureLoader.load(earthTex, earthPath);
+		textureLoader.load(moonTex, moonPath);
+	}
+	if (cmdl["sync-textures"]) {
+		textureLoader.finish();
+	}
+	if (vtCheck) {
+		a4->camera = Camera(glm::radians(20.0f), glm::radians(90.0f), 40.0f);
+	}
+	int frameCount = 0;
 
-	Texture earthTex("textures/2k_earth_daymap.jpg", GL_NEAREST);
-	Texture startsTex("textures/2k_stars.jpg", GL_NEAREST);
-	Texture sunTex("textures/2k_sun.jpg", GL_NEAREST);
-	Texture moonTex("textures/2k_moon.jpg", GL_NEAREST);
+	// SCENE
+	// The sun, earth and moon orbit through a scene graph. Each frame only the
+	// orbit and spin transforms change, and the graph brings the world
+	// matrices under them up to date. --orbit-speed=X speeds them up or slows
+	// them down, space pauses them.
+	float orbitSpeed = vtCheck ? 0.0f : 1.0f;
+	cmdl("orbit-speed", orbitSpeed) >> orbitSpeed;
+	float orbitTime = 0.0f;
 
+	SceneGraph scene;
+	const SceneGraph::Node sunNode = scene.addNode(SceneGraph::NONE, glm::scale(glm::mat4(1.0f), glm::vec3(3.0f)));
+	const SceneGraph::Node earthOrbitNode = scene.addNode(SceneGraph::NONE);
+	const SceneGraph::Node earthNode = scene.addNode(earthOrbitNode);
+	const SceneGraph::Node moonOrbitNode = scene.addNode(earthOrbitNode);
+	const SceneGraph::Node moonNode = scene.addNode(moonOrbitNode, glm::scale(glm::mat4(1.0f), glm::vec3(0.5f)));
+	const SceneGraph::Node starsNode = scene.addNode(SceneGraph::NONE, glm::scale(glm::mat4(1.0f), glm::vec3(50.0f)));
+
+	// Radians per second at orbit speed 1. The moon keeps the same face
+	// towards the earth, so it turns with its orbit and needs no spin of its own.
+	const glm::vec3 yAxis(0.0f, 1.0f, 0.0f);
+	const float sunSpin = 0.05f;
+	const float earthOrbit = 0.1f;
+	const float earthSpin = 0.5f;
+	const float moonOrbit = 0.6f;
+	auto orbit = [&](float angle, const glm::vec3& offset) {
+		return glm::translate(glm::rotate(glm::mat4(1.0f), angle, yAxis), offset);
+	};
+	std::chrono::steady_clock::time_point lastFrameTime = std::chrono::steady_clock::now();
+
+	// RENDERING
+	// Draws are queued, sorted to keep state changes down, and issued through
+	// a cache that skips the GL calls which wouldn't change anything
+	RenderQueue renderQueue;
+	GLStateCache glState;
+
+	// PERFORMANCE STATS
+	// --stats shows the overlay, --stats-csv=FILE writes every frame to FILE
+	const bool showStats = cmdl["stats"];
+	RenderStats::Recorder renderStats;
+	std::string statsCsvPath = cmdl("stats-csv").str();
+	if (!statsCsvPath.empty() && !renderStats.openCsv(statsCsvPath)) {
+		Log::error("STATS could not write {}", statsCsvPath);
+	}
 
 	// RENDER LOOP
 	while (!window.shouldClose()) {
 		glfwPollEvents();
+		renderStats.beginFrame();
 
-		glEnable(GL_LINE_SMOOTH);
-		glEnable(GL_FRAMEBUFFER_SRGB);
-		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glEnable(GL_DEPTH_TEST);
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL /*GL_LINE*/);
+		textureLoader.update();
+		if (!texturesLoaded && textureLoader.pending() == 0) {
+			texturesLoaded = true;
+			Log::info("TEXTURE_LOADER all textures loaded after {:.1f} ms", millisecondsSinceStart());
+		}
+
+		// Orbits
+		const std::chrono::steady_clock::time_point frameTime = std::chrono::steady_clock::now();
+		if (!a4->paused) {
+			orbitTime += orbitSpeed * std::chrono::duration<float>(frameTime - lastFrameTime).count();
+		}
+		lastFrameTime = frameTime;
+
+		scene.setLocal(sunNode, glm::scale(glm::rotate(glm::mat4(1.0f), sunSpin * orbitTime, yAxis), glm::vec3(3.0f)));
+		scene.setLocal(earthOrbitNode, orbit(earthOrbit * orbitTime, glm::vec3(5.0f, 0.0f, 0.0f)));
+		scene.setLocal(earthNode, glm::rotate(glm::mat4(1.0f), earthSpin * orbitTime, yAxis));
+		scene.setLocal(moonOrbitNode, orbit(moonOrbit * orbitTime, glm::vec3(2.0f, 0.5f, 0.0f)));
+		scene.update();
+
+		// Model matrices
+		const glm::mat4& sunModel = scene.getWorld(sunNode);
+		const glm::mat4& earthModel = scene.getWorld(earthNode);
+		const glm::mat4& moonModel = scene.getWorld(moonNode);
+		const glm::mat4& starsModel = scene.getWorld(starsNode);
+
+		if (vtCheck) {
+			a4->camera.incrementR(0.11f);
+			a4->camera.incrementPhi(0.1f);
+		}
+
+		// Level of detail for each sphere, matching the 45 degree field of view in viewPipeline
+		const glm::vec3 eye = a4->camera.getPos();
+		auto lodFor = [&](const glm::mat4& model) {
+			return sphere.lodFor(model, eye, glm::radians(45.0f), window.getHeight());
+		};
+		const int sunLod = lodFor(sunModel);
+		const int earthLod = lodFor(earthModel);
+		const int moonLod = lodFor(moonModel);
+		const int starsLod = lodFor(starsModel);
 
-		shader.use();
+		// Virtual texture feedback: which tiles the earth and moon need. The
+		// sun is drawn too, with no texture, because it can hide them.
+		if (useVirtualTextures) {
+			glState.setEnabled(GL_DEPTH_TEST, true);
+			feedback->begin(window.getSize());
+			ShaderProgram& feedbackShader = feedback->getShader();
+			a4->viewPipeline(feedbackShader);
+			GLint feedbackModel = glGetUniformLocation(feedbackShader, "M");
 
+			feedback->setTexture(0, nullptr);
+			glUniformMatrix4fv(feedbackModel, 1, GL_FALSE, glm::value_ptr(sunModel));
+			sphere.draw(sunLod);
+			RenderStats::countDrawCall();
+
+			feedback->setTexture(1, earthVirtual.get());
+			glUniformMatrix4fv(feedbackModel, 1, GL_FALSE, glm::value_ptr(earthModel));
+			sphere.draw(earthLod);
+			RenderStats::countDrawCall();
+
+			feedback->setTexture(2, moonVirtual.get());
+			glUniformMatrix4fv(feedbackModel, 1, GL_FALSE, glm::value_ptr(moonModel));
+			sphere.draw(moonLod);
+			RenderStats::countDrawCall();
+
+			feedback->end(window.getSize());
+
+			earthVirtual->request(feedback->getRequests(1));
+			earthVirtual->update();
+			moonVirtual->request(feedback->getRequests(2));
+			moonVirtual->update();
+		}
+
+		// Everything above binds textures and programs without the state cache knowing
+		glState.invalidateBindings();
+
+		glState.setEnabled(GL_LINE_SMOOTH, true);
+		glState.setEnabled(GL_FRAMEBUFFER_SRGB, true);
+		glState.clearColor(glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glState.setEnabled(GL_DEPTH_TEST, true);
+		glState.polygonMode(GL_FILL /*GL_LINE*/);
+
+		// View and projection for every program the queue will use
+		glState.useProgram(shader);
 		a4->viewPipeline(shader);
+		if (useVirtualTextures) {
+			glState.useProgram(*virtualShader);
+			a4->viewPipeline(*virtualShader);
+		}
 
 		//cube.m_gpu_geom.bind();
 		//glDrawArrays(GL_TRIANGLES, 0, GLsizei(cube.m_size));
 
-		// Model matrices
-		GLint uniMat = glGetUniformLocation(shader, "M");
-		glm::mat4 earthModel = glm::translate(glm::mat4(1.0f), glm::vec3(5.0f, 0.0f, 0.0f));  
-		glm::mat4 moonModel = glm::translate(glm::mat4(1.0f), glm::vec3(7.0f, 0.50f, 0.0f));  
-
-		// Sun--------------------------------
-		sun.m_gpu_geom.bind();
-		sunTex.bind();
-		glDrawArrays(GL_TRIANGLES, 0, GLsizei(sun.m_size));
-		sunTex.unbind();
-
-		// Earth--------------------------------
-		earth.m_gpu_geom.bind();
-		earthTex.bind();
-		glUniformMatrix4fv(uniMat, 1, GL_FALSE, glm::value_ptr(earthModel));
-		glDrawArrays(GL_TRIANGLES, 0, GLsizei(earth.m_size));
-		earthTex.unbind();
-
-		// Moon--------------------------------
-		moon.m_gpu_geom.bind();
-		moonTex.bind();
-		glUniformMatrix4fv(uniMat, 1, GL_FALSE, glm::value_ptr(moonModel));
-		glDrawArrays(GL_TRIANGLES, 0, GLsizei(moon.m_size));
-		moonTex.unbind();
-
-		// Stars--------------------------------
-		stars.m_gpu_geom.bind();
-		startsTex.bind();
-		glDrawArrays(GL_TRIANGLES, 0, GLsizei(stars.m_size));
-		startsTex.unbind();
-
-		glDisable(GL_FRAMEBUFFER_SRGB); // disable sRGB for things like imgui
+		// Spheres go into the render queue, nearest surface first
+		auto submitSphere = [&](GLuint program, GLuint texture, const VirtualTexture* virtualTexture, const glm::mat4& model, int lod) {
+			const UnitSphere::Lod& level = sphere.m_lods[lod];
+			RenderQueue::Draw draw;
+			draw.program = program;
+			draw.textures[0] = virtualTexture ? virtualTexture->getPhysicalTexture() : texture;
+			draw.textures[1] = virtualTexture ? virtualTexture->getPageTable() : 0;
+			draw.virtualTexture = virtualTexture;
+			draw.mesh = { sphere.m_gpu_geom.getVertexArray(), level.firstIndex, level.indexCount };
+			draw.model = model;
+			draw.depth = std::abs(glm::length(glm::vec3(model[3]) - eye) - glm::length(glm::vec3(model[0])));
+			renderQueue.submit(draw);
+		};
+
+		renderQueue.clear();
+		submitSphere(shader, sunTex.getId(), nullptr, sunModel, sunLod);
+		if (useVirtualTextures) {
+			submitSphere(*virtualShader, 0, earthVirtual.get(), earthModel, earthLod);
+			submitSphere(*virtualShader, 0, moonVirtual.get(), moonModel, moonLod);
+		}
+		else {
+			submitSphere(shader, earthTex.getId(), nullptr, earthModel, earthLod);
+			submitSphere(shader, moonTex.getId(), nullptr, moonModel, moonLod);
+		}
+		submitSphere(shader, startsTex.getId(), nullptr, starsModel, starsLod);
+		renderQueue.execute(glState);
+
+		glState.setEnabled(GL_FRAMEBUFFER_SRGB, false); // disable sRGB for things like imgui
+
+		if (showStats) {
+			ImGui_ImplOpenGL3_NewFrame();
+			ImGui_ImplGlfw_NewFrame();
+			ImGui::NewFrame();
+			StatsOverlay::draw(renderStats, static_cast<float>(window.getWidth()));
+			if (useVirtualTextures) {
+				ImGui::Begin("Virtual textures", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+				for (const VirtualTexture* texture : { earthVirtual.get(), moonVirtual.get() }) {
+					const VirtualTexture::Stats& vt = texture->getStats();
+					ImGui::Text("%dx%d: %zu / %zu tiles resident", texture->getDimensions().x, texture->getDimensions().y, vt.residentTiles, vt.slotCount);
+					ImGui::Text("  %llu page faults, %llu cache hits, %llu evictions",
+						(unsigned long long)vt.pageFaults, (unsigned long long)vt.cacheHits, (unsigned long long)vt.evictions);
+				}
+				ImGui::End();
+			}
+			ImGui::Render();
+			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		}
+
+		renderStats.endFrame();
 		window.swapBuffers();
+
+		if (firstFrame) {
+			firstFrame = false;
+			Log::info("TEXTURE_LOADER first frame after {:.1f} ms", millisecondsSinceStart());
+		}
+
+		if (vtCheck && ++frameCount == vtCheckFrames) {
+			break;
+		}
+	}
+
+	int exitCode = 0;
+	if (vtCheck) {
+		for (const VirtualTexture* texture : { earthVirtual.get(), moonVirtual.get() }) {
+			const VirtualTexture::Stats& vt = texture->getStats();
+			bool matched = texture->valid() && texture->verifyResidentTiles();
+			Log::info("VT_CHECK {}x{}, {} levels: {} page faults, {} cache hits ({:.1f}%), {} evictions, {} / {} tiles resident, {}",
+				texture->getDimensions().x, texture->getDimensions().y, texture->getLevelCount(),
+				vt.pageFaults, vt.cacheHits, 100.0 * vt.cacheHits / std::max<uint64_t>(1, vt.cacheHits + vt.pageFaults),
+				vt.evictions, vt.residentTiles, vt.slotCount, matched ? "tiles match" : "MISMATCH");
+			if (!matched) {
+				exitCode = 1;
+			}
+		}
 	}
+
+	// ImGui cleanup
+	ImGui_ImplOpenGL3_Shutdown();
+	ImGui_ImplGlfw_Shutdown();
+	ImGui::DestroyContext();
+
+	// Before the context goes away
+	earthVirtual.reset();
+	moonVirtual.reset();
+	feedback.reset();
+	virtualShader.reset();
+
 	glfwTerminate();
-	return 0;
+	return exitCode;
 }
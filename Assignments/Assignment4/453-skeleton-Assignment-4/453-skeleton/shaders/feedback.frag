@@ -0,0 +1,31 @@
+#version 330 core
+
+in vec2 tc;
+
+// Same layout as in virtual.frag. vtId is zero for objects without a
+// virtual texture, which only get drawn so they hide what's behind them.
+uniform vec4 vtLevels[16];
+uniform int vtLevelCount;
+uniform float vtLodBias;
+uniform uint vtId;
+
+const float TILE_CONTENT = 120.0;
+
+out uvec4 feedback;
+
+int desiredLevel(vec2 uv, float lodBias) {
+	vec2 texel = uv * vtLevels[0].xy;
+	float footprint = max(length(dFdx(texel)), length(dFdy(texel)));
+	float lod = log2(max(footprint, 1e-6)) + lodBias;
+	return clamp(int(floor(lod + 0.5)), 0, max(vtLevelCount - 1, 0));
+}
+
+void main() {
+	vec2 uv = clamp(tc, 0.0, 1.0);
+	int level = desiredLevel(uv, vtLodBias);
+	vec4 desired = vtLevels[level];
+	vec2 tile = min(floor(uv * desired.xy / TILE_CONTENT), ceil(desired.xy / TILE_CONTENT) - 1.0);
+
+	// Tile x, tile y, level, which texture
+	feedback = uvec4(uvec2(tile), uint(level), vtId);
+}
@@ -0,0 +1,55 @@
+#version 330 core
+
+in vec3 fragPos;
+in vec3 fragColor;
+in vec3 n;
+
+in vec2 tc;
+
+// A virtual texture, see VirtualTexture.h. vtLevels holds, per mip level,
+// its size in texels, its first row in the page table and its tiles across.
+uniform sampler2D physicalTexture;
+uniform sampler2D pageTable;
+uniform vec4 vtLevels[16];
+uniform int vtLevelCount;
+uniform float vtSlotsAcross;
+
+const float TILE_SIZE = 128.0;
+const float TILE_BORDER = 4.0;
+const float TILE_CONTENT = 120.0;
+
+out vec4 color;
+
+// The mip level the hardware would have picked, from how many texels a pixel covers
+int desiredLevel(vec2 uv, float lodBias) {
+	vec2 texel = uv * vtLevels[0].xy;
+	float footprint = max(length(dFdx(texel)), length(dFdy(texel)));
+	float lod = log2(max(footprint, 1e-6)) + lodBias;
+	return clamp(int(floor(lod + 0.5)), 0, vtLevelCount - 1);
+}
+
+vec2 tileAt(vec2 uv, vec4 level) {
+	return min(floor(uv * level.xy / TILE_CONTENT), ceil(level.xy / TILE_CONTENT) - 1.0);
+}
+
+vec4 sampleVirtual(vec2 uv, int level) {
+	vec4 desired = vtLevels[level];
+	vec2 tile = tileAt(uv, desired);
+	vec4 entry = texelFetch(pageTable, ivec2(tile.x, desired.z + tile.y), 0) * 255.0;
+
+	// The tile itself or, until it arrives, the closest coarser one
+	vec4 mapped = vtLevels[int(entry.b + 0.5)];
+	vec2 inTile = uv * mapped.xy - tileAt(uv, mapped) * TILE_CONTENT;
+	vec2 slot = floor(entry.rg + 0.5);
+	return textureLod(physicalTexture, (slot * TILE_SIZE + TILE_BORDER + inTile) / (vtSlotsAcross * TILE_SIZE), 0.0);
+}
+
+void main() {
+	vec2 uv = clamp(tc, 0.0, 1.0);
+	vec4 d = sampleVirtual(uv, desiredLevel(uv, 0.0));
+
+	if(d.a < 0.01)
+		discard; // If the texture is transparent, don't draw the fragment
+
+	color = d;
+}